@@ -112,11 +112,12 @@ if __name__ == "__main__":
     while time_s < end_time_s:
         # get the joint state (infer from cylinder DObject state)
         # NOTE: The state vector for a prismatic joint ABA RigidBody consists of the joint velocity at index 0 followed by the joint position at index 1.
-        joint_state_vec = ProteusDSAPI.GetDoubleArray(
+        # NOTE: Passing the preallocated joint_state_vec (rather than a size) fills it in place, so no new list/array is created each step.
+        ProteusDSAPI.GetDoubleArray(
             "Sim1",
             ProteusDSAPI.PDSAPI.state,
             "cylinder",
-            2
+            joint_state_vec
         )
         
         joint_velocity_ms = joint_state_vec[0]
@@ -58,60 +58,8822 @@
 #include <string>
 #include <math.h>
 #include <vector>
+#include <tuple>
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+#include <mutex>
+#include <thread>
+#include <atomic>
+#include <variant>
+#include <cstdint>
+#include <chrono>
+#include <functional>
+#include <memory>
+#include <condition_variable>
+#include <filesystem>
+#include <map>
+#include <unordered_set>
 
 #include <pybind11/pybind11.h>
 #include <pybind11/stl.h>
+#include <pybind11/numpy.h>
+
+//  the API header can be overridden at build time (e.g., to build against the stub in bench/)
+#ifndef PDSAPI_BINDINGS_API_HEADER
+    #define PDSAPI_BINDINGS_API_HEADER "../../include/ProteusDSAPI.h"
+#endif
+
+#include PDSAPI_BINDINGS_API_HEADER
+
+#if defined(__unix__) || defined(__APPLE__)
+    #define PDSAPI_BINDINGS_HAS_FORK
+    
+    #include <cerrno>
+    #include <fcntl.h>
+    #include <sys/mman.h>
+    #include <sys/stat.h>
+    #include <sys/wait.h>
+    #include <unistd.h>
+#elif defined(_WIN32)
+    #ifndef NOMINMAX
+        #define NOMINMAX
+    #endif
+    
+    #ifndef WIN32_LEAN_AND_MEAN
+        #define WIN32_LEAN_AND_MEAN
+    #endif
+    
+    #include <windows.h>
+#endif
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+    #define PDSAPI_BINDINGS_HAS_SSE2
+    
+    #include <emmintrin.h>
+#endif
+
+
+// ==== Instrumentation ================================================================================ //
+
+/*
+ *  Optional per-call instrumentation of the bound entry points, compiled in only if 
+ *  PDSAPI_BINDINGS_INSTRUMENT is defined (see setup.py); otherwise, the macros below expand to 
+ *  nothing (or to the bare API call).
+ *
+ *  When compiled in, each call is keyed by (function, command, dobject name), and its total time
+ *  (from wrapper entry to exit) and time spent inside the API are accumulated, along with a 
+ *  log-linear (HDR-style) histogram of total latency. The difference between the two is the time
+ *  spent marshalling (converting, copying, and allocating) on the bindings side. Note that this 
+ *  does not include pybind11's own argument conversion, which happens before the wrapper is 
+ *  entered. Counters are kept per thread, and are only ever written by their own thread (with 
+ *  relaxed atomics), so recording takes no locks once a key has been seen.
+ */
+
+// ----------------------------------------------------------------------------------------------------- //
+
+///
+/// \enum BindingFunction
+///
+/// \brief Identifies the instrumented entry points.
+///
+
+enum BindingFunction {
+    FN_INITIALIZE_PROTEUSDS,
+    FN_CLOSE,
+    FN_ADVANCE_TIME,
+    FN_ADVANCE_TIME_ASYNC,
+    FN_GET_DOUBLE_ARRAY,
+    FN_GET_DOUBLE_ARRAY_NUMPY,
+    FN_GET_DOUBLE,
+    FN_GET_INT_ARRAY,
+    FN_GET_INT_ARRAY_NUMPY,
+    FN_GET_INT,
+    FN_GET_STRING,
+    FN_GET_ERROR_MESSAGE,
+    FN_GET_DOBJECT_NAMES,
+    FN_GET_DOBJECT_TYPES,
+    FN_REFRESH_METADATA,
+    FN_SET_DOUBLE_ARRAY,
+    FN_SET_DOUBLE_ARRAY_NUMPY,
+    FN_SET_DOUBLE,
+    FN_SET_INT_ARRAY,
+    FN_SET_INT_ARRAY_NUMPY,
+    FN_SET_INT,
+    FN_SET_STRING,
+    FN_DISCONNECT_CABLE,
+    FN_MAKE_DCABLE_DCABLE_POINT_CONNECTION,
+    FN_SET_CABLE_END_NODE_KINEMATIC_MODE,
+    FN_GATHER_DOUBLES,
+    FN_SCATTER_DOUBLES,
+    FN_REQUEST_PLAN_GATHER,
+    FN_REQUEST_PLAN_SCATTER,
+    FN_RUN_LOOP,
+    FN_SCHEDULER_RUN,
+    FN_SNAPSHOT,
+    FN_RESTORE,
+    FN_CABLE_VIEW_GET,
+    FN_GET_CABLE_FIELDS,
+    FN_GET_RIGID_BODY_FLEET,
+    FN_SET_RIGID_BODY_FLEET,
+    N_BINDING_FUNCTIONS
+};  /* BindingFunction */
+
+
+const char* BINDING_FUNCTION_NAMES[N_BINDING_FUNCTIONS] = {
+    "InitializeProteusDS",
+    "Close",
+    "AdvanceTime",
+    "AdvanceTimeAsync",
+    "GetDoubleArray",
+    "GetDoubleArray[numpy]",
+    "GetDouble",
+    "GetIntArray",
+    "GetIntArray[numpy]",
+    "GetInt",
+    "GetString",
+    "GetErrorMessage",
+    "GetDObjectNames",
+    "GetDObjectTypes",
+    "RefreshMetadata",
+    "SetDoubleArray",
+    "SetDoubleArray[numpy]",
+    "SetDouble",
+    "SetIntArray",
+    "SetIntArray[numpy]",
+    "SetInt",
+    "SetString",
+    "DisconnectCable",
+    "MakeDCableDCablePointConnection",
+    "SetCableEndNodeKinematicMode",
+    "GatherDoubles",
+    "ScatterDoubles",
+    "RequestPlan.gather",
+    "RequestPlan.scatter",
+    "RunLoop",
+    "Scheduler.run",
+    "Snapshot",
+    "Restore",
+    "CableView.get",
+    "GetCableFields",
+    "GetRigidBodyFleet",
+    "SetRigidBodyFleet"
+};
+
+// ----------------------------------------------------------------------------------------------------- //
+
+#ifdef PDSAPI_BINDINGS_INSTRUMENT
+
+#define PDSAPI_BINDINGS_N_LATENCY_BUCKETS 496
+
+// ----------------------------------------------------------------------------------------------------- //
+
+///
+/// \fn size_t LatencyBucket(uint64_t latency_ns)
+///
+/// \brief Returns the (log-linear) histogram bucket of the given latency: exact below 16
+///     ns, and then 8 sub-buckets per power of two (i.e., within 12.5%).
+///
+/// \param latency_ns The latency [ns].
+///
+/// \return The histogram bucket.
+///
+
+size_t LatencyBucket(uint64_t latency_ns)
+{
+    if (latency_ns < 16) {
+        return latency_ns;
+    }
+    
+    size_t exponent = 0;
+    uint64_t value = latency_ns;
+    
+    while (value >>= 1) {
+        exponent++;
+    }
+    
+    size_t sub_bucket = (latency_ns >> (exponent - 3)) & 7;
+    
+    return std::min(16 + (exponent - 4) * 8 + sub_bucket, (size_t)PDSAPI_BINDINGS_N_LATENCY_BUCKETS - 1);
+}   /* LatencyBucket() */
+
+// ----------------------------------------------------------------------------------------------------- //
+
+
+
+// ----------------------------------------------------------------------------------------------------- //
+
+///
+/// \fn double LatencyBucketValue(size_t bucket)
+///
+/// \brief Returns the (midpoint) latency of the given histogram bucket.
+///
+/// \param bucket The histogram bucket.
+///
+/// \return The (midpoint) latency [ns].
+///
+
+double LatencyBucketValue(size_t bucket)
+{
+    if (bucket < 16) {
+        return bucket;
+    }
+    
+    size_t exponent = (bucket - 16) / 8 + 4;
+    size_t sub_bucket = (bucket - 16) % 8;
+    double width = ldexp(1.0, (int)exponent - 3);
+    
+    return (8 + sub_bucket) * width + 0.5 * width;
+}   /* LatencyBucketValue() */
+
+// ----------------------------------------------------------------------------------------------------- //
+
+
+
+// ----------------------------------------------------------------------------------------------------- //
+
+///
+/// \struct CallStats
+///
+/// \brief Accumulated statistics for a single (function, command, dobject name) key.
+///
+
+struct CallStats {
+    std::atomic<uint64_t> n_calls{0};
+    std::atomic<uint64_t> total_ns{0};
+    std::atomic<uint64_t> api_ns{0};
+    std::atomic<uint64_t> max_ns{0};
+    std::atomic<uint64_t> histogram[PDSAPI_BINDINGS_N_LATENCY_BUCKETS] = {};
+};  /* CallStats */
+
+
+typedef std::tuple<int, int, std::string> CallKey;
+
+
+///
+/// \struct ThreadCallStats
+///
+/// \brief The statistics of a single thread. The mutex is only taken by the owning thread
+///     when adding a key, and by snapshots/resets.
+///
+
+struct ThreadCallStats {
+    std::mutex mutex;
+    std::map<CallKey, std::unique_ptr<CallStats>> stats;
+};  /* ThreadCallStats */
+
+
+std::atomic<bool> instrumentation_enabled(true);
+std::mutex instrumentation_registry_mutex;
+std::vector<std::shared_ptr<ThreadCallStats>> instrumentation_registry;
+
+// ----------------------------------------------------------------------------------------------------- //
+
+
+
+// ----------------------------------------------------------------------------------------------------- //
+
+///
+/// \fn CallStats* GetCallStats(int function_id, int command, const std::string& dobject_name)
+///
+/// \brief Returns the calling thread's statistics for the given key (creating them, and
+///     registering the thread, as needed).
+///
+/// \param function_id The entry point (resolved by the BindingFunction enumeration).
+///
+/// \param command The command (-1 if not applicable).
+///
+/// \param dobject_name The dobject name ("" if not applicable).
+///
+/// \return The calling thread's statistics for the given key.
+///
+
+CallStats* GetCallStats(int function_id, int command, const std::string& dobject_name)
+{
+    static thread_local std::shared_ptr<ThreadCallStats> thread_stats;
+    
+    if (!thread_stats) {
+        thread_stats = std::make_shared<ThreadCallStats>();
+        
+        std::lock_guard<std::mutex> lock(instrumentation_registry_mutex);
+        instrumentation_registry.push_back(thread_stats);
+    }
+    
+    CallKey key(function_id, command, dobject_name);
+    auto stats_iter = thread_stats->stats.find(key);
+    
+    if (stats_iter != thread_stats->stats.end()) {
+        return stats_iter->second.get();
+    }
+    
+    std::lock_guard<std::mutex> lock(thread_stats->mutex);
+    
+    return (thread_stats->stats[key] = std::unique_ptr<CallStats>(new CallStats())).get();
+}   /* GetCallStats() */
+
+// ----------------------------------------------------------------------------------------------------- //
+
+
+
+// ----------------------------------------------------------------------------------------------------- //
+
+///
+/// \class CallTimer
+///
+/// \brief Scoped timer for a single call to an entry point. While alive, it is the 
+///     calling thread's current timer, into which any ApiTimer accumulates.
+///
+
+class CallTimer {
+    public:
+        CallStats* stats;
+        CallTimer* previous_timer;
+        uint64_t api_ns;
+        std::chrono::steady_clock::time_point start_time;
+        
+        static thread_local CallTimer* current_timer;
+        
+        CallTimer(int, int, const std::string&);
+        ~CallTimer(void);
+};  /* CallTimer */
+
+
+thread_local CallTimer* CallTimer::current_timer = nullptr;
+
+
+CallTimer::CallTimer(int function_id, int command, const std::string& dobject_name)
+{
+    this->stats = nullptr;
+    this->previous_timer = CallTimer::current_timer;
+    this->api_ns = 0;
+    
+    if (!instrumentation_enabled.load(std::memory_order_relaxed)) {
+        return;
+    }
+    
+    this->stats = GetCallStats(function_id, command, dobject_name);
+    CallTimer::current_timer = this;
+    this->start_time = std::chrono::steady_clock::now();
+    
+    return;
+}   /* CallTimer() */
+
+
+CallTimer::~CallTimer(void)
+{
+    if (this->stats == nullptr) {
+        return;
+    }
+    
+    uint64_t total_ns = std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now() - this->start_time
+    ).count();
+    
+    this->stats->n_calls.fetch_add(1, std::memory_order_relaxed);
+    this->stats->total_ns.fetch_add(total_ns, std::memory_order_relaxed);
+    this->stats->api_ns.fetch_add(this->api_ns, std::memory_order_relaxed);
+    this->stats->histogram[LatencyBucket(total_ns)].fetch_add(1, std::memory_order_relaxed);
+    
+    if (total_ns > this->stats->max_ns.load(std::memory_order_relaxed)) {
+        this->stats->max_ns.store(total_ns, std::memory_order_relaxed);
+    }
+    
+    CallTimer::current_timer = this->previous_timer;
+    
+    return;
+}   /* ~CallTimer() */
+
+// ----------------------------------------------------------------------------------------------------- //
+
+
+
+// ----------------------------------------------------------------------------------------------------- //
+
+///
+/// \class ApiTimer
+///
+/// \brief Scoped timer for time spent inside the API, accumulated into the calling 
+///     thread's current CallTimer (if any).
+///
+
+class ApiTimer {
+    public:
+        CallTimer* call_timer;
+        std::chrono::steady_clock::time_point start_time;
+        
+        ApiTimer(void)
+        {
+            this->call_timer = CallTimer::current_timer;
+            
+            if (this->call_timer != nullptr) {
+                this->start_time = std::chrono::steady_clock::now();
+            }
+            
+            return;
+        }
+        
+        ~ApiTimer(void)
+        {
+            if (this->call_timer != nullptr) {
+                this->call_timer->api_ns += std::chrono::duration_cast<std::chrono::nanoseconds>(
+                    std::chrono::steady_clock::now() - this->start_time
+                ).count();
+            }
+            
+            return;
+        }
+};  /* ApiTimer */
+
+// ----------------------------------------------------------------------------------------------------- //
+
+
+
+// ----------------------------------------------------------------------------------------------------- //
+
+///
+/// \fn pybind11::list GetInstrumentation(void)
+///
+/// \brief Returns a snapshot of the (merged across threads) statistics, as a list of 
+///     dicts (one per key), with times in seconds (totals) and microseconds (latencies).
+///
+/// \return A snapshot of the statistics.
+///
+
+pybind11::list GetInstrumentation(void)
+{
+    struct MergedStats {
+        uint64_t n_calls = 0;
+        uint64_t total_ns = 0;
+        uint64_t api_ns = 0;
+        uint64_t max_ns = 0;
+        std::vector<uint64_t> histogram = std::vector<uint64_t>(PDSAPI_BINDINGS_N_LATENCY_BUCKETS, 0);
+    };
+    
+    std::map<CallKey, MergedStats> merged;
+    
+    {
+        std::lock_guard<std::mutex> registry_lock(instrumentation_registry_mutex);
+        
+        for (std::shared_ptr<ThreadCallStats>& thread_stats : instrumentation_registry) {
+            std::lock_guard<std::mutex> lock(thread_stats->mutex);
+            
+            for (auto& stats_pair : thread_stats->stats) {
+                MergedStats& merged_stats = merged[stats_pair.first];
+                const CallStats& stats = *(stats_pair.second);
+                
+                merged_stats.n_calls += stats.n_calls.load(std::memory_order_relaxed);
+                merged_stats.total_ns += stats.total_ns.load(std::memory_order_relaxed);
+                merged_stats.api_ns += stats.api_ns.load(std::memory_order_relaxed);
+                merged_stats.max_ns = std::max(
+                    merged_stats.max_ns,
+                    stats.max_ns.load(std::memory_order_relaxed)
+                );
+                
+                for (size_t i = 0; i < PDSAPI_BINDINGS_N_LATENCY_BUCKETS; i++) {
+                    merged_stats.histogram[i] += stats.histogram[i].load(std::memory_order_relaxed);
+                }
+            }
+        }
+    }
+    
+    pybind11::list snapshot_list;
+    
+    for (auto& merged_pair : merged) {
+        const MergedStats& stats = merged_pair.second;
+        
+        if (stats.n_calls == 0) {
+            continue;
+        }
+        
+        //  percentiles from the histogram
+        double percentiles[3] = {0.5, 0.9, 0.99};
+        double percentile_us[3] = {0, 0, 0};
+        
+        for (size_t p = 0; p < 3; p++) {
+            uint64_t threshold = (uint64_t)ceil(percentiles[p] * stats.n_calls);
+            uint64_t count = 0;
+            
+            for (size_t i = 0; i < PDSAPI_BINDINGS_N_LATENCY_BUCKETS; i++) {
+                count += stats.histogram[i];
+                
+                if (count >= threshold) {
+                    percentile_us[p] = 1e-3 * LatencyBucketValue(i);
+                    break;
+                }
+            }
+        }
+        
+        pybind11::dict stats_dict;
+        stats_dict["function"] = BINDING_FUNCTION_NAMES[std::get<0>(merged_pair.first)];
+        stats_dict["command"] = std::get<1>(merged_pair.first);
+        stats_dict["dobject"] = std::get<2>(merged_pair.first);
+        stats_dict["calls"] = stats.n_calls;
+        stats_dict["total_s"] = 1e-9 * stats.total_ns;
+        stats_dict["api_s"] = 1e-9 * stats.api_ns;
+        stats_dict["marshalling_s"] = 1e-9 * (stats.total_ns - std::min(stats.api_ns, stats.total_ns));
+        stats_dict["mean_us"] = 1e-3 * stats.total_ns / stats.n_calls;
+        stats_dict["p50_us"] = percentile_us[0];
+        stats_dict["p90_us"] = percentile_us[1];
+        stats_dict["p99_us"] = percentile_us[2];
+        stats_dict["max_us"] = 1e-3 * stats.max_ns;
+        
+        snapshot_list.append(stats_dict);
+    }
+    
+    return snapshot_list;
+}   /* GetInstrumentation() */
+
+// ----------------------------------------------------------------------------------------------------- //
+
+
+
+// ----------------------------------------------------------------------------------------------------- //
+
+///
+/// \fn void ResetInstrumentation(void)
+///
+/// \brief Zeroes all statistics (calls in flight on other threads may still land in the
+///     zeroed counters).
+///
+
+void ResetInstrumentation(void)
+{
+    std::lock_guard<std::mutex> registry_lock(instrumentation_registry_mutex);
+    
+    for (std::shared_ptr<ThreadCallStats>& thread_stats : instrumentation_registry) {
+        std::lock_guard<std::mutex> lock(thread_stats->mutex);
+        
+        for (auto& stats_pair : thread_stats->stats) {
+            CallStats& stats = *(stats_pair.second);
+            
+            stats.n_calls.store(0, std::memory_order_relaxed);
+            stats.total_ns.store(0, std::memory_order_relaxed);
+            stats.api_ns.store(0, std::memory_order_relaxed);
+            stats.max_ns.store(0, std::memory_order_relaxed);
+            
+            for (size_t i = 0; i < PDSAPI_BINDINGS_N_LATENCY_BUCKETS; i++) {
+                stats.histogram[i].store(0, std::memory_order_relaxed);
+            }
+        }
+    }
+    
+    return;
+}   /* ResetInstrumentation() */
+
+// ----------------------------------------------------------------------------------------------------- //
+
+#define PDSAPI_TIME_CALL(function_id, command, dobject_name) \
+    CallTimer call_timer(function_id, command, dobject_name)
+
+#define PDSAPI_TIMED(...) { ApiTimer api_timer; __VA_ARGS__; }
+
+#else
+
+#define PDSAPI_TIME_CALL(function_id, command, dobject_name)
+
+#define PDSAPI_TIMED(...) __VA_ARGS__;
+
+#endif  /* PDSAPI_BINDINGS_INSTRUMENT */
+
+// ==== END Instrumentation ============================================================================ //
+
+
+
+// ==== Metadata cache ================================================================================= //
+
+/*
+ *  Some values are queried often but rarely change during a run: the dobject count, names, and 
+ *  types, the state size, the version, the cable node/element/sample point counts, and the 
+ *  reference wave and current profile depth parameters. The Get wrappers serve these from a 
+ *  per-simulation cache, filled on first access (one entry per getter, command, dobject, and 
+ *  size). Values the solver itself varies (the sea height, and the current profile speed and 
+ *  heading) are never cached. Since the solver also moves the wave and current parameters once 
+ *  environmentTransitionTime is reached, these are only cached while no transition is 
+ *  configured (environmentTransitionTime <= 0), and setting the transition time (or ramp time)
+ *  forgets them. Setting one
+ *  of these commands (by way of any Set wrapper, a snapshot restore, or a controller) forgets only 
+ *  the entries of that command, so that, e.g., a sea height set every step does not evict the 
+ *  dobject names. The whole cache of a simulation is forgotten on DisconnectCable, 
+ *  MakeDCableDCablePointConnection, InitializeProteusDS, and Close (including those made by 
+ *  ensembles and warm start pools), and on an explicit RefreshMetadata() (or 
+ *  Simulation.refresh()). Each simulation's cache (and each command within it) carries a 
+ *  generation, so a fill that races with a change is never stored.
+ */
+
+// ----------------------------------------------------------------------------------------------------- //
+
+///
+/// \fn bool IsMetadataCommand(int command)
+///
+/// \brief Returns whether the given command is cached as metadata.
+///
+/// \param command The command (resolved by the PDSAPI::PDSAPI enumeration).
+///
+/// \return Whether the given command is cached as metadata.
+///
+
+bool IsMetadataCommand(int command)
+{
+    switch (command) {
+        case (PDSAPI::PDSAPI::stateSize):
+        case (PDSAPI::PDSAPI::numberOfDObjects):
+        case (PDSAPI::PDSAPI::dObjectNames):
+        case (PDSAPI::PDSAPI::dObjectTypes):
+        case (PDSAPI::PDSAPI::version):
+        case (PDSAPI::PDSAPI::environmentWaveReferenceHeight):
+        case (PDSAPI::PDSAPI::environmentWaveReferencePeriod):
+        case (PDSAPI::PDSAPI::environmentWaveReferenceHeading):
+        case (PDSAPI::PDSAPI::environmentWaveType):
+        case (PDSAPI::PDSAPI::environmentWaveSegments):
+        case (PDSAPI::PDSAPI::environmentWaveSeed):
+        case (PDSAPI::PDSAPI::environmentTransitionTime):
+        case (PDSAPI::PDSAPI::environmentTransitionRampTime):
+        case (PDSAPI::PDSAPI::environmentCurrentProfileDepth):
+        case (PDSAPI::PDSAPI::cableNumberOfNodes):
+        case (PDSAPI::PDSAPI::cableNumberOfElements):
+        case (PDSAPI::PDSAPI::cableTensionNumberOfSamplePoints):
+        case (PDSAPI::PDSAPI::cableBendingRadiusNumberOfSamplePoints):
+        case (PDSAPI::PDSAPI::cableVonMisesNumberOfSamplePoints):
+        case (PDSAPI::PDSAPI::cableVonMisesNumberOfRadialSamplePoints):
+        case (PDSAPI::PDSAPI::cableTemperaturesNumberOfSamplePoints):
+        case (PDSAPI::PDSAPI::cablePositionsNumberOfSamplePoints):
+        case (PDSAPI::PDSAPI::cableFlexuralStressNumberOfSamplePoints):
+            return true;
+        
+        default:
+            return false;
+    }
+}   /* IsMetadataCommand() */
+
+// ----------------------------------------------------------------------------------------------------- //
+
+
+
+// ----------------------------------------------------------------------------------------------------- //
+
+///
+/// \fn bool IsTransitioningCommand(int command)
+///
+/// \brief Returns whether the given (metadata) command is one that the solver moves at
+///     environmentTransitionTime (the wave and current parameters).
+///
+/// \param command The command (resolved by the PDSAPI::PDSAPI enumeration).
+///
+/// \return Whether the given command is moved by an environment transition.
+///
+
+bool IsTransitioningCommand(int command)
+{
+    switch (command) {
+        case (PDSAPI::PDSAPI::environmentWaveReferenceHeight):
+        case (PDSAPI::PDSAPI::environmentWaveReferencePeriod):
+        case (PDSAPI::PDSAPI::environmentWaveReferenceHeading):
+        case (PDSAPI::PDSAPI::environmentWaveType):
+        case (PDSAPI::PDSAPI::environmentWaveSegments):
+        case (PDSAPI::PDSAPI::environmentWaveSeed):
+        case (PDSAPI::PDSAPI::environmentCurrentProfileDepth):
+            return true;
+        
+        default:
+            return false;
+    }
+}   /* IsTransitioningCommand() */
+
+// ----------------------------------------------------------------------------------------------------- //
+
+
+
+// ----------------------------------------------------------------------------------------------------- //
+
+///
+/// \fn constexpr bool ChangesMetadata(int function_id)
+///
+/// \brief Returns whether the given (directly bound) API function can change metadata:
+///     always, for structural changes, or when setting a metadata command, for setters.
+///
+/// \param function_id The function (resolved by the BindingFunction enumeration).
+///
+/// \return Whether the given function can change metadata.
+///
+
+constexpr bool ChangesMetadata(int function_id)
+{
+    switch (function_id) {
+        case (FN_INITIALIZE_PROTEUSDS):
+        case (FN_DISCONNECT_CABLE):
+        case (FN_MAKE_DCABLE_DCABLE_POINT_CONNECTION):
+        case (FN_SET_DOUBLE_ARRAY):
+        case (FN_SET_DOUBLE):
+        case (FN_SET_INT_ARRAY):
+        case (FN_SET_INT):
+        case (FN_SET_STRING):
+            return true;
+        
+        default:
+            return false;
+    }
+}   /* ChangesMetadata() */
+
+// ----------------------------------------------------------------------------------------------------- //
+
+
+
+// ----------------------------------------------------------------------------------------------------- //
+
+///
+/// \typedef MetadataKey
+///
+/// \brief A metadata cache key: (function id, command, dobject name, n_elements).
+///
+
+typedef std::tuple<int, int, std::string, size_t> MetadataKey;
+
+///
+/// \typedef MetadataValue
+///
+/// \brief A cached metadata value (as returned by the corresponding Get wrapper).
+///
+
+typedef std::variant<
+    int,
+    double,
+    std::string,
+    std::vector<double>,
+    std::vector<int>,
+    std::vector<std::string>
+> MetadataValue;
+
+///
+/// \struct SimulationMetadata
+///
+/// \brief The metadata cache of a single simulation.
+///
+
+struct SimulationMetadata {
+    size_t generation = 0;
+    std::map<int, size_t> command_generations;
+    std::map<MetadataKey, MetadataValue> values;
+};  /* SimulationMetadata */
+
+std::mutex metadata_mutex;
+std::map<std::string, SimulationMetadata> simulation_metadata;
+
+// ----------------------------------------------------------------------------------------------------- //
+
+
+
+// ----------------------------------------------------------------------------------------------------- //
+
+///
+/// \fn template <typename T, typename Getter>
+///     T GetMetadata(
+///         int function_id,
+///         const std::string& unique_simulation_label,
+///         int command,
+///         const std::string& dobject_name,
+///         size_t n_elements,
+///         Getter get
+///     )
+///
+/// \brief Returns the cached value for the given key, calling get() (outside of the lock)
+///     and caching its result on a miss.
+///
+/// \param function_id The Get wrapper (resolved by the BindingFunction enumeration).
+///
+/// \param unique_simulation_label The API label for the target simulation.
+///
+/// \param command Defines the attribute of interest (resolved by the PDSAPI::PDSAPI 
+///     enumeration).
+///
+/// \param dobject_name Defines the dobject of interest.
+///
+/// \param n_elements The number of elements (0 for a scalar).
+///
+/// \param get The uncached getter.
+///
+/// \return The (cached) value.
+///
+
+bool IsTransitionConfigured(const std::string&);     // defined below (it is itself cached)
+
+template <typename T, typename Getter>
+T GetMetadata(
+    int function_id,
+    const std::string& unique_simulation_label,
+    int command,
+    const std::string& dobject_name,
+    size_t n_elements,
+    Getter get
+)
+{
+    MetadataKey key(function_id, command, dobject_name, n_elements);
+    size_t generation = 0;
+    size_t command_generation = 0;
+    
+    {
+        std::lock_guard<std::mutex> lock(metadata_mutex);
+        SimulationMetadata& metadata = simulation_metadata[unique_simulation_label];
+        auto value_iter = metadata.values.find(key);
+        
+        if (value_iter != metadata.values.end()) {
+            return std::get<T>(value_iter->second);
+        }
+        
+        generation = metadata.generation;
+        command_generation = metadata.command_generations[command];
+    }
+    
+    T value = get();
+    
+    if (IsTransitioningCommand(command) && IsTransitionConfigured(unique_simulation_label)) {
+        return value;
+    }
+    
+    std::lock_guard<std::mutex> lock(metadata_mutex);
+    SimulationMetadata& metadata = simulation_metadata[unique_simulation_label];
+    
+    if (
+        metadata.generation == generation &&
+        metadata.command_generations[command] == command_generation
+    ) {
+        metadata.values[key] = value;
+    }
+    
+    return value;
+}   /* GetMetadata() */
+
+// ----------------------------------------------------------------------------------------------------- //
+
+
+
+// ----------------------------------------------------------------------------------------------------- //
+
+///
+/// \fn bool IsTransitionConfigured(const std::string& unique_simulation_label)
+///
+/// \brief Returns whether the given simulation has an environment transition configured 
+///     (environmentTransitionTime > 0), in which case the wave and current parameters are
+///     not cached.
+///
+/// \param unique_simulation_label The API label for the target simulation.
+///
+/// \return Whether an environment transition is configured.
+///
+
+bool IsTransitionConfigured(const std::string& unique_simulation_label)
+{
+    double transition_time_s = GetMetadata<double>(
+        FN_GET_DOUBLE,
+        unique_simulation_label,
+        PDSAPI::PDSAPI::environmentTransitionTime,
+        "",
+        0,
+        [&]() {
+            double return_double = 0;
+            PDSAPI_TIMED(ProteusDSAPI::GetDouble(
+                unique_simulation_label,
+                PDSAPI::PDSAPI::environmentTransitionTime,
+                "",
+                return_double
+            ));
+            
+            return return_double;
+        }
+    );
+    
+    return transition_time_s > 0;
+}   /* IsTransitionConfigured() */
+
+// ----------------------------------------------------------------------------------------------------- //
+
+
+
+// ----------------------------------------------------------------------------------------------------- //
+
+///
+/// \fn void ForgetMetadata(const std::string& unique_simulation_label, int command = -1)
+///
+/// \brief Forgets the cached metadata of the given simulation: only the entries of the
+///     given command (plus the wave and current parameters, if it is the transition time 
+///     or ramp time) or, by default, all of them (including cable field shapes, which are 
+///     built on the cached sample point counts).
+///
+/// \param unique_simulation_label The API label for the target simulation.
+///
+/// \param command The command to forget (resolved by the PDSAPI::PDSAPI enumeration), or
+///     -1 to forget all.
+///
+
+void ForgetMetadata(const std::string& unique_simulation_label, int command = -1)
+{
+    std::lock_guard<std::mutex> lock(metadata_mutex);
+    
+    SimulationMetadata& metadata = simulation_metadata[unique_simulation_label];
+    
+    if (command < 0) {
+        metadata.generation++;
+        metadata.values.clear();
+        
+        return;
+    }
+    
+    bool is_transition = (
+        command == PDSAPI::PDSAPI::environmentTransitionTime ||
+        command == PDSAPI::PDSAPI::environmentTransitionRampTime
+    );
+    
+    metadata.command_generations[command]++;
+    
+    if (is_transition) {
+        metadata.generation++;      // so that no racing fill of a wave or current parameter is stored
+    }
+    
+    for (auto value_iter = metadata.values.begin(); value_iter != metadata.values.end();) {
+        int cached_command = std::get<1>(value_iter->first);
+        
+        if (cached_command == command || (is_transition && IsTransitioningCommand(cached_command))) {
+            value_iter = metadata.values.erase(value_iter);
+        }
+        
+        else {
+            value_iter++;
+        }
+    }
+    
+    return;
+}   /* ForgetMetadata() */
+
+// ----------------------------------------------------------------------------------------------------- //
+
+
+
+// ----------------------------------------------------------------------------------------------------- //
+
+///
+/// \fn void NoteMetadataSet(const std::string& unique_simulation_label, int command)
+///
+/// \brief Helper function (for the Set wrappers) which forgets the cached entries of the
+///     given command (having just been set), if it is metadata.
+///
+/// \param unique_simulation_label The API label for the target simulation.
+///
+/// \param command The command that was set.
+///
+
+void NoteMetadataSet(const std::string& unique_simulation_label, int command)
+{
+    if (IsMetadataCommand(command)) {
+        ForgetMetadata(unique_simulation_label, command);
+    }
+    
+    return;
+}   /* NoteMetadataSet() */
+
+// ----------------------------------------------------------------------------------------------------- //
+
+
+
+// ----------------------------------------------------------------------------------------------------- //
+
+///
+/// \class MetadataInvalidator
+///
+/// \brief Forgets the cached metadata of a simulation (all of it, or the entries of a 
+///     single command) when it goes out of scope (i.e., after the wrapped API call has 
+///     returned, or thrown), if armed.
+///
+
+class MetadataInvalidator {
+    public:
+        std::string unique_simulation_label;
+        int command;
+        bool is_armed;
+        
+        MetadataInvalidator(const std::string&, int, bool);
+        MetadataInvalidator(const MetadataInvalidator&) = delete;
+        MetadataInvalidator& operator=(const MetadataInvalidator&) = delete;
+        ~MetadataInvalidator(void);
+};  /* MetadataInvalidator */
+
+
+MetadataInvalidator::MetadataInvalidator(
+    const std::string& unique_simulation_label,
+    int command,
+    bool is_armed
+)
+{
+    this->command = command;
+    this->is_armed = is_armed;
+    
+    if (is_armed) {
+        this->unique_simulation_label = unique_simulation_label;
+    }
+    
+    return;
+}   /* MetadataInvalidator() */
+
+
+MetadataInvalidator::~MetadataInvalidator(void)
+{
+    if (this->is_armed) {
+        ForgetMetadata(this->unique_simulation_label, this->command);
+    }
+    
+    return;
+}   /* ~MetadataInvalidator() */
+
+// ----------------------------------------------------------------------------------------------------- //
+
+// ==== END Metadata cache ============================================================================= //
+
+
+
+// ==== Asynchronous stepping ========================================================================== //
+
+/*
+ *  AdvanceTimeAsync() runs ProteusDSAPI::AdvanceTime on a dedicated worker thread per simulation
+ *  (started on first use), and returns a concurrent.futures.Future that resolves to the new 
+ *  simulation time once the step is done (use asyncio.wrap_future() to await it from asyncio). 
+ *  Steps on the same simulation run in the order submitted.
+ *
+ *  To keep reads and writes ordered with respect to steps, every Python-facing entry point that 
+ *  touches a simulation first constructs a SimulationGuard, which calls AwaitPendingSteps() to 
+ *  block (with the GIL released) until all steps submitted for that simulation have completed 
+ *  (if no steps are pending anywhere, this costs a single atomic load), and then holds the 
+ *  simulation's lock for the rest of the call. Many entry points run API calls with the GIL 
+ *  released, so the GIL alone no longer keeps two threads out of the same simulation; the lock 
+ *  does (the API is not known to be reentrant). The lock is reentrant (e.g., for a Python 
+ *  controller called back from within RunLoop), is also held by the worker thread around each 
+ *  step, and is only ever waited on with the GIL released, so it cannot deadlock against the GIL.
+ *  Calls on different simulations do not contend.
+ */
+
+// ----------------------------------------------------------------------------------------------------- //
+
+///
+/// \struct SimulationLock
+///
+/// \brief The (reentrant) lock serializing API calls on a single simulation. Never 
+///     destroyed, so references to it remain valid.
+///
+
+struct SimulationLock {
+    std::mutex mutex;
+    std::atomic<std::thread::id> owner;
+    size_t depth = 0;
+};  /* SimulationLock */
+
+std::mutex simulation_locks_mutex;
+std::map<std::string, std::unique_ptr<SimulationLock>> simulation_locks;
+
+void AwaitPendingSteps(const std::string&);      // defined below
+
+// ----------------------------------------------------------------------------------------------------- //
+
+
+
+// ----------------------------------------------------------------------------------------------------- //
+
+///
+/// \class SimulationGuard
+///
+/// \brief Awaits any pending asynchronous steps of a simulation, and then holds its lock 
+///     until it goes out of scope (see above).
+///
+
+class SimulationGuard {
+    private:
+        SimulationLock* lock_ptr;
+        
+    public:
+        SimulationGuard(const std::string&);
+        SimulationGuard(const SimulationGuard&) = delete;
+        SimulationGuard& operator=(const SimulationGuard&) = delete;
+        ~SimulationGuard(void);
+};  /* SimulationGuard */
+
+
+SimulationGuard::SimulationGuard(const std::string& unique_simulation_label)
+{
+    {
+        std::lock_guard<std::mutex> lock(simulation_locks_mutex);
+        std::unique_ptr<SimulationLock>& lock_ref = simulation_locks[unique_simulation_label];
+        
+        if (!lock_ref) {
+            lock_ref.reset(new SimulationLock());
+        }
+        
+        this->lock_ptr = lock_ref.get();
+    }
+    
+    //  1. reentry (same thread), so neither wait on steps nor lock again
+    if (this->lock_ptr->owner.load(std::memory_order_relaxed) == std::this_thread::get_id()) {
+        this->lock_ptr->depth++;
+        return;
+    }
+    
+    //  2. order against asynchronous steps, and then lock (waiting without the GIL)
+    AwaitPendingSteps(unique_simulation_label);
+    
+    if (!this->lock_ptr->mutex.try_lock()) {
+        if (PyGILState_Check()) {
+            pybind11::gil_scoped_release release;
+            this->lock_ptr->mutex.lock();
+        }
+        
+        else {
+            this->lock_ptr->mutex.lock();
+        }
+    }
+    
+    this->lock_ptr->owner.store(std::this_thread::get_id(), std::memory_order_relaxed);
+    this->lock_ptr->depth = 1;
+    
+    return;
+}   /* SimulationGuard() */
+
+
+SimulationGuard::~SimulationGuard(void)
+{
+    this->lock_ptr->depth--;
+    
+    if (this->lock_ptr->depth == 0) {
+        this->lock_ptr->owner.store(std::thread::id(), std::memory_order_relaxed);
+        this->lock_ptr->mutex.unlock();
+    }
+    
+    return;
+}   /* ~SimulationGuard() */
+
+// ----------------------------------------------------------------------------------------------------- //
+
+
+
+// ----------------------------------------------------------------------------------------------------- //
+
+///
+/// \class SimulationWorker
+///
+/// \brief A worker thread that runs the asynchronous steps of a single simulation, in order.
+///     Each queued step holds its time step and its (Python) future; the futures are only 
+///     ever copied or destroyed with the GIL held.
+///
+
+class SimulationWorker {
+    public:
+        std::string unique_simulation_label;
+        
+        std::mutex mutex;
+        std::condition_variable task_condition;
+        std::condition_variable idle_condition;
+        
+        std::vector<std::pair<double, pybind11::object>> steps;
+        size_t n_pending;
+        bool stopping;
+        
+        std::thread thread;
+        
+        SimulationWorker(std::string);
+        
+        void submit(double, pybind11::object);
+        void awaitIdle(void);
+        void stop(void);
+        void loop(void);
+        
+        ~SimulationWorker(void);
+};  /* SimulationWorker */
+
+
+std::atomic<size_t> async_steps_pending(0);
+std::mutex simulation_workers_mutex;
+std::map<std::string, std::shared_ptr<SimulationWorker>> simulation_workers;
+
+
+SimulationWorker::SimulationWorker(std::string unique_simulation_label)
+{
+    this->unique_simulation_label = unique_simulation_label;
+    this->n_pending = 0;
+    this->stopping = false;
+    
+    this->thread = std::thread(&SimulationWorker::loop, this);
+    
+    return;
+}   /* SimulationWorker() */
+
+
+SimulationWorker::~SimulationWorker(void)
+{
+    //  only reached without stop() at process exit (i.e., if the atexit hook never ran)
+    if (this->thread.joinable()) {
+        this->thread.detach();
+    }
+    
+    return;
+}   /* ~SimulationWorker() */
+
+// ----------------------------------------------------------------------------------------------------- //
+
+
+
+// ----------------------------------------------------------------------------------------------------- //
+
+///
+/// \fn void SimulationWorker::submit(double dt_s, pybind11::object future)
+///
+/// \brief Queues a step. Must be called with the GIL held.
+///
+/// \param dt_s The time step [s].
+///
+/// \param future The concurrent.futures.Future to resolve once the step is done.
+///
+
+void SimulationWorker::submit(double dt_s, pybind11::object future)
+{
+    std::lock_guard<std::mutex> lock(this->mutex);
+    
+    if (this->stopping) {
+        throw std::runtime_error("ERROR: simulation " + this->unique_simulation_label + " is closing");
+    }
+    
+    this->steps.push_back(std::make_pair(dt_s, std::move(future)));
+    this->n_pending++;
+    async_steps_pending.fetch_add(1, std::memory_order_acq_rel);
+    
+    this->task_condition.notify_one();
+    
+    return;
+}   /* submit() */
+
+// ----------------------------------------------------------------------------------------------------- //
+
+
+
+// ----------------------------------------------------------------------------------------------------- //
+
+///
+/// \fn void SimulationWorker::awaitIdle(void)
+///
+/// \brief Blocks until all submitted steps have completed. Must be called without the GIL
+///     (since resolving futures requires it).
+///
+
+void SimulationWorker::awaitIdle(void)
+{
+    std::unique_lock<std::mutex> lock(this->mutex);
+    this->idle_condition.wait(lock, [this]() { return this->n_pending == 0; });
+    
+    return;
+}   /* awaitIdle() */
+
+// ----------------------------------------------------------------------------------------------------- //
+
+
+
+// ----------------------------------------------------------------------------------------------------- //
+
+///
+/// \fn void SimulationWorker::stop(void)
+///
+/// \brief Runs any remaining steps, and then stops and joins the worker thread. Must be 
+///     called without the GIL.
+///
+
+void SimulationWorker::stop(void)
+{
+    {
+        std::lock_guard<std::mutex> lock(this->mutex);
+        this->stopping = true;
+        this->task_condition.notify_one();
+    }
+    
+    if (this->thread.joinable()) {
+        this->thread.join();
+    }
+    
+    return;
+}   /* stop() */
+
+// ----------------------------------------------------------------------------------------------------- //
+
+
+
+// ----------------------------------------------------------------------------------------------------- //
+
+///
+/// \fn void SimulationWorker::loop(void)
+///
+/// \brief The worker thread. Runs each step (without the GIL), marks it complete (so that 
+///     waiting reads and writes can proceed), and then resolves its future (with the GIL).
+///
+
+void SimulationWorker::loop(void)
+{
+    while (true) {
+        std::pair<double, pybind11::object> step;
+        
+        {
+            std::unique_lock<std::mutex> lock(this->mutex);
+            this->task_condition.wait(
+                lock,
+                [this]() { return this->stopping || !this->steps.empty(); }
+            );
+            
+            if (this->steps.empty()) {
+                return;
+            }
+            
+            step.first = this->steps.front().first;
+            step.second = std::move(this->steps.front().second);
+            this->steps.erase(this->steps.begin());
+        }
+        
+        std::string error_str = "";
+        double time_s = 0;
+        
+        try {
+            SimulationGuard simulation_guard(this->unique_simulation_label);
+            
+            ProteusDSAPI::AdvanceTime(this->unique_simulation_label, step.first);
+            ProteusDSAPI::GetDouble(this->unique_simulation_label, PDSAPI::PDSAPI::time, "", time_s);
+        }
+        
+        catch (std::exception& e) {
+            error_str = e.what();
+        }
+        
+        {
+            std::lock_guard<std::mutex> lock(this->mutex);
+            this->n_pending--;
+            async_steps_pending.fetch_sub(1, std::memory_order_acq_rel);
+            
+            this->idle_condition.notify_all();
+        }
+        
+        pybind11::gil_scoped_acquire acquire;
+        
+        try {
+            if (!step.second.attr("done")().cast<bool>()) {
+                if (error_str.empty()) {
+                    step.second.attr("set_result")(time_s);
+                }
+                
+                else {
+                    pybind11::object runtime_error = pybind11::module_::import("builtins").attr("RuntimeError");
+                    step.second.attr("set_exception")(runtime_error("ERROR: " + error_str));
+                }
+            }
+        }
+        
+        catch (pybind11::error_already_set& e) {
+            e.restore();
+            PyErr_WriteUnraisable(step.second.ptr());
+        }
+        
+        step.second = pybind11::object();
+    }
+}   /* loop() */
+
+// ----------------------------------------------------------------------------------------------------- //
+
+
+
+// ----------------------------------------------------------------------------------------------------- //
+
+///
+/// \fn void AwaitPendingSteps(const std::string& unique_simulation_label)
+///
+/// \brief Blocks until all asynchronous steps submitted for the given simulation have 
+///     completed (releasing the GIL while waiting, if held). Does not block on the worker 
+///     thread itself (e.g., from a future's done callback).
+///
+/// \param unique_simulation_label The API label for the target simulation.
+///
+
+void AwaitPendingSteps(const std::string& unique_simulation_label)
+{
+    if (async_steps_pending.load(std::memory_order_acquire) == 0) {
+        return;
+    }
+    
+    std::shared_ptr<SimulationWorker> worker;
+    
+    {
+        std::lock_guard<std::mutex> lock(simulation_workers_mutex);
+        auto worker_iter = simulation_workers.find(unique_simulation_label);
+        
+        if (worker_iter == simulation_workers.end()) {
+            return;
+        }
+        
+        worker = worker_iter->second;
+    }
+    
+    if (std::this_thread::get_id() == worker->thread.get_id()) {
+        return;
+    }
+    
+    if (PyGILState_Check()) {
+        pybind11::gil_scoped_release release;
+        worker->awaitIdle();
+    }
+    
+    else {
+        worker->awaitIdle();
+    }
+    
+    return;
+}   /* AwaitPendingSteps() */
+
+// ----------------------------------------------------------------------------------------------------- //
+
+
+
+// ----------------------------------------------------------------------------------------------------- //
+
+///
+/// \fn pybind11::object AdvanceTimeAsync(std::string unique_simulation_label, double dt)
+///
+/// \brief Submits a ProteusDSAPI::AdvanceTime step to the given simulation's worker thread
+///     (starting it if need be), and returns without waiting.
+///
+/// \param unique_simulation_label The API label for the target simulation.
+///
+/// \param dt The time step [s].
+///
+/// \return A concurrent.futures.Future, which resolves to the new simulation time [s].
+///
+
+pybind11::object AdvanceTimeAsync(std::string unique_simulation_label, double dt)
+{
+    PDSAPI_TIME_CALL(FN_ADVANCE_TIME_ASYNC, -1, "");
+    
+    std::shared_ptr<SimulationWorker> worker;
+    
+    {
+        std::lock_guard<std::mutex> lock(simulation_workers_mutex);
+        std::shared_ptr<SimulationWorker>& worker_ref = simulation_workers[unique_simulation_label];
+        
+        if (!worker_ref) {
+            worker_ref = std::make_shared<SimulationWorker>(unique_simulation_label);
+        }
+        
+        worker = worker_ref;
+    }
+    
+    pybind11::object future = pybind11::module_::import("concurrent.futures").attr("Future")();
+    future.attr("set_running_or_notify_cancel")();
+    
+    worker->submit(dt, future);
+    
+    return future;
+}   /* AdvanceTimeAsync() */
+
+// ----------------------------------------------------------------------------------------------------- //
+
+
+
+// ----------------------------------------------------------------------------------------------------- //
+
+///
+/// \fn void StopSimulationWorker(const std::string& unique_simulation_label)
+///
+/// \brief Waits for any pending steps of the given simulation, and then stops its worker 
+///     thread (if any). Must be called with the GIL held.
+///
+/// \param unique_simulation_label The API label for the target simulation.
+///
+
+void StopSimulationWorker(const std::string& unique_simulation_label)
+{
+    std::shared_ptr<SimulationWorker> worker;
+    
+    {
+        std::lock_guard<std::mutex> lock(simulation_workers_mutex);
+        auto worker_iter = simulation_workers.find(unique_simulation_label);
+        
+        if (worker_iter == simulation_workers.end()) {
+            return;
+        }
+        
+        worker = worker_iter->second;
+        
+        if (std::this_thread::get_id() == worker->thread.get_id()) {
+            throw std::runtime_error(
+                "ERROR: cannot close simulation " + unique_simulation_label + " from its own worker thread"
+            );
+        }
+        
+        simulation_workers.erase(worker_iter);
+    }
+    
+    pybind11::gil_scoped_release release;
+    worker->stop();
+    
+    return;
+}   /* StopSimulationWorker() */
+
+// ----------------------------------------------------------------------------------------------------- //
+
+
+
+// ----------------------------------------------------------------------------------------------------- //
+
+///
+/// \fn void StopSimulationWorkers(void)
+///
+/// \brief Stops all worker threads (registered with atexit, so that no worker is left 
+///     waiting on the GIL during interpreter shutdown). Must be called with the GIL held.
+///
+
+void StopSimulationWorkers(void)
+{
+    std::map<std::string, std::shared_ptr<SimulationWorker>> workers;
+    
+    {
+        std::lock_guard<std::mutex> lock(simulation_workers_mutex);
+        workers.swap(simulation_workers);
+    }
+    
+    pybind11::gil_scoped_release release;
+    
+    for (auto& worker_pair : workers) {
+        worker_pair.second->stop();
+    }
+    
+    return;
+}   /* StopSimulationWorkers() */
+
+// ----------------------------------------------------------------------------------------------------- //
+
+
+
+// ----------------------------------------------------------------------------------------------------- //
+
+///
+/// \fn void Close(std::string unique_simulation_label)
+///
+/// \brief Wrapper on ProteusDSAPI::Close that first completes any pending asynchronous 
+///     steps and stops the simulation's worker thread, and then forgets its cached metadata.
+///
+/// \param unique_simulation_label The API label for the target simulation.
+///
+
+void Close(std::string unique_simulation_label)
+{
+    PDSAPI_TIME_CALL(FN_CLOSE, -1, "");
+    
+    StopSimulationWorker(unique_simulation_label);
+    
+    {
+        SimulationGuard simulation_guard(unique_simulation_label);
+        PDSAPI_TIMED(ProteusDSAPI::Close(unique_simulation_label));
+    }
+    
+    ForgetMetadata(unique_simulation_label);
+    
+    return;
+}   /* Close() */
+
+// ----------------------------------------------------------------------------------------------------- //
+
+
+
+// ----------------------------------------------------------------------------------------------------- //
+
+///
+/// \fn template <int function_id, typename Return, typename... Args>
+///     auto BindApi(Return (*api_function)(Args...))
+///
+/// \brief Wraps an API function (that is otherwise bound directly), keeping its exact 
+///     signature, so as to first wait for any pending asynchronous steps of the target
+///     simulation (always the first argument), and to time the call (if instrumented). If 
+///     the function takes (label, command, dobject name, ...), the call is keyed by command
+///     and dobject name as well. Afterwards, forgets the simulation's cached metadata if the
+///     call could have changed it.
+///
+/// \param api_function The API function to wrap.
+///
+/// \return The wrapped function (a lambda).
+///
+
+template <int function_id, typename Return, typename... Args>
+auto BindApi(Return (*api_function)(Args...))
+{
+    return [api_function](Args... args) -> Return {
+        std::tuple<const Args&...> arguments(args...);
+        SimulationGuard simulation_guard(std::get<0>(arguments));
+        
+        #ifdef PDSAPI_BINDINGS_INSTRUMENT
+            int command = -1;
+            std::string dobject_name = "";
+            
+            if constexpr (sizeof...(Args) >= 3) {
+                typedef std::decay_t<std::tuple_element_t<1, std::tuple<Args...>>> SecondArg;
+                typedef std::decay_t<std::tuple_element_t<2, std::tuple<Args...>>> ThirdArg;
+                
+                if constexpr (std::is_same_v<SecondArg, int> && std::is_same_v<ThirdArg, std::string>) {
+                    command = std::get<1>(arguments);
+                    dobject_name = std::get<2>(arguments);
+                }
+            }
+        #endif
+        
+        PDSAPI_TIME_CALL(function_id, command, dobject_name);
+        
+        if constexpr (ChangesMetadata(function_id)) {
+            int set_command = -1;
+            
+            if constexpr (sizeof...(Args) >= 2) {
+                if constexpr (std::is_same_v<std::decay_t<std::tuple_element_t<1, std::tuple<Args...>>>, int>) {
+                    set_command = std::get<1>(arguments);
+                }
+            }
+            
+            constexpr bool is_structural = (
+                function_id == FN_INITIALIZE_PROTEUSDS ||
+                function_id == FN_DISCONNECT_CABLE ||
+                function_id == FN_MAKE_DCABLE_DCABLE_POINT_CONNECTION
+            );
+            
+            MetadataInvalidator invalidator(
+                std::get<0>(arguments),
+                is_structural ? -1 : set_command,
+                is_structural || IsMetadataCommand(set_command)
+            );
+            
+            PDSAPI_TIMED(return api_function(std::forward<Args>(args)...));
+        }
+        
+        else {
+            PDSAPI_TIMED(return api_function(std::forward<Args>(args)...));
+        }
+    };
+}   /* BindApi() */
+
+// ----------------------------------------------------------------------------------------------------- //
+
+// ==== END Asynchronous stepping ====================================================================== //
 
-#include "../../include/ProteusDSAPI.h"
 
 
 // ==== Get wrappers =================================================================================== //
 
 /*
- *  This wrapping scheme is necessary because Python is neither pass by reference nor pass by 
- *  value, but is instead "pass by assignment" (ref: https://realpython.com/python-pass-by-reference/).
- *  So, to get the functionality intended by the apparent pass-by-reference and then update-in-place
- *  implementation of the API Get functions, one needs to write C++ wrappers to be bound instead of the 
- *  Get functions themselves. To work with Python, they need to return the get!
+ *  This wrapping scheme is necessary because Python is neither pass by reference nor pass by 
+ *  value, but is instead "pass by assignment" (ref: https://realpython.com/python-pass-by-reference/).
+ *  So, to get the functionality intended by the apparent pass-by-reference and then update-in-place
+ *  implementation of the API Get functions, one needs to write C++ wrappers to be bound instead of the 
+ *  Get functions themselves. To work with Python, they need to return the get!
+ *
+ *  Metadata (see IsMetadataCommand()) is served from the per-simulation metadata cache.
+ */
+
+// ----------------------------------------------------------------------------------------------------- //
+
+///
+/// \fn std::vector<double> GetDoubleArray(
+///         std::string unique_simulation_label,
+///         int command,
+///         std::string dobject_name,
+///         size_t n_elements
+///     )
+///
+/// \brief Wrapper on ProteusDSAPI::GetDoubleArray that creates and returns the desired
+///     std::vector<double>.
+///
+/// \param unique_simulation_label The API label for the target simulation.
+///
+/// \param command Defines the attribute of interest (resolved by the PDSAPI::PDSAPI 
+///     enumeration).
+///
+/// \param dobject_name Defines the dobject of interest.
+///
+/// \param n_elements Defines the size of the std::vector<double> to be returned.
+///
+/// \return The desired std::vector<double>.
+///
+
+std::vector<double> GetDoubleArray(
+    std::string unique_simulation_label,
+    int command,
+    std::string dobject_name,
+    size_t n_elements
+)
+{
+    SimulationGuard simulation_guard(unique_simulation_label);
+    PDSAPI_TIME_CALL(FN_GET_DOUBLE_ARRAY, command, dobject_name);
+    
+    auto get = [&]() {
+        std::vector<double> return_vector(n_elements, 0);
+        PDSAPI_TIMED(ProteusDSAPI::GetDoubleArray(unique_simulation_label, command, dobject_name, return_vector));
+        
+        return return_vector;
+    };
+    
+    if (IsMetadataCommand(command)) {
+        return GetMetadata<std::vector<double>>(
+            FN_GET_DOUBLE_ARRAY,
+            unique_simulation_label,
+            command,
+            dobject_name,
+            n_elements,
+            get
+        );
+    }
+    
+    return get();
+}   /* GetDoubleArray() */
+
+// ----------------------------------------------------------------------------------------------------- //
+
+
+
+// ----------------------------------------------------------------------------------------------------- //
+
+///
+/// \fn double GetDouble(
+///         std::string unique_simulation_label,
+///         int command,
+///         std::string dobject_name
+///     )
+///
+/// \brief Wrapper on ProteusDSAPI::GetDouble that creates and returns the desired
+///     double.
+///
+/// \param unique_simulation_label The API label for the target simulation.
+///
+/// \param command Defines the attribute of interest (resolved by the PDSAPI::PDSAPI 
+///     enumeration).
+///
+/// \param dobject_name Defines the dobject of interest.
+///
+/// \return The desired double.
+///
+
+double GetDouble(
+    std::string unique_simulation_label,
+    int command,
+    std::string dobject_name
+)
+{
+    SimulationGuard simulation_guard(unique_simulation_label);
+    PDSAPI_TIME_CALL(FN_GET_DOUBLE, command, dobject_name);
+    
+    auto get = [&]() {
+        double return_double = 0;
+        PDSAPI_TIMED(ProteusDSAPI::GetDouble(unique_simulation_label, command, dobject_name, return_double));
+        
+        return return_double;
+    };
+    
+    if (IsMetadataCommand(command)) {
+        return GetMetadata<double>(FN_GET_DOUBLE, unique_simulation_label, command, dobject_name, 0, get);
+    }
+    
+    return get();
+}   /* GetDouble() */
+
+// ----------------------------------------------------------------------------------------------------- //
+
+
+
+// ----------------------------------------------------------------------------------------------------- //
+
+///
+/// \fn std::vector<double> GetIntArray(
+///         std::string unique_simulation_label,
+///         int command,
+///         std::string dobject_name,
+///         size_t n_elements
+///     )
+///
+/// \brief Wrapper on ProteusDSAPI::GetIntArray that creates and returns the desired
+///     std::vector<int>.
+///
+/// \param unique_simulation_label The API label for the target simulation.
+///
+/// \param command Defines the attribute of interest (resolved by the PDSAPI::PDSAPI 
+///     enumeration).
+///
+/// \param dobject_name Defines the dobject of interest.
+///
+/// \param n_elements Defines the size of the std::vector<int> to be returned.
+///
+/// \return The desired std::vector<int>.
+///
+
+std::vector<int> GetIntArray(
+    std::string unique_simulation_label,
+    int command,
+    std::string dobject_name,
+    size_t n_elements
+)
+{
+    SimulationGuard simulation_guard(unique_simulation_label);
+    PDSAPI_TIME_CALL(FN_GET_INT_ARRAY, command, dobject_name);
+    
+    auto get = [&]() {
+        std::vector<int> return_vector(n_elements, 0);
+        PDSAPI_TIMED(ProteusDSAPI::GetIntArray(unique_simulation_label, command, dobject_name, return_vector));
+        
+        return return_vector;
+    };
+    
+    if (IsMetadataCommand(command)) {
+        return GetMetadata<std::vector<int>>(
+            FN_GET_INT_ARRAY,
+            unique_simulation_label,
+            command,
+            dobject_name,
+            n_elements,
+            get
+        );
+    }
+    
+    return get();
+}   /* GetIntArray() */
+
+// ----------------------------------------------------------------------------------------------------- //
+
+
+
+// ----------------------------------------------------------------------------------------------------- //
+
+///
+/// \fn double GetInt(
+///         std::string unique_simulation_label,
+///         int command,
+///         std::string dobject_name
+///     )
+///
+/// \brief Wrapper on ProteusDSAPI::GetInt that creates and returns the desired
+///     int.
+///
+/// \param unique_simulation_label The API label for the target simulation.
+///
+/// \param command Defines the attribute of interest (resolved by the PDSAPI::PDSAPI 
+///     enumeration).
+///
+/// \param dobject_name Defines the dobject of interest.
+///
+/// \return The desired int.
+///
+
+double GetInt(
+    std::string unique_simulation_label,
+    int command,
+    std::string dobject_name
+)
+{
+    SimulationGuard simulation_guard(unique_simulation_label);
+    PDSAPI_TIME_CALL(FN_GET_INT, command, dobject_name);
+    
+    auto get = [&]() {
+        int return_int = 0;
+        PDSAPI_TIMED(ProteusDSAPI::GetInt(unique_simulation_label, command, dobject_name, return_int));
+        
+        return return_int;
+    };
+    
+    if (IsMetadataCommand(command)) {
+        return GetMetadata<int>(FN_GET_INT, unique_simulation_label, command, dobject_name, 0, get);
+    }
+    
+    return get();
+}   /* GetInt() */
+
+// ----------------------------------------------------------------------------------------------------- //
+
+
+
+// ----------------------------------------------------------------------------------------------------- //
+
+///
+/// \fn double GetString(
+///         std::string unique_simulation_label,
+///         int command,
+///         std::string dobject_name
+///     )
+///
+/// \brief Wrapper on ProteusDSAPI::GetString that creates and returns the desired
+///     std::string.
+///
+/// \param unique_simulation_label The API label for the target simulation.
+///
+/// \param command Defines the attribute of interest (resolved by the PDSAPI::PDSAPI 
+///     enumeration).
+///
+/// \param dobject_name Defines the dobject of interest.
+///
+/// \return The desired std::string.
+///
+
+std::string GetString(
+    std::string unique_simulation_label,
+    int command,
+    std::string dobject_name
+) 
+{
+    SimulationGuard simulation_guard(unique_simulation_label);
+    PDSAPI_TIME_CALL(FN_GET_STRING, command, dobject_name);
+    
+    auto get = [&]() {
+        std::string return_string = "";
+        PDSAPI_TIMED(ProteusDSAPI::GetString(unique_simulation_label, command, dobject_name, return_string));
+        
+        return return_string;
+    };
+    
+    if (IsMetadataCommand(command)) {
+        return GetMetadata<std::string>(FN_GET_STRING, unique_simulation_label, command, dobject_name, 0, get);
+    }
+    
+    return get();
+}   /* GetString() */
+
+// ----------------------------------------------------------------------------------------------------- //
+
+
+
+// ----------------------------------------------------------------------------------------------------- //
+
+///
+/// \fn std::string GetErrorMessage(std::string unique_simulation_label)
+///
+/// \brief Wrapper on ProteusDSAPI::GetErrorMessage that creates and returns the desired
+///     std::string (i.e., the error message).
+///
+/// \param unique_simulation_label The API label for the target simulation.
+///
+/// \return The desired error message (std::string).
+///
+
+std::string GetErrorMessage(std::string unique_simulation_label)
+{
+    SimulationGuard simulation_guard(unique_simulation_label);
+    PDSAPI_TIME_CALL(FN_GET_ERROR_MESSAGE, -1, "");
+    
+    std::string error_message = "";
+    PDSAPI_TIMED(ProteusDSAPI::GetErrorMessage(unique_simulation_label, error_message));
+    
+    return error_message;
+}   /* GetErrorMessage() */
+
+// ----------------------------------------------------------------------------------------------------- //
+
+// ==== END Get wrappers =============================================================================== //
+
+
+
+// ==== NumPy wrappers ================================================================================= //
+
+/*
+ *  These wrappers are overloads of the Get/Set array wrappers (above) that work directly on a
+ *  caller-owned, preallocated numpy.ndarray. The API itself still insists on a std::vector, so a 
+ *  thread-local scratch vector is handed to the API instead; once the largest request has been 
+ *  seen, its capacity is retained and a steady-state loop makes no heap allocations (just a memcpy
+ *  into/out of the array).
+ */
+
+// ----------------------------------------------------------------------------------------------------- //
+
+///
+/// \fn template <typename T> std::vector<T>& Scratch(size_t n_elements)
+///
+/// \brief Returns a thread-local scratch std::vector<T>, resized to n_elements. Capacity
+///     is retained between calls.
+///
+/// \param n_elements The required size of the scratch vector.
+///
+/// \return A reference to the (thread-local) scratch vector.
+///
+
+template <typename T>
+std::vector<T>& Scratch(size_t n_elements)
+{
+    static thread_local std::vector<T> scratch_vector;
+    scratch_vector.resize(n_elements);
+    
+    return scratch_vector;
+}   /* Scratch() */
+
+// ----------------------------------------------------------------------------------------------------- //
+
+
+
+// ----------------------------------------------------------------------------------------------------- //
+
+///
+/// \fn void GetDoubleArrayNumPy(
+///         std::string unique_simulation_label,
+///         int command,
+///         std::string dobject_name,
+///         pybind11::array_t<double, pybind11::array::c_style> out
+///     )
+///
+/// \brief Wrapper on ProteusDSAPI::GetDoubleArray that fills the given (C-contiguous,
+///     float64, writeable) numpy.ndarray in place. All out.size elements are requested.
+///
+/// \param unique_simulation_label The API label for the target simulation.
+///
+/// \param command Defines the attribute of interest (resolved by the PDSAPI::PDSAPI 
+///     enumeration).
+///
+/// \param dobject_name Defines the dobject of interest.
+///
+/// \param out The numpy.ndarray to be filled.
+///
+
+void GetDoubleArrayNumPy(
+    std::string unique_simulation_label,
+    int command,
+    std::string dobject_name,
+    pybind11::array_t<double, pybind11::array::c_style> out
+)
+{
+    SimulationGuard simulation_guard(unique_simulation_label);
+    PDSAPI_TIME_CALL(FN_GET_DOUBLE_ARRAY_NUMPY, command, dobject_name);
+    
+    double* out_ptr = out.mutable_data();
+    std::vector<double>& buffer = Scratch<double>(out.size());
+    
+    PDSAPI_TIMED(ProteusDSAPI::GetDoubleArray(unique_simulation_label, command, dobject_name, buffer));
+    
+    size_t n_copy = std::min(buffer.size(), (size_t)out.size());
+    std::memcpy(out_ptr, buffer.data(), n_copy * sizeof(double));
+    
+    return;
+}   /* GetDoubleArrayNumPy() */
+
+// ----------------------------------------------------------------------------------------------------- //
+
+
+
+// ----------------------------------------------------------------------------------------------------- //
+
+///
+/// \fn void GetIntArrayNumPy(
+///         std::string unique_simulation_label,
+///         int command,
+///         std::string dobject_name,
+///         pybind11::array_t<int, pybind11::array::c_style> out
+///     )
+///
+/// \brief Wrapper on ProteusDSAPI::GetIntArray that fills the given (C-contiguous,
+///     numpy.intc, writeable) numpy.ndarray in place. All out.size elements are requested.
+///
+/// \param unique_simulation_label The API label for the target simulation.
+///
+/// \param command Defines the attribute of interest (resolved by the PDSAPI::PDSAPI 
+///     enumeration).
+///
+/// \param dobject_name Defines the dobject of interest.
+///
+/// \param out The numpy.ndarray to be filled.
+///
+
+void GetIntArrayNumPy(
+    std::string unique_simulation_label,
+    int command,
+    std::string dobject_name,
+    pybind11::array_t<int, pybind11::array::c_style> out
+)
+{
+    SimulationGuard simulation_guard(unique_simulation_label);
+    PDSAPI_TIME_CALL(FN_GET_INT_ARRAY_NUMPY, command, dobject_name);
+    
+    int* out_ptr = out.mutable_data();
+    std::vector<int>& buffer = Scratch<int>(out.size());
+    
+    PDSAPI_TIMED(ProteusDSAPI::GetIntArray(unique_simulation_label, command, dobject_name, buffer));
+    
+    size_t n_copy = std::min(buffer.size(), (size_t)out.size());
+    std::memcpy(out_ptr, buffer.data(), n_copy * sizeof(int));
+    
+    return;
+}   /* GetIntArrayNumPy() */
+
+// ----------------------------------------------------------------------------------------------------- //
+
+
+
+// ----------------------------------------------------------------------------------------------------- //
+
+///
+/// \fn void SetDoubleArrayNumPy(
+///         std::string unique_simulation_label,
+///         int command,
+///         std::string dobject_name,
+///         pybind11::array_t<double, pybind11::array::c_style> values
+///     )
+///
+/// \brief Wrapper on ProteusDSAPI::SetDoubleArray that reads straight from the given
+///     (C-contiguous, float64) numpy.ndarray.
+///
+/// \param unique_simulation_label The API label for the target simulation.
+///
+/// \param command Defines the attribute of interest (resolved by the PDSAPI::PDSAPI 
+///     enumeration).
+///
+/// \param dobject_name Defines the dobject of interest.
+///
+/// \param values The numpy.ndarray of values to be set.
+///
+
+void SetDoubleArrayNumPy(
+    std::string unique_simulation_label,
+    int command,
+    std::string dobject_name,
+    pybind11::array_t<double, pybind11::array::c_style> values
+)
+{
+    SimulationGuard simulation_guard(unique_simulation_label);
+    PDSAPI_TIME_CALL(FN_SET_DOUBLE_ARRAY_NUMPY, command, dobject_name);
+    
+    std::vector<double>& buffer = Scratch<double>(values.size());
+    std::memcpy(buffer.data(), values.data(), values.size() * sizeof(double));
+    
+    PDSAPI_TIMED(ProteusDSAPI::SetDoubleArray(unique_simulation_label, command, dobject_name, buffer));
+    NoteMetadataSet(unique_simulation_label, command);
+    
+    return;
+}   /* SetDoubleArrayNumPy() */
+
+// ----------------------------------------------------------------------------------------------------- //
+
+
+
+// ----------------------------------------------------------------------------------------------------- //
+
+///
+/// \fn void SetIntArrayNumPy(
+///         std::string unique_simulation_label,
+///         int command,
+///         std::string dobject_name,
+///         pybind11::array_t<int, pybind11::array::c_style> values
+///     )
+///
+/// \brief Wrapper on ProteusDSAPI::SetIntArray that reads straight from the given
+///     (C-contiguous, numpy.intc) numpy.ndarray.
+///
+/// \param unique_simulation_label The API label for the target simulation.
+///
+/// \param command Defines the attribute of interest (resolved by the PDSAPI::PDSAPI 
+///     enumeration).
+///
+/// \param dobject_name Defines the dobject of interest.
+///
+/// \param values The numpy.ndarray of values to be set.
+///
+
+void SetIntArrayNumPy(
+    std::string unique_simulation_label,
+    int command,
+    std::string dobject_name,
+    pybind11::array_t<int, pybind11::array::c_style> values
+)
+{
+    SimulationGuard simulation_guard(unique_simulation_label);
+    PDSAPI_TIME_CALL(FN_SET_INT_ARRAY_NUMPY, command, dobject_name);
+    
+    std::vector<int>& buffer = Scratch<int>(values.size());
+    std::memcpy(buffer.data(), values.data(), values.size() * sizeof(int));
+    
+    PDSAPI_TIMED(ProteusDSAPI::SetIntArray(unique_simulation_label, command, dobject_name, buffer));
+    NoteMetadataSet(unique_simulation_label, command);
+    
+    return;
+}   /* SetIntArrayNumPy() */
+
+// ----------------------------------------------------------------------------------------------------- //
+
+// ==== END NumPy wrappers ============================================================================= //
+
+
+
+// ==== Batched wrappers =============================================================================== //
+
+/*
+ *  These wrappers run a whole list of (command, dobject name, n_elements) requests against a single
+ *  simulation in one C++ loop, with the GIL released, into/out of one contiguous numpy.ndarray. 
+ *  This replaces N interpreter crossings (and N rounds of argument conversion) with one. By 
+ *  convention, an n_elements of 0 denotes a scalar attribute, which is handled by 
+ *  ProteusDSAPI::GetDouble/SetDouble and occupies a single slot in the array.
+ */
+
+typedef std::tuple<int, std::string, size_t> DoubleRequest;
+
+// ----------------------------------------------------------------------------------------------------- //
+
+///
+/// \fn std::vector<size_t> DoubleRequestOffsets(
+///         const std::vector<DoubleRequest>& requests,
+///         size_t n_available
+///     )
+///
+/// \brief Computes the offset of each request into a contiguous buffer, and checks that
+///     the buffer is big enough to hold all of them.
+///
+/// \param requests The (command, dobject name, n_elements) requests.
+///
+/// \param n_available The number of elements available in the buffer.
+///
+/// \return The offset of each request (one per request).
+///
+
+std::vector<size_t> DoubleRequestOffsets(
+    const std::vector<DoubleRequest>& requests,
+    size_t n_available
+)
+{
+    std::vector<size_t> offsets(requests.size(), 0);
+    size_t n_required = 0;
+    
+    for (size_t i = 0; i < requests.size(); i++) {
+        offsets[i] = n_required;
+        n_required += std::max(std::get<2>(requests[i]), (size_t)1);
+    }
+    
+    if (n_required > n_available) {
+        std::string error_str = "ERROR: batched request requires " + std::to_string(n_required);
+        error_str += " elements, but the given array only has " + std::to_string(n_available);
+        
+        throw std::invalid_argument(error_str);
+    }
+    
+    return offsets;
+}   /* DoubleRequestOffsets() */
+
+// ----------------------------------------------------------------------------------------------------- //
+
+
+
+// ----------------------------------------------------------------------------------------------------- //
+
+///
+/// \fn void GatherDoublesInto(
+///         const std::string& unique_simulation_label,
+///         const std::vector<DoubleRequest>& requests,
+///         const std::vector<size_t>& offsets,
+///         double* out_ptr
+///     )
+///
+/// \brief Helper function which runs ProteusDSAPI::GetDoubleArray (or GetDouble) for each
+///     request, in order, packing the results into out_ptr at the given offsets. Does not
+///     touch the GIL.
+///
+/// \param unique_simulation_label The API label for the target simulation.
+///
+/// \param requests The (command, dobject name, n_elements) requests.
+///
+/// \param offsets The offset of each request (as per DoubleRequestOffsets()).
+///
+/// \param out_ptr Pointer to the buffer to be filled.
+///
+
+void GatherDoublesInto(
+    const std::string& unique_simulation_label,
+    const std::vector<DoubleRequest>& requests,
+    const std::vector<size_t>& offsets,
+    double* out_ptr
+)
+{
+    for (size_t i = 0; i < requests.size(); i++) {
+        int command = std::get<0>(requests[i]);
+        const std::string& dobject_name = std::get<1>(requests[i]);
+        size_t n_elements = std::get<2>(requests[i]);
+        
+        if (n_elements == 0) {
+            PDSAPI_TIMED(ProteusDSAPI::GetDouble(unique_simulation_label, command, dobject_name, out_ptr[offsets[i]]));
+        }
+        
+        else {
+            std::vector<double>& buffer = Scratch<double>(n_elements);
+            PDSAPI_TIMED(ProteusDSAPI::GetDoubleArray(unique_simulation_label, command, dobject_name, buffer));
+            
+            size_t n_copy = std::min(buffer.size(), n_elements);
+            std::memcpy(out_ptr + offsets[i], buffer.data(), n_copy * sizeof(double));
+        }
+    }
+    
+    return;
+}   /* GatherDoublesInto() */
+
+// ----------------------------------------------------------------------------------------------------- //
+
+
+
+// ----------------------------------------------------------------------------------------------------- //
+
+///
+/// \fn std::vector<size_t> GatherDoubles(
+///         std::string unique_simulation_label,
+///         std::vector<DoubleRequest> requests,
+///         pybind11::array_t<double, pybind11::array::c_style> out
+///     )
+///
+/// \brief Runs ProteusDSAPI::GetDoubleArray (or GetDouble) for each request, in order 
+///     and with the GIL released, packing the results contiguously into out.
+///
+/// \param unique_simulation_label The API label for the target simulation.
+///
+/// \param requests The (command, dobject name, n_elements) requests.
+///
+/// \param out The numpy.ndarray to be filled.
+///
+/// \return The offset of each request into out.
+///
+
+std::vector<size_t> GatherDoubles(
+    std::string unique_simulation_label,
+    std::vector<DoubleRequest> requests,
+    pybind11::array_t<double, pybind11::array::c_style> out
+)
+{
+    SimulationGuard simulation_guard(unique_simulation_label);
+    PDSAPI_TIME_CALL(FN_GATHER_DOUBLES, -1, "");
+    
+    std::vector<size_t> offsets = DoubleRequestOffsets(requests, out.size());
+    double* out_ptr = out.mutable_data();
+    
+    {
+        pybind11::gil_scoped_release release;
+        GatherDoublesInto(unique_simulation_label, requests, offsets, out_ptr);
+    }
+    
+    return offsets;
+}   /* GatherDoubles() */
+
+// ----------------------------------------------------------------------------------------------------- //
+
+
+
+// ----------------------------------------------------------------------------------------------------- //
+
+///
+/// \fn std::vector<size_t> ScatterDoubles(
+///         std::string unique_simulation_label,
+///         std::vector<DoubleRequest> requests,
+///         pybind11::array_t<double, pybind11::array::c_style> values
+///     )
+///
+/// \brief Runs ProteusDSAPI::SetDoubleArray (or SetDouble) for each request, in order 
+///     and with the GIL released, unpacking the values contiguously from values.
+///
+/// \param unique_simulation_label The API label for the target simulation.
+///
+/// \param requests The (command, dobject name, n_elements) requests.
+///
+/// \param values The numpy.ndarray of packed values to be set.
+///
+/// \return The offset of each request into values.
+///
+
+std::vector<size_t> ScatterDoubles(
+    std::string unique_simulation_label,
+    std::vector<DoubleRequest> requests,
+    pybind11::array_t<double, pybind11::array::c_style> values
+)
+{
+    SimulationGuard simulation_guard(unique_simulation_label);
+    PDSAPI_TIME_CALL(FN_SCATTER_DOUBLES, -1, "");
+    
+    std::vector<size_t> offsets = DoubleRequestOffsets(requests, values.size());
+    const double* values_ptr = values.data();
+    
+    {
+        pybind11::gil_scoped_release release;
+        
+        for (size_t i = 0; i < requests.size(); i++) {
+            int command = std::get<0>(requests[i]);
+            const std::string& dobject_name = std::get<1>(requests[i]);
+            size_t n_elements = std::get<2>(requests[i]);
+            
+            if (n_elements == 0) {
+                PDSAPI_TIMED(ProteusDSAPI::SetDouble(
+                    unique_simulation_label,
+                    command,
+                    dobject_name,
+                    values_ptr[offsets[i]]
+                ));
+            }
+            
+            else {
+                std::vector<double>& buffer = Scratch<double>(n_elements);
+                std::memcpy(buffer.data(), values_ptr + offsets[i], n_elements * sizeof(double));
+                
+                PDSAPI_TIMED(ProteusDSAPI::SetDoubleArray(unique_simulation_label, command, dobject_name, buffer));
+            }
+            
+            NoteMetadataSet(unique_simulation_label, command);
+        }
+    }
+    
+    return offsets;
+}   /* ScatterDoubles() */
+
+// ----------------------------------------------------------------------------------------------------- //
+
+// ==== END Batched wrappers =========================================================================== //
+
+
+
+// ==== Handles and plans ============================================================================== //
+
+/*
+ *  The free function wrappers take the simulation label and dobject name as strings on every
+ *  call. The classes here resolve those names once (validating dobject names against 
+ *  PDSAPI::dObjectNames, and interning all strings), and then a RequestPlan freezes a fixed set of
+ *  (handle, command, n_elements) reads and writes so that RequestPlan::execute() does no string 
+ *  work (or argument conversion) at all. This is the layer a hot loop should talk to.
+ */
+
+// ----------------------------------------------------------------------------------------------------- //
+
+///
+/// \fn const std::string* InternString(const std::string& input_string)
+///
+/// \brief Interns the given string. The returned pointer is stable for the life of the
+///     module, so handles can hold onto it (rather than a copy).
+///
+/// \param input_string The string to intern.
+///
+/// \return A pointer to the interned copy of the given string.
+///
+
+const std::string* InternString(const std::string& input_string)
+{
+    static std::mutex intern_mutex;
+    static std::unordered_set<std::string> intern_set;
+    
+    std::lock_guard<std::mutex> lock(intern_mutex);
+    
+    return &(*(intern_set.insert(input_string).first));
+}   /* InternString() */
+
+// ----------------------------------------------------------------------------------------------------- //
+
+
+
+// ----------------------------------------------------------------------------------------------------- //
+
+///
+/// \fn std::vector<std::string> ParseNameList(const std::string& name_list_string)
+///
+/// \brief Parses a comma-separated list (as returned for PDSAPI::dObjectNames and 
+///     PDSAPI::dObjectTypes, including the trailing comma) into a std::vector.
+///
+/// \param name_list_string The comma-separated list.
+///
+/// \return A std::vector of the listed names.
+///
+
+std::vector<std::string> ParseNameList(const std::string& name_list_string)
+{
+    std::vector<std::string> name_vector;
+    size_t start = 0;
+    
+    while (start < name_list_string.size()) {
+        size_t end = name_list_string.find(',', start);
+        
+        if (end == std::string::npos) {
+            end = name_list_string.size();
+        }
+        
+        name_vector.push_back(name_list_string.substr(start, end - start));
+        start = end + 1;
+    }
+    
+    return name_vector;
+}   /* ParseNameList() */
+
+// ----------------------------------------------------------------------------------------------------- //
+
+
+
+// ----------------------------------------------------------------------------------------------------- //
+
+///
+/// \fn std::vector<std::string> GetNameList(const std::string& unique_simulation_label, int command)
+///
+/// \brief Returns the parsed PDSAPI::dObjectNames or dObjectTypes list of the given 
+///     simulation, by way of the metadata cache.
+///
+/// \param unique_simulation_label The API label for the target simulation.
+///
+/// \param command Either PDSAPI::dObjectNames or PDSAPI::dObjectTypes.
+///
+/// \return The parsed list.
+///
+
+std::vector<std::string> GetNameList(const std::string& unique_simulation_label, int command)
+{
+    return GetMetadata<std::vector<std::string>>(
+        command == PDSAPI::PDSAPI::dObjectNames ? FN_GET_DOBJECT_NAMES : FN_GET_DOBJECT_TYPES,
+        unique_simulation_label,
+        command,
+        "",
+        0,
+        [&]() { return ParseNameList(GetString(unique_simulation_label, command, "")); }
+    );
+}   /* GetNameList() */
+
+// ----------------------------------------------------------------------------------------------------- //
+
+
+
+// ----------------------------------------------------------------------------------------------------- //
+
+///
+/// \fn pybind11::tuple GetDObjectNames(std::string unique_simulation_label)
+///
+/// \brief Returns the dobject names of the given simulation as a tuple (i.e., 
+///     PDSAPI::dObjectNames, already parsed), by way of the metadata cache.
+///
+/// \param unique_simulation_label The API label for the target simulation.
+///
+/// \return The dobject names.
+///
+
+pybind11::tuple GetDObjectNames(std::string unique_simulation_label)
+{
+    SimulationGuard simulation_guard(unique_simulation_label);
+    PDSAPI_TIME_CALL(FN_GET_DOBJECT_NAMES, PDSAPI::PDSAPI::dObjectNames, "");
+    
+    std::vector<std::string> name_vector = GetNameList(unique_simulation_label, PDSAPI::PDSAPI::dObjectNames);
+    pybind11::tuple name_tuple(name_vector.size());
+    
+    for (size_t i = 0; i < name_vector.size(); i++) {
+        name_tuple[i] = pybind11::str(name_vector[i]);
+    }
+    
+    return name_tuple;
+}   /* GetDObjectNames() */
+
+// ----------------------------------------------------------------------------------------------------- //
+
+
+
+// ----------------------------------------------------------------------------------------------------- //
+
+///
+/// \fn pybind11::tuple GetDObjectTypes(std::string unique_simulation_label)
+///
+/// \brief Returns the dobject types of the given simulation as a tuple (i.e., 
+///     PDSAPI::dObjectTypes, already parsed), by way of the metadata cache.
+///
+/// \param unique_simulation_label The API label for the target simulation.
+///
+/// \return The dobject types.
+///
+
+pybind11::tuple GetDObjectTypes(std::string unique_simulation_label)
+{
+    SimulationGuard simulation_guard(unique_simulation_label);
+    PDSAPI_TIME_CALL(FN_GET_DOBJECT_TYPES, PDSAPI::PDSAPI::dObjectTypes, "");
+    
+    std::vector<std::string> type_vector = GetNameList(unique_simulation_label, PDSAPI::PDSAPI::dObjectTypes);
+    pybind11::tuple type_tuple(type_vector.size());
+    
+    for (size_t i = 0; i < type_vector.size(); i++) {
+        type_tuple[i] = pybind11::str(type_vector[i]);
+    }
+    
+    return type_tuple;
+}   /* GetDObjectTypes() */
+
+// ----------------------------------------------------------------------------------------------------- //
+
+
+
+// ----------------------------------------------------------------------------------------------------- //
+
+///
+/// \fn void RefreshMetadata(std::string unique_simulation_label)
+///
+/// \brief Forgets all cached metadata of the given simulation, so that it is re-read from
+///     the API on next use (e.g., after changing it in some way the bindings cannot see).
+///
+/// \param unique_simulation_label The API label for the target simulation.
+///
+
+void RefreshMetadata(std::string unique_simulation_label)
+{
+    SimulationGuard simulation_guard(unique_simulation_label);
+    PDSAPI_TIME_CALL(FN_REFRESH_METADATA, -1, "");
+    
+    ForgetMetadata(unique_simulation_label);
+    
+    return;
+}   /* RefreshMetadata() */
+
+// ----------------------------------------------------------------------------------------------------- //
+
+
+
+// ----------------------------------------------------------------------------------------------------- //
+
+///
+/// \class DObjectHandle
+///
+/// \brief A resolved (validated and interned) reference to a dobject in a simulation. 
+///     Created by way of Simulation::dobject(). The empty name refers to the simulation 
+///     itself (e.g., for simulation and environment parameters).
+///
+
+class DObjectHandle {
+    public:
+        const std::string* unique_simulation_label_ptr;
+        const std::string* dobject_name_ptr;
+        std::string dobject_type;
+        
+        const std::string& label(void) const { return *(this->unique_simulation_label_ptr); }
+        const std::string& name(void) const { return *(this->dobject_name_ptr); }
+};  /* DObjectHandle */
+
+// ----------------------------------------------------------------------------------------------------- //
+
+
+
+// ----------------------------------------------------------------------------------------------------- //
+
+///
+/// \class Simulation
+///
+/// \brief A resolved (interned) reference to an initialized simulation, which also holds 
+///     the dobject names and types (as of construction, or the last refresh()).
+///
+
+class Simulation {
+    public:
+        const std::string* unique_simulation_label_ptr;
+        std::vector<std::string> dobject_names;
+        std::vector<std::string> dobject_types;
+        std::vector<const std::string*> rigid_body_name_ptrs;
+        
+        Simulation(std::string);
+        
+        const std::string& label(void) const { return *(this->unique_simulation_label_ptr); }
+        
+        void refresh(void);
+        DObjectHandle dobject(std::string) const;
+        void advanceTime(double);
+};  /* Simulation */
+
+// ----------------------------------------------------------------------------------------------------- //
+
+
+
+// ----------------------------------------------------------------------------------------------------- //
+
+///
+/// \fn Simulation::Simulation(std::string unique_simulation_label)
+///
+/// \brief Constructor for the Simulation class. The simulation must already be 
+///     initialized (by way of InitializeProteusDS).
+///
+/// \param unique_simulation_label The API label for the target simulation.
+///
+
+Simulation::Simulation(std::string unique_simulation_label)
+{
+    this->unique_simulation_label_ptr = InternString(unique_simulation_label);
+    this->refresh();
+    
+    return;
+}   /* Simulation() */
+
+// ----------------------------------------------------------------------------------------------------- //
+
+
+
+// ----------------------------------------------------------------------------------------------------- //
+
+///
+/// \fn void Simulation::refresh(void)
+///
+/// \brief Forgets the simulation's cached metadata, and then re-reads the dobject names 
+///     and types from the API (and re-discovers the RigidBody dobjects).
+///
+
+void Simulation::refresh(void)
+{
+    RefreshMetadata(this->label());
+    
+    this->dobject_names = GetNameList(this->label(), PDSAPI::PDSAPI::dObjectNames);
+    this->dobject_types = GetNameList(this->label(), PDSAPI::PDSAPI::dObjectTypes);
+    
+    this->rigid_body_name_ptrs.clear();
+    
+    for (size_t i = 0; i < std::min(this->dobject_names.size(), this->dobject_types.size()); i++) {
+        if (this->dobject_types[i] == "RigidBody") {
+            this->rigid_body_name_ptrs.push_back(InternString(this->dobject_names[i]));
+        }
+    }
+    
+    return;
+}   /* refresh() */
+
+// ----------------------------------------------------------------------------------------------------- //
+
+
+
+// ----------------------------------------------------------------------------------------------------- //
+
+///
+/// \fn DObjectHandle Simulation::dobject(std::string dobject_name) const
+///
+/// \brief Resolves the given dobject name into a handle, throwing if the simulation has
+///     no such dobject.
+///
+/// \param dobject_name The name of the dobject of interest ("" for the simulation 
+///     itself).
+///
+/// \return A handle to the dobject of interest.
+///
+
+DObjectHandle Simulation::dobject(std::string dobject_name) const
+{
+    DObjectHandle handle;
+    handle.unique_simulation_label_ptr = this->unique_simulation_label_ptr;
+    handle.dobject_name_ptr = InternString(dobject_name);
+    
+    if (dobject_name.empty()) {
+        return handle;
+    }
+    
+    for (size_t i = 0; i < this->dobject_names.size(); i++) {
+        if (this->dobject_names[i] == dobject_name) {
+            if (i < this->dobject_types.size()) {
+                handle.dobject_type = this->dobject_types[i];
+            }
+            
+            return handle;
+        }
+    }
+    
+    std::string error_str = "ERROR: simulation " + this->label() + " has no dobject named ";
+    error_str += dobject_name;
+    
+    throw std::invalid_argument(error_str);
+}   /* dobject() */
+
+// ----------------------------------------------------------------------------------------------------- //
+
+
+
+// ----------------------------------------------------------------------------------------------------- //
+
+///
+/// \fn void Simulation::advanceTime(double dt)
+///
+/// \brief Moves the simulation ahead by dt (finite) seconds.
+///
+/// \param dt The time step [s].
+///
+
+void Simulation::advanceTime(double dt)
+{
+    SimulationGuard simulation_guard(this->label());
+    PDSAPI_TIME_CALL(FN_ADVANCE_TIME, -1, "");
+    
+    PDSAPI_TIMED(ProteusDSAPI::AdvanceTime(this->label(), dt));
+    
+    return;
+}   /* advanceTime() */
+
+// ----------------------------------------------------------------------------------------------------- //
+
+
+
+// ----------------------------------------------------------------------------------------------------- //
+
+///
+/// \enum PlanEntryType
+///
+/// \brief The API Get/Set flavour behind a RequestPlan entry.
+///
+
+enum PlanEntryType {
+    PLAN_DOUBLE_ARRAY,
+    PLAN_DOUBLE,
+    PLAN_INT
+};  /* PlanEntryType */
+
+
+///
+/// \struct PlanEntry
+///
+/// \brief A single frozen read or write in a RequestPlan. Each array entry owns the
+///     std::vector that is handed to the API, so execution allocates nothing.
+///
+
+struct PlanEntry {
+    PlanEntryType type;
+    const std::string* dobject_name_ptr;
+    int command;
+    size_t n_elements;
+    size_t offset;
+    std::vector<double> buffer;
+};  /* PlanEntry */
+
+// ----------------------------------------------------------------------------------------------------- //
+
+
+
+// ----------------------------------------------------------------------------------------------------- //
+
+///
+/// \class RequestPlan
+///
+/// \brief A frozen set of reads and writes against a single simulation. Reads are 
+///     packed into read_values, and writes are unpacked from write_values (both exposed to
+///     Python as numpy.ndarray views, without copying). Entries may only be added until the
+///     plan is frozen (which happens on first execution or first access to the values).
+///
+
+class RequestPlan {
+    private:
+        bool is_frozen;
+        
+        size_t addEntry(std::vector<PlanEntry>&, const DObjectHandle&, PlanEntryType, int, size_t);
+        
+    public:
+        const std::string* unique_simulation_label_ptr;
+        
+        std::vector<PlanEntry> reads;
+        std::vector<PlanEntry> writes;
+        
+        std::vector<double> read_values;
+        std::vector<double> write_values;
+        
+        RequestPlan(const Simulation&);
+        
+        const std::string& label(void) const { return *(this->unique_simulation_label_ptr); }
+        
+        size_t read(const DObjectHandle&, int, size_t);
+        size_t readInt(const DObjectHandle&, int);
+        size_t write(const DObjectHandle&, int, size_t);
+        size_t writeInt(const DObjectHandle&, int);
+        
+        void freeze(void);
+        void gather(void);
+        void scatter(void);
+        void execute(void);
+};  /* RequestPlan */
+
+// ----------------------------------------------------------------------------------------------------- //
+
+
+
+// ----------------------------------------------------------------------------------------------------- //
+
+///
+/// \fn RequestPlan::RequestPlan(const Simulation& simulation)
+///
+/// \brief Constructor for the RequestPlan class.
+///
+/// \param simulation The target simulation.
+///
+
+RequestPlan::RequestPlan(const Simulation& simulation)
+{
+    this->is_frozen = false;
+    this->unique_simulation_label_ptr = simulation.unique_simulation_label_ptr;
+    
+    return;
+}   /* RequestPlan() */
+
+// ----------------------------------------------------------------------------------------------------- //
+
+
+
+// ----------------------------------------------------------------------------------------------------- //
+
+///
+/// \fn size_t RequestPlan::addEntry(
+///         std::vector<PlanEntry>& entries,
+///         const DObjectHandle& handle,
+///         PlanEntryType type,
+///         int command,
+///         size_t n_elements
+///     )
+///
+/// \brief Helper method to append an entry to the given list of entries.
+///
+/// \param entries The list of entries (either reads or writes) to append to.
+///
+/// \param handle The dobject of interest.
+///
+/// \param type The API Get/Set flavour to use.
+///
+/// \param command Defines the attribute of interest (resolved by the PDSAPI::PDSAPI 
+///     enumeration).
+///
+/// \param n_elements The number of elements (for PLAN_DOUBLE_ARRAY entries).
+///
+/// \return The offset of the entry into the corresponding values.
+///
+
+size_t RequestPlan::addEntry(
+    std::vector<PlanEntry>& entries,
+    const DObjectHandle& handle,
+    PlanEntryType type,
+    int command,
+    size_t n_elements
+)
+{
+    if (this->is_frozen) {
+        throw std::runtime_error("ERROR: cannot add entries to a frozen RequestPlan");
+    }
+    
+    if (handle.unique_simulation_label_ptr != this->unique_simulation_label_ptr) {
+        std::string error_str = "ERROR: dobject handle belongs to simulation " + handle.label();
+        error_str += ", not " + this->label();
+        
+        throw std::invalid_argument(error_str);
+    }
+    
+    if (type == PLAN_DOUBLE_ARRAY && n_elements == 0) {
+        throw std::invalid_argument("ERROR: array entries require n_elements > 0");
+    }
+    
+    PlanEntry entry;
+    entry.type = type;
+    entry.dobject_name_ptr = handle.dobject_name_ptr;
+    entry.command = command;
+    entry.n_elements = (type == PLAN_DOUBLE_ARRAY) ? n_elements : 1;
+    entry.offset = entries.empty() ? 0 : entries.back().offset + entries.back().n_elements;
+    
+    if (type == PLAN_DOUBLE_ARRAY) {
+        entry.buffer.resize(n_elements, 0);
+    }
+    
+    entries.push_back(std::move(entry));
+    
+    return entries.back().offset;
+}   /* addEntry() */
+
+// ----------------------------------------------------------------------------------------------------- //
+
+
+
+// ----------------------------------------------------------------------------------------------------- //
+
+///
+/// \fn size_t RequestPlan::read(const DObjectHandle& handle, int command, size_t n_elements)
+///
+/// \brief Adds a read (GetDoubleArray, or GetDouble if n_elements is 0) to the plan.
+///
+/// \param handle The dobject of interest.
+///
+/// \param command Defines the attribute of interest (resolved by the PDSAPI::PDSAPI 
+///     enumeration).
+///
+/// \param n_elements The number of elements (0 for a scalar attribute).
+///
+/// \return The offset of the read into read_values.
+///
+
+size_t RequestPlan::read(const DObjectHandle& handle, int command, size_t n_elements)
+{
+    PlanEntryType type = (n_elements == 0) ? PLAN_DOUBLE : PLAN_DOUBLE_ARRAY;
+    
+    return this->addEntry(this->reads, handle, type, command, n_elements);
+}   /* read() */
+
+// ----------------------------------------------------------------------------------------------------- //
+
+
+
+// ----------------------------------------------------------------------------------------------------- //
+
+///
+/// \fn size_t RequestPlan::readInt(const DObjectHandle& handle, int command)
+///
+/// \brief Adds a read (GetInt) to the plan. The int is stored in read_values as a double.
+///
+/// \param handle The dobject of interest.
+///
+/// \param command Defines the attribute of interest (resolved by the PDSAPI::PDSAPI 
+///     enumeration).
+///
+/// \return The offset of the read into read_values.
+///
+
+size_t RequestPlan::readInt(const DObjectHandle& handle, int command)
+{
+    return this->addEntry(this->reads, handle, PLAN_INT, command, 1);
+}   /* readInt() */
+
+// ----------------------------------------------------------------------------------------------------- //
+
+
+
+// ----------------------------------------------------------------------------------------------------- //
+
+///
+/// \fn size_t RequestPlan::write(const DObjectHandle& handle, int command, size_t n_elements)
+///
+/// \brief Adds a write (SetDoubleArray, or SetDouble if n_elements is 0) to the plan.
+///
+/// \param handle The dobject of interest.
+///
+/// \param command Defines the attribute of interest (resolved by the PDSAPI::PDSAPI 
+///     enumeration).
+///
+/// \param n_elements The number of elements (0 for a scalar attribute).
+///
+/// \return The offset of the write into write_values.
+///
+
+size_t RequestPlan::write(const DObjectHandle& handle, int command, size_t n_elements)
+{
+    PlanEntryType type = (n_elements == 0) ? PLAN_DOUBLE : PLAN_DOUBLE_ARRAY;
+    
+    return this->addEntry(this->writes, handle, type, command, n_elements);
+}   /* write() */
+
+// ----------------------------------------------------------------------------------------------------- //
+
+
+
+// ----------------------------------------------------------------------------------------------------- //
+
+///
+/// \fn size_t RequestPlan::writeInt(const DObjectHandle& handle, int command)
+///
+/// \brief Adds a write (SetInt) to the plan. The int is taken from write_values (rounded
+///     to the nearest integer), so constant writes (e.g., 
+///     PDSAPI::rigidBodyClearForcesMoments) only need their value set once.
+///
+/// \param handle The dobject of interest.
+///
+/// \param command Defines the attribute of interest (resolved by the PDSAPI::PDSAPI 
+///     enumeration).
+///
+/// \return The offset of the write into write_values.
+///
+
+size_t RequestPlan::writeInt(const DObjectHandle& handle, int command)
+{
+    return this->addEntry(this->writes, handle, PLAN_INT, command, 1);
+}   /* writeInt() */
+
+// ----------------------------------------------------------------------------------------------------- //
+
+
+
+// ----------------------------------------------------------------------------------------------------- //
+
+///
+/// \fn void RequestPlan::freeze(void)
+///
+/// \brief Freezes the plan (no more entries may be added), and sizes the values.
+///
+
+void RequestPlan::freeze(void)
+{
+    if (this->is_frozen) {
+        return;
+    }
+    
+    this->is_frozen = true;
+    
+    if (!this->reads.empty()) {
+        this->read_values.resize(this->reads.back().offset + this->reads.back().n_elements, 0);
+    }
+    
+    if (!this->writes.empty()) {
+        this->write_values.resize(this->writes.back().offset + this->writes.back().n_elements, 0);
+    }
+    
+    return;
+}   /* freeze() */
+
+// ----------------------------------------------------------------------------------------------------- //
+
+
+
+// ----------------------------------------------------------------------------------------------------- //
+
+///
+/// \fn void RequestPlan::gather(void)
+///
+/// \brief Runs all reads, in order, packing the results into read_values.
+///
+
+void RequestPlan::gather(void)
+{
+    SimulationGuard simulation_guard(this->label());
+    PDSAPI_TIME_CALL(FN_REQUEST_PLAN_GATHER, -1, "");
+    
+    this->freeze();
+    
+    const std::string& unique_simulation_label = this->label();
+    double* values_ptr = this->read_values.data();
+    
+    for (PlanEntry& entry : this->reads) {
+        switch (entry.type) {
+            case (PLAN_DOUBLE_ARRAY): {
+                PDSAPI_TIMED(ProteusDSAPI::GetDoubleArray(
+                    unique_simulation_label,
+                    entry.command,
+                    *(entry.dobject_name_ptr),
+                    entry.buffer
+                ));
+                
+                size_t n_copy = std::min(entry.buffer.size(), entry.n_elements);
+                std::memcpy(values_ptr + entry.offset, entry.buffer.data(), n_copy * sizeof(double));
+                
+                break;
+            }
+            
+            case (PLAN_DOUBLE): {
+                PDSAPI_TIMED(ProteusDSAPI::GetDouble(
+                    unique_simulation_label,
+                    entry.command,
+                    *(entry.dobject_name_ptr),
+                    values_ptr[entry.offset]
+                ));
+                
+                break;
+            }
+            
+            case (PLAN_INT): {
+                int value = 0;
+                PDSAPI_TIMED(ProteusDSAPI::GetInt(
+                    unique_simulation_label,
+                    entry.command,
+                    *(entry.dobject_name_ptr),
+                    value
+                ));
+                
+                values_ptr[entry.offset] = value;
+                
+                break;
+            }
+        }
+    }
+    
+    return;
+}   /* gather() */
+
+// ----------------------------------------------------------------------------------------------------- //
+
+
+
+// ----------------------------------------------------------------------------------------------------- //
+
+///
+/// \fn void RequestPlan::scatter(void)
+///
+/// \brief Runs all writes, in order, unpacking the values from write_values.
+///
+
+void RequestPlan::scatter(void)
+{
+    SimulationGuard simulation_guard(this->label());
+    PDSAPI_TIME_CALL(FN_REQUEST_PLAN_SCATTER, -1, "");
+    
+    this->freeze();
+    
+    const std::string& unique_simulation_label = this->label();
+    const double* values_ptr = this->write_values.data();
+    
+    for (PlanEntry& entry : this->writes) {
+        switch (entry.type) {
+            case (PLAN_DOUBLE_ARRAY): {
+                std::memcpy(
+                    entry.buffer.data(),
+                    values_ptr + entry.offset,
+                    entry.n_elements * sizeof(double)
+                );
+                
+                PDSAPI_TIMED(ProteusDSAPI::SetDoubleArray(
+                    unique_simulation_label,
+                    entry.command,
+                    *(entry.dobject_name_ptr),
+                    entry.buffer
+                ));
+                
+                break;
+            }
+            
+            case (PLAN_DOUBLE): {
+                PDSAPI_TIMED(ProteusDSAPI::SetDouble(
+                    unique_simulation_label,
+                    entry.command,
+                    *(entry.dobject_name_ptr),
+                    values_ptr[entry.offset]
+                ));
+                
+                break;
+            }
+            
+            case (PLAN_INT): {
+                PDSAPI_TIMED(ProteusDSAPI::SetInt(
+                    unique_simulation_label,
+                    entry.command,
+                    *(entry.dobject_name_ptr),
+                    (int)round(values_ptr[entry.offset])
+                ));
+                
+                break;
+            }
+        }
+        
+        NoteMetadataSet(unique_simulation_label, entry.command);
+    }
+    
+    return;
+}   /* scatter() */
+
+// ----------------------------------------------------------------------------------------------------- //
+
+
+
+// ----------------------------------------------------------------------------------------------------- //
+
+///
+/// \fn void RequestPlan::execute(void)
+///
+/// \brief Runs all writes (scatter) and then all reads (gather).
+///
+
+void RequestPlan::execute(void)
+{
+    this->scatter();
+    this->gather();
+    
+    return;
+}   /* execute() */
+
+// ----------------------------------------------------------------------------------------------------- //
+
+// ==== END Handles and plans ========================================================================== //
+
+
+
+// ==== Controllers and step loop ====================================================================== //
+
+/*
+ *  This is the JointDampingExample.py loop (read state, compute a force, clear the force 
+ *  accumulator, apply the force, advance time) run entirely in C++, with the GIL released. A 
+ *  Controller computes its output in update(), and writes its (held) output in apply(); keeping
+ *  the two apart lets a loop re-apply held outputs without recomputing them. A Python callable can
+ *  optionally be called every N steps (e.g., for logging), with the GIL reacquired only then.
+ */
+
+// ----------------------------------------------------------------------------------------------------- //
+
+///
+/// \class Controller
+///
+/// \brief The (abstract) base class for compiled controllers. By default, a controller 
+///     reads the state of its dobject, and writes a [force, dforce/dt] pair to
+///     PDSAPI::rigidBodyJointForceAndDeriv.
+///
+
+class Controller {
+    public:
+        DObjectHandle handle;
+        bool clears_forces;
+        int output_command;
+        
+        std::vector<double> state;
+        std::vector<double> output;
+        
+        Controller(const DObjectHandle&);
+        Controller(const DObjectHandle&, size_t);
+        
+        void readState(void);
+        
+        virtual void reset(void) { return; }
+        virtual void update(double, double) = 0;
+        virtual void apply(void);
+        
+        virtual ~Controller(void) { return; }
+};  /* Controller */
+
+// ----------------------------------------------------------------------------------------------------- //
+
+
+
+// ----------------------------------------------------------------------------------------------------- //
+
+///
+/// \fn Controller::Controller(const DObjectHandle& handle)
+///
+/// \brief Constructor for the Controller class. Queries (once) the state size of the 
+///     dobject of interest.
+///
+/// \param handle The dobject of interest.
+///
+
+Controller::Controller(const DObjectHandle& handle)
+{
+    SimulationGuard simulation_guard(handle.label());
+    
+    this->handle = handle;
+    this->clears_forces = true;
+    this->output_command = PDSAPI::PDSAPI::rigidBodyJointForceAndDeriv;
+    
+    int state_size = 0;
+    PDSAPI_TIMED(ProteusDSAPI::GetInt(handle.label(), PDSAPI::PDSAPI::stateSize, handle.name(), state_size));
+    
+    this->state.resize(std::max(state_size, 2), 0);
+    this->output.resize(2, 0);
+    
+    return;
+}   /* Controller() */
+
+
+///
+/// \fn Controller::Controller(const DObjectHandle& handle, size_t state_size)
+///
+/// \brief Constructor for the Controller class, for controllers that do not read the 
+///     state of their dobject (so the state size is given, rather than queried).
+///
+/// \param handle The dobject of interest.
+///
+/// \param state_size The size of the state vector.
+///
+
+Controller::Controller(const DObjectHandle& handle, size_t state_size)
+{
+    this->handle = handle;
+    this->clears_forces = true;
+    this->output_command = PDSAPI::PDSAPI::rigidBodyJointForceAndDeriv;
+    
+    this->state.resize(state_size, 0);
+    this->output.resize(2, 0);
+    
+    return;
+}   /* Controller() */
+
+// ----------------------------------------------------------------------------------------------------- //
+
+
+
+// ----------------------------------------------------------------------------------------------------- //
+
+///
+/// \fn void Controller::readState(void)
+///
+/// \brief Reads the state of the dobject of interest into state.
+///
+
+void Controller::readState(void)
+{
+    PDSAPI_TIMED(ProteusDSAPI::GetDoubleArray(
+        this->handle.label(),
+        PDSAPI::PDSAPI::state,
+        this->handle.name(),
+        this->state
+    ));
+    
+    return;
+}   /* readState() */
+
+// ----------------------------------------------------------------------------------------------------- //
+
+
+
+// ----------------------------------------------------------------------------------------------------- //
+
+///
+/// \fn void Controller::apply(void)
+///
+/// \brief Writes the (held) output to the dobject of interest.
+///
+
+void Controller::apply(void)
+{
+    PDSAPI_TIMED(ProteusDSAPI::SetDoubleArray(
+        this->handle.label(),
+        this->output_command,
+        this->handle.name(),
+        this->output
+    ));
+    
+    return;
+}   /* apply() */
+
+// ----------------------------------------------------------------------------------------------------- //
+
+
+
+// ----------------------------------------------------------------------------------------------------- //
+
+///
+/// \class LinearJointDamping
+///
+/// \brief Joint damping force F = -c * v, where v is the joint velocity (state index 0).
+///     This is the force model of JointDampingExample.py.
+///
+
+class LinearJointDamping : public Controller {
+    public:
+        double damping_coefficient;
+        
+        LinearJointDamping(const DObjectHandle& handle, double damping_coefficient) :
+            Controller(handle), damping_coefficient(damping_coefficient) { return; }
+        
+        void update(double, double) override;
+};  /* LinearJointDamping */
+
+
+void LinearJointDamping::update(double /* time_s */, double /* dt_s */)
+{
+    this->readState();
+    this->output[0] = -1 * this->damping_coefficient * this->state[0];
+    
+    return;
+}   /* update() */
+
+// ----------------------------------------------------------------------------------------------------- //
+
+
+
+// ----------------------------------------------------------------------------------------------------- //
+
+///
+/// \class QuadraticJointDamping
+///
+/// \brief Joint damping force F = -c * v * |v|, where v is the joint velocity (state
+///     index 0).
+///
+
+class QuadraticJointDamping : public Controller {
+    public:
+        double damping_coefficient;
+        
+        QuadraticJointDamping(const DObjectHandle& handle, double damping_coefficient) :
+            Controller(handle), damping_coefficient(damping_coefficient) { return; }
+        
+        void update(double, double) override;
+};  /* QuadraticJointDamping */
+
+
+void QuadraticJointDamping::update(double /* time_s */, double /* dt_s */)
+{
+    this->readState();
+    this->output[0] = -1 * this->damping_coefficient * this->state[0] * fabs(this->state[0]);
+    
+    return;
+}   /* update() */
+
+// ----------------------------------------------------------------------------------------------------- //
+
+
+
+// ----------------------------------------------------------------------------------------------------- //
+
+///
+/// \class PIDController
+///
+/// \brief PID control of the given state index toward a set point, with the control
+///     effort applied as the joint force.
+///
+
+class PIDController : public Controller {
+    public:
+        size_t state_index;
+        double set_point;
+        double k_p;
+        double k_i;
+        double k_d;
+        
+        double error_integral;
+        double error_previous;
+        bool has_previous;
+        
+        PIDController(const DObjectHandle&, size_t, double, double, double, double);
+        
+        void reset(void) override;
+        void update(double, double) override;
+};  /* PIDController */
+
+
+PIDController::PIDController(
+    const DObjectHandle& handle,
+    size_t state_index,
+    double set_point,
+    double k_p,
+    double k_i,
+    double k_d
+) : Controller(handle)
+{
+    if (state_index >= this->state.size()) {
+        std::string error_str = "ERROR: state index " + std::to_string(state_index);
+        error_str += " is out of range for dobject " + handle.name();
+        
+        throw std::invalid_argument(error_str);
+    }
+    
+    this->state_index = state_index;
+    this->set_point = set_point;
+    this->k_p = k_p;
+    this->k_i = k_i;
+    this->k_d = k_d;
+    
+    this->reset();
+    
+    return;
+}   /* PIDController() */
+
+
+void PIDController::reset(void)
+{
+    this->error_integral = 0;
+    this->error_previous = 0;
+    this->has_previous = false;
+    
+    return;
+}   /* reset() */
+
+
+void PIDController::update(double /* time_s */, double dt_s)
+{
+    this->readState();
+    
+    double error = this->set_point - this->state[this->state_index];
+    double error_derivative = 0;
+    
+    if (this->has_previous && dt_s > 0) {
+        error_derivative = (error - this->error_previous) / dt_s;
+    }
+    
+    this->error_integral += error * dt_s;
+    this->error_previous = error;
+    this->has_previous = true;
+    
+    this->output[0] = this->k_p * error + this->k_i * this->error_integral +
+        this->k_d * error_derivative;
+    
+    return;
+}   /* update() */
+
+// ----------------------------------------------------------------------------------------------------- //
+
+
+
+// ----------------------------------------------------------------------------------------------------- //
+
+///
+/// \class TableForceController
+///
+/// \brief Joint force by (linear, clamped) table lookup on the given state index (e.g., a
+///     measured hydraulic force/velocity curve).
+///
+
+class TableForceController : public Controller {
+    public:
+        size_t state_index;
+        std::vector<double> x_table;
+        std::vector<double> force_table;
+        
+        TableForceController(
+            const DObjectHandle&,
+            size_t,
+            std::vector<double>,
+            std::vector<double>
+        );
+        
+        void update(double, double) override;
+};  /* TableForceController */
+
+
+TableForceController::TableForceController(
+    const DObjectHandle& handle,
+    size_t state_index,
+    std::vector<double> x_table,
+    std::vector<double> force_table
+) : Controller(handle)
+{
+    if (state_index >= this->state.size()) {
+        std::string error_str = "ERROR: state index " + std::to_string(state_index);
+        error_str += " is out of range for dobject " + handle.name();
+        
+        throw std::invalid_argument(error_str);
+    }
+    
+    if (x_table.empty() || x_table.size() != force_table.size()) {
+        throw std::invalid_argument("ERROR: lookup tables must be non-empty and of equal size");
+    }
+    
+    if (!std::is_sorted(x_table.begin(), x_table.end())) {
+        throw std::invalid_argument("ERROR: lookup table x values must be increasing");
+    }
+    
+    this->state_index = state_index;
+    this->x_table = x_table;
+    this->force_table = force_table;
+    
+    return;
+}   /* TableForceController() */
+
+
+void TableForceController::update(double /* time_s */, double /* dt_s */)
+{
+    this->readState();
+    
+    double x = this->state[this->state_index];
+    
+    if (x <= this->x_table.front()) {
+        this->output[0] = this->force_table.front();
+    }
+    
+    else if (x >= this->x_table.back()) {
+        this->output[0] = this->force_table.back();
+    }
+    
+    else {
+        size_t i = std::upper_bound(this->x_table.begin(), this->x_table.end(), x) -
+            this->x_table.begin();
+        
+        double weight = (x - this->x_table[i - 1]) / (this->x_table[i] - this->x_table[i - 1]);
+        
+        this->output[0] = (1 - weight) * this->force_table[i - 1] + weight * this->force_table[i];
+    }
+    
+    return;
+}   /* update() */
+
+// ----------------------------------------------------------------------------------------------------- //
+
+
+
+// ----------------------------------------------------------------------------------------------------- //
+
+///
+/// \fn void ClearForces(const std::vector<Controller*>& controllers)
+///
+/// \brief Clears the force accumulator (PDSAPI::rigidBodyClearForcesMoments) of each 
+///     distinct dobject written to by the given controllers, once.
+///
+/// \param controllers The controllers of interest.
+///
+
+void ClearForces(const std::vector<Controller*>& controllers)
+{
+    for (size_t i = 0; i < controllers.size(); i++) {
+        if (!controllers[i]->clears_forces) {
+            continue;
+        }
+        
+        bool is_duplicate = false;
+        
+        for (size_t j = 0; j < i; j++) {
+            if (
+                controllers[j]->clears_forces &&
+                controllers[j]->handle.dobject_name_ptr == controllers[i]->handle.dobject_name_ptr &&
+                controllers[j]->handle.unique_simulation_label_ptr == 
+                    controllers[i]->handle.unique_simulation_label_ptr
+            ) {
+                is_duplicate = true;
+                break;
+            }
+        }
+        
+        if (!is_duplicate) {
+            PDSAPI_TIMED(ProteusDSAPI::SetInt(
+                controllers[i]->handle.label(),
+                PDSAPI::PDSAPI::rigidBodyClearForcesMoments,
+                controllers[i]->handle.name(),
+                1
+            ));
+        }
+    }
+    
+    return;
+}   /* ClearForces() */
+
+// ----------------------------------------------------------------------------------------------------- //
+
+
+
+// ----------------------------------------------------------------------------------------------------- //
+
+///
+/// \class Observer
+///
+/// \brief The (abstract) base class for anything that samples the simulation after each
+///     time step (e.g., a Recorder).
+///
+
+class Observer {
+    public:
+        virtual void observe(double) = 0;
+        
+        virtual ~Observer(void) { return; }
+};  /* Observer */
+
+// ----------------------------------------------------------------------------------------------------- //
+
+
+
+// ----------------------------------------------------------------------------------------------------- //
+
+///
+/// \fn size_t RunLoop(
+///         const Simulation& simulation,
+///         double dt_s,
+///         double end_time_s,
+///         std::vector<Controller*> controllers,
+///         pybind11::object callback,
+///         size_t callback_every,
+///         std::vector<Observer*> observers
+///     )
+///
+/// \brief Runs the step loop (clear forces, update and apply controllers, advance time)
+///     from the current simulation time to end_time_s, with the GIL released.
+///
+/// \param simulation The target simulation.
+///
+/// \param dt_s The time step [s].
+///
+/// \param end_time_s The end time [s].
+///
+/// \param controllers The controllers to run at every step.
+///
+/// \param callback An optional Python callable, called as callback(time_s) every 
+///     callback_every steps. If it returns False, the loop stops.
+///
+/// \param callback_every The number of steps between callbacks.
+///
+/// \param observers The observers to run after every step.
+///
+/// \return The number of steps taken.
+///
+
+size_t RunLoop(
+    const Simulation& simulation,
+    double dt_s,
+    double end_time_s,
+    std::vector<Controller*> controllers,
+    pybind11::object callback,
+    size_t callback_every,
+    std::vector<Observer*> observers
+)
+{
+    SimulationGuard simulation_guard(simulation.label());
+    PDSAPI_TIME_CALL(FN_RUN_LOOP, -1, "");
+    
+    if (dt_s <= 0) {
+        throw std::invalid_argument("ERROR: time step must be > 0");
+    }
+    
+    for (Controller* controller : controllers) {
+        if (controller->handle.unique_simulation_label_ptr != simulation.unique_simulation_label_ptr) {
+            std::string error_str = "ERROR: controller belongs to simulation ";
+            error_str += controller->handle.label() + ", not " + simulation.label();
+            
+            throw std::invalid_argument(error_str);
+        }
+    }
+    
+    bool has_callback = (!callback.is_none()) && callback_every > 0;
+    size_t n_steps = 0;
+    
+    pybind11::gil_scoped_release release;
+    
+    double start_time_s = 0;
+    PDSAPI_TIMED(ProteusDSAPI::GetDouble(simulation.label(), PDSAPI::PDSAPI::time, "", start_time_s));
+    
+    double time_s = start_time_s;
+    
+    while (time_s < end_time_s - 1e-9 * dt_s) {
+        ClearForces(controllers);
+        
+        for (Controller* controller : controllers) {
+            controller->update(time_s, dt_s);
+            controller->apply();
+        }
+        
+        PDSAPI_TIMED(ProteusDSAPI::AdvanceTime(simulation.label(), dt_s));
+        
+        n_steps++;
+        time_s = start_time_s + n_steps * dt_s;
+        
+        for (Observer* observer : observers) {
+            observer->observe(time_s);
+        }
+        
+        if (has_callback && n_steps % callback_every == 0) {
+            pybind11::gil_scoped_acquire acquire;
+            pybind11::object result = callback(time_s);
+            
+            if ((!result.is_none()) && (!result.cast<bool>())) {
+                break;
+            }
+        }
+    }
+    
+    return n_steps;
+}   /* RunLoop() */
+
+// ----------------------------------------------------------------------------------------------------- //
+
+// ==== END Controllers and step loop ================================================================== //
+
+
+
+// ==== Schedulers ===================================================================================== //
+
+/*
+ *  A Scheduler runs controllers (and Python callbacks) at their own periods, e.g., a 1 kHz joint
+ *  damping law, a 50 Hz thruster allocator, and a 1 Hz mission planner. Rather than stepping at 
+ *  the fastest rate, it advances the simulation from one breakpoint to the next, where the 
+ *  breakpoints are the union of the tasks' due times (start + phase + k * period). At each 
+ *  breakpoint, only the tasks that are due are run (in order of decreasing priority), and then
+ *  the outputs of all controllers that have run so far are re-applied (i.e., zero-order hold), 
+ *  so that held forces survive the clearing of the force accumulator.
+ */
+
+// ----------------------------------------------------------------------------------------------------- //
+
+///
+/// \class CallbackController
+///
+/// \brief A controller whose update is a Python callable, callback(time, dt), returning the
+///     output (a sequence of floats, written to output_command on apply) or None (to hold the
+///     previous output).
+///
+
+class CallbackController : public Controller {
+    public:
+        pybind11::object callback;
+        
+        CallbackController(const DObjectHandle&, pybind11::object, int);
+        
+        void update(double, double) override;
+};  /* CallbackController */
+
+
+CallbackController::CallbackController(
+    const DObjectHandle& handle,
+    pybind11::object callback,
+    int output_command
+) : Controller(handle)
+{
+    this->callback = callback;
+    this->output_command = output_command;
+    
+    return;
+}   /* CallbackController() */
+
+
+void CallbackController::update(double time_s, double dt_s)
+{
+    pybind11::gil_scoped_acquire acquire;
+    pybind11::object result = this->callback(time_s, dt_s);
+    
+    if (!result.is_none()) {
+        this->output = result.cast<std::vector<double>>();
+    }
+    
+    return;
+}   /* update() */
+
+// ----------------------------------------------------------------------------------------------------- //
+
+
+
+// ----------------------------------------------------------------------------------------------------- //
+
+///
+/// \struct ScheduledTask
+///
+/// \brief A periodic task: either a controller, or a Python callable callback(time, dt) 
+///     (whose return value is ignored). The task is next due at 
+///     start + phase + n_periods * period.
+///
+
+struct ScheduledTask {
+    Controller* controller = nullptr;
+    pybind11::object callback;
+    
+    double period_s = 0;
+    double phase_s = 0;
+    int priority = 0;
+    
+    size_t n_periods = 0;
+    size_t n_runs = 0;
+    double last_run_time_s = 0;
+};  /* ScheduledTask */
+
+
+///
+/// \class Scheduler
+///
+/// \brief Multi-rate scheduler for the tasks of a single simulation.
+///
+
+class Scheduler {
+    public:
+        const std::string* unique_simulation_label_ptr;
+        
+        std::vector<ScheduledTask> tasks;
+        std::vector<size_t> run_order;
+        
+        std::atomic<bool> stop_requested;
+        size_t n_breakpoints;
+        
+        Scheduler(const Simulation&);
+        
+        const std::string& label(void) const { return *(this->unique_simulation_label_ptr); }
+        
+        size_t addController(Controller*, double, int, double);
+        size_t addCallback(pybind11::object, double, int, double);
+        
+        double tolerance(void) const;
+        double dueTime(const ScheduledTask&, double) const;
+        double nextBreakpoint(double, double) const;
+        void skipPast(ScheduledTask&, double, double) const;
+        
+        std::vector<double> breakpoints(double, double);
+        size_t run(double, std::vector<Observer*>);
+        void stop(void);
+};  /* Scheduler */
+
+
+Scheduler::Scheduler(const Simulation& simulation)
+{
+    this->unique_simulation_label_ptr = simulation.unique_simulation_label_ptr;
+    this->stop_requested = false;
+    this->n_breakpoints = 0;
+    
+    return;
+}   /* Scheduler() */
+
+// ----------------------------------------------------------------------------------------------------- //
+
+
+
+// ----------------------------------------------------------------------------------------------------- //
+
+///
+/// \fn size_t Scheduler::addController(
+///         Controller* controller,
+///         double period_s,
+///         int priority,
+///         double phase_s
+///     )
+///
+/// \brief Adds a controller task.
+///
+/// \param controller The controller (which must belong to the scheduler's simulation).
+///
+/// \param period_s The task period [s].
+///
+/// \param priority The task priority (higher runs first, ties in order added).
+///
+/// \param phase_s The task phase [s] (i.e., first due at start + phase).
+///
+/// \return The task index.
+///
+
+size_t Scheduler::addController(Controller* controller, double period_s, int priority, double phase_s)
+{
+    if (controller->handle.unique_simulation_label_ptr != this->unique_simulation_label_ptr) {
+        std::string error_str = "ERROR: controller belongs to simulation ";
+        error_str += controller->handle.label() + ", not " + this->label();
+        
+        throw std::invalid_argument(error_str);
+    }
+    
+    size_t task_index = this->addCallback(pybind11::none(), period_s, priority, phase_s);
+    this->tasks[task_index].controller = controller;
+    
+    return task_index;
+}   /* addController() */
+
+// ----------------------------------------------------------------------------------------------------- //
+
+
+
+// ----------------------------------------------------------------------------------------------------- //
+
+///
+/// \fn size_t Scheduler::addCallback(
+///         pybind11::object callback,
+///         double period_s,
+///         int priority,
+///         double phase_s
+///     )
+///
+/// \brief Adds a Python callback task, callback(time, dt).
+///
+/// \param callback The Python callable.
+///
+/// \param period_s The task period [s].
+///
+/// \param priority The task priority (higher runs first, ties in order added).
+///
+/// \param phase_s The task phase [s] (i.e., first due at start + phase).
+///
+/// \return The task index.
+///
+
+size_t Scheduler::addCallback(pybind11::object callback, double period_s, int priority, double phase_s)
+{
+    if (period_s <= 0) {
+        throw std::invalid_argument("ERROR: task period must be > 0");
+    }
+    
+    if (phase_s < 0) {
+        throw std::invalid_argument("ERROR: task phase must be >= 0");
+    }
+    
+    ScheduledTask task;
+    task.callback = callback;
+    task.period_s = period_s;
+    task.phase_s = phase_s;
+    task.priority = priority;
+    
+    this->tasks.push_back(task);
+    
+    //  stable, so ties run in the order added
+    this->run_order.push_back(this->tasks.size() - 1);
+    std::stable_sort(
+        this->run_order.begin(),
+        this->run_order.end(),
+        [this](size_t i, size_t j) { return this->tasks[i].priority > this->tasks[j].priority; }
+    );
+    
+    return this->tasks.size() - 1;
+}   /* addCallback() */
+
+// ----------------------------------------------------------------------------------------------------- //
+
+
+
+// ----------------------------------------------------------------------------------------------------- //
+
+///
+/// \fn double Scheduler::tolerance(void) const
+///
+/// \brief Returns the tolerance within which due times are considered coincident (a small
+///     fraction of the shortest period).
+///
+/// \return The tolerance [s].
+///
+
+double Scheduler::tolerance(void) const
+{
+    double min_period_s = INFINITY;
+    
+    for (const ScheduledTask& task : this->tasks) {
+        min_period_s = std::min(min_period_s, task.period_s);
+    }
+    
+    return 1e-6 * min_period_s;
+}   /* tolerance() */
+
+// ----------------------------------------------------------------------------------------------------- //
+
+
+
+// ----------------------------------------------------------------------------------------------------- //
+
+///
+/// \fn double Scheduler::dueTime(const ScheduledTask& task, double start_time_s) const
+///
+/// \brief Returns the time at which the given task is next due (computed from the start 
+///     time, rather than accumulated, so as not to drift).
+///
+/// \param task The task.
+///
+/// \param start_time_s The start time [s].
+///
+/// \return The due time [s].
+///
+
+double Scheduler::dueTime(const ScheduledTask& task, double start_time_s) const
+{
+    return start_time_s + task.phase_s + task.n_periods * task.period_s;
+}   /* dueTime() */
+
+// ----------------------------------------------------------------------------------------------------- //
+
+
+
+// ----------------------------------------------------------------------------------------------------- //
+
+///
+/// \fn void Scheduler::skipPast(ScheduledTask& task, double start_time_s, double time_s) const
+///
+/// \brief Advances the given task's due time past the given time.
+///
+/// \param task The task.
+///
+/// \param start_time_s The start time [s].
+///
+/// \param time_s The current time [s].
+///
+
+void Scheduler::skipPast(ScheduledTask& task, double start_time_s, double time_s) const
+{
+    double tolerance_s = this->tolerance();
+    
+    while (this->dueTime(task, start_time_s) <= time_s + tolerance_s) {
+        task.n_periods++;
+    }
+    
+    return;
+}   /* skipPast() */
+
+// ----------------------------------------------------------------------------------------------------- //
+
+
+
+// ----------------------------------------------------------------------------------------------------- //
+
+///
+/// \fn double Scheduler::nextBreakpoint(double start_time_s, double end_time_s) const
+///
+/// \brief Returns the next breakpoint, i.e. the earliest due time of any task (or the end 
+///     time, if sooner).
+///
+/// \param start_time_s The start time [s].
+///
+/// \param end_time_s The end time [s].
+///
+/// \return The next breakpoint [s].
+///
+
+double Scheduler::nextBreakpoint(double start_time_s, double end_time_s) const
+{
+    double breakpoint_s = end_time_s;
+    
+    for (const ScheduledTask& task : this->tasks) {
+        breakpoint_s = std::min(breakpoint_s, this->dueTime(task, start_time_s));
+    }
+    
+    return breakpoint_s;
+}   /* nextBreakpoint() */
+
+// ----------------------------------------------------------------------------------------------------- //
+
+
+
+// ----------------------------------------------------------------------------------------------------- //
+
+///
+/// \fn std::vector<double> Scheduler::breakpoints(double start_time_s, double end_time_s)
+///
+/// \brief Computes (without running anything) the breakpoints, i.e. the times to which the
+///     simulation would be advanced by run(), from the given start time to the given end time.
+///
+/// \param start_time_s The start time [s].
+///
+/// \param end_time_s The end time [s].
+///
+/// \return The breakpoints [s].
+///
+
+std::vector<double> Scheduler::breakpoints(double start_time_s, double end_time_s)
+{
+    std::vector<double> breakpoint_vector;
+    
+    if (this->tasks.empty()) {
+        return breakpoint_vector;
+    }
+    
+    double tolerance_s = this->tolerance();
+    double time_s = start_time_s;
+    
+    for (ScheduledTask& task : this->tasks) {
+        task.n_periods = 0;
+    }
+    
+    while (time_s < end_time_s - tolerance_s) {
+        for (ScheduledTask& task : this->tasks) {
+            this->skipPast(task, start_time_s, time_s);
+        }
+        
+        time_s = this->nextBreakpoint(start_time_s, end_time_s);
+        breakpoint_vector.push_back(time_s);
+    }
+    
+    return breakpoint_vector;
+}   /* breakpoints() */
+
+// ----------------------------------------------------------------------------------------------------- //
+
+
+
+// ----------------------------------------------------------------------------------------------------- //
+
+///
+/// \fn size_t Scheduler::run(double end_time_s, std::vector<Observer*> observers)
+///
+/// \brief Runs the schedule (with the GIL released, except for Python tasks) from the 
+///     current simulation time to the given end time, or until stop() is called.
+///
+/// \param end_time_s The end time [s].
+///
+/// \param observers Observers to call after each breakpoint (e.g., Recorders).
+///
+/// \return The number of breakpoints (i.e., of calls to ProteusDSAPI::AdvanceTime).
+///
+
+size_t Scheduler::run(double end_time_s, std::vector<Observer*> observers)
+{
+    SimulationGuard simulation_guard(this->label());
+    PDSAPI_TIME_CALL(FN_SCHEDULER_RUN, -1, "");
+    
+    if (this->tasks.empty()) {
+        throw std::invalid_argument("ERROR: no tasks to schedule");
+    }
+    
+    this->stop_requested = false;
+    this->n_breakpoints = 0;
+    
+    pybind11::gil_scoped_release release;
+    
+    double start_time_s = 0;
+    PDSAPI_TIMED(ProteusDSAPI::GetDouble(this->label(), PDSAPI::PDSAPI::time, "", start_time_s));
+    
+    double tolerance_s = this->tolerance();
+    double time_s = start_time_s;
+    
+    for (ScheduledTask& task : this->tasks) {
+        task.n_periods = 0;
+        task.n_runs = 0;
+    }
+    
+    std::vector<Controller*> held_controllers;
+    
+    while (time_s < end_time_s - tolerance_s) {
+        //  1. run the tasks that are due
+        for (size_t task_index : this->run_order) {
+            ScheduledTask& task = this->tasks[task_index];
+            
+            if (this->dueTime(task, start_time_s) > time_s + tolerance_s) {
+                continue;
+            }
+            
+            double dt_s = (task.n_runs > 0) ? time_s - task.last_run_time_s : task.period_s;
+            
+            if (task.controller != nullptr) {
+                task.controller->update(time_s, dt_s);
+                
+                if (task.n_runs == 0) {
+                    held_controllers.push_back(task.controller);
+                }
+            }
+            
+            else {
+                pybind11::gil_scoped_acquire acquire;
+                task.callback(time_s, dt_s);
+            }
+            
+            task.n_runs++;
+            task.last_run_time_s = time_s;
+            this->skipPast(task, start_time_s, time_s);
+        }
+        
+        if (this->stop_requested) {
+            break;
+        }
+        
+        //  2. zero-order hold (re-apply all held outputs)
+        ClearForces(held_controllers);
+        
+        for (Controller* controller : held_controllers) {
+            controller->apply();
+        }
+        
+        //  3. advance to the next breakpoint
+        double next_time_s = this->nextBreakpoint(start_time_s, end_time_s);
+        PDSAPI_TIMED(ProteusDSAPI::AdvanceTime(this->label(), next_time_s - time_s));
+        
+        this->n_breakpoints++;
+        time_s = next_time_s;
+        
+        for (Observer* observer : observers) {
+            observer->observe(time_s);
+        }
+    }
+    
+    return this->n_breakpoints;
+}   /* run() */
+
+// ----------------------------------------------------------------------------------------------------- //
+
+
+
+// ----------------------------------------------------------------------------------------------------- //
+
+///
+/// \fn void Scheduler::stop(void)
+///
+/// \brief Requests that run() return at the current breakpoint (e.g., from a Python task).
+///
+
+void Scheduler::stop(void)
+{
+    this->stop_requested = true;
+    
+    return;
+}   /* stop() */
+
+// ----------------------------------------------------------------------------------------------------- //
+
+// ==== END Schedulers ================================================================================= //
+
+
+
+// ==== Process pools ================================================================================== //
+
+/*
+ *  On POSIX platforms, work can be farmed out to fork()ed (copy-on-write) worker processes, with
+ *  results returned by way of an anonymous shared memory mapping. Since a forked child holds a 
+ *  copy of everything in the parent (including any initialized simulations), this both isolates 
+ *  API calls that are not safe to make from several threads at once, and lets many children 
+ *  continue on from a single initialized template. Children never touch Python; they exit by way 
+ *  of _exit(), so no Python finalization runs in them.
+ */
+
+#ifdef PDSAPI_BINDINGS_HAS_FORK
+
+#define PDSAPI_BINDINGS_ERROR_SLOT_SIZE 512
+
+// ----------------------------------------------------------------------------------------------------- //
+
+///
+/// \class SharedBuffer
+///
+/// \brief An anonymous, shared (i.e., visible across fork()) memory mapping. Zero filled
+///     on creation.
+///
+
+class SharedBuffer {
+    public:
+        void* ptr;
+        size_t n_bytes;
+        
+        SharedBuffer(size_t);
+        SharedBuffer(const SharedBuffer&) = delete;
+        SharedBuffer& operator=(const SharedBuffer&) = delete;
+        ~SharedBuffer(void);
+        
+        double* doubles(void) const { return (double*)(this->ptr); }
+        char* chars(void) const { return (char*)(this->ptr); }
+};  /* SharedBuffer */
+
+
+SharedBuffer::SharedBuffer(size_t n_bytes)
+{
+    this->n_bytes = std::max(n_bytes, (size_t)1);
+    this->ptr = mmap(
+        nullptr,
+        this->n_bytes,
+        PROT_READ | PROT_WRITE,
+        MAP_SHARED | MAP_ANONYMOUS,
+        -1,
+        0
+    );
+    
+    if (this->ptr == MAP_FAILED) {
+        throw std::runtime_error("ERROR: failed to map shared memory: " + std::string(strerror(errno)));
+    }
+    
+    return;
+}   /* SharedBuffer() */
+
+
+SharedBuffer::~SharedBuffer(void)
+{
+    munmap(this->ptr, this->n_bytes);
+    
+    return;
+}   /* ~SharedBuffer() */
+
+// ----------------------------------------------------------------------------------------------------- //
+
+
+
+// ----------------------------------------------------------------------------------------------------- //
+
+///
+/// \fn std::vector<int> RunForked(
+///         size_t n_tasks,
+///         size_t n_workers,
+///         const std::function<int(size_t)>& task
+///     )
+///
+/// \brief Runs task(i), for each i in [0, n_tasks), in its own fork()ed child process, 
+///     with at most n_workers children alive at once. Does not touch the GIL (so the 
+///     caller should release it, since this blocks until all children have exited). 
+///     Refuses to fork while any asynchronous stepping worker is alive, since a child 
+///     could inherit an API lock held by that thread (callers stop the workers first, by 
+///     way of StopSimulationWorkers(), with the GIL held).
+///
+/// \param n_tasks The number of tasks.
+///
+/// \param n_workers The maximum number of concurrent child processes.
+///
+/// \param task The task to run in each child; its return value is the child's exit code.
+///
+/// \return The exit code of each task's child (negative for the terminating signal, if 
+///     killed by one).
+///
+
+std::vector<int> RunForked(
+    size_t n_tasks,
+    size_t n_workers,
+    const std::function<int(size_t)>& task
+)
+{
+    {
+        std::lock_guard<std::mutex> lock(simulation_workers_mutex);
+        
+        if (!simulation_workers.empty()) {
+            throw std::runtime_error(
+                "ERROR: cannot fork while asynchronous stepping worker threads are running"
+            );
+        }
+    }
+    
+    std::vector<int> exit_codes(n_tasks, -1);
+    std::vector<std::pair<pid_t, size_t>> running;
+    
+    size_t next_task = 0;
+    std::string fork_error = "";
+    
+    while ((next_task < n_tasks && fork_error.empty()) || !running.empty()) {
+        //  1. launch children, up to n_workers
+        while (next_task < n_tasks && fork_error.empty() && running.size() < std::max(n_workers, (size_t)1)) {
+            pid_t pid = fork();
+            
+            if (pid == 0) {
+                int exit_code = 1;
+                
+                try {
+                    exit_code = task(next_task);
+                }
+                
+                catch (...) {
+                    exit_code = 1;
+                }
+                
+                _exit(exit_code);
+            }
+            
+            if (pid < 0) {
+                fork_error = "ERROR: fork() failed: " + std::string(strerror(errno));
+                break;
+            }
+            
+            running.push_back(std::make_pair(pid, next_task));
+            next_task++;
+        }
+        
+        //  2. reap any finished children (by pid, so as not to reap anyone else's children)
+        bool reaped_any = false;
+        
+        for (size_t i = 0; i < running.size(); ) {
+            int status = 0;
+            pid_t pid = waitpid(running[i].first, &status, WNOHANG);
+            
+            if (pid == 0) {
+                i++;
+                continue;
+            }
+            
+            if (pid > 0 && WIFEXITED(status)) {
+                exit_codes[running[i].second] = WEXITSTATUS(status);
+            }
+            
+            else if (pid > 0 && WIFSIGNALED(status)) {
+                exit_codes[running[i].second] = -WTERMSIG(status);
+            }
+            
+            running.erase(running.begin() + i);
+            reaped_any = true;
+        }
+        
+        if (!reaped_any && !running.empty()) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+    }
+    
+    if (!fork_error.empty()) {
+        throw std::runtime_error(fork_error);
+    }
+    
+    return exit_codes;
+}   /* RunForked() */
+
+// ----------------------------------------------------------------------------------------------------- //
+
+
+
+// ----------------------------------------------------------------------------------------------------- //
+
+///
+/// \fn std::string ForkedError(int exit_code, const char* error_slot)
+///
+/// \brief Helper function which resolves the error (if any) reported by a forked task,
+///     by way of its error slot (in shared memory) and exit code.
+///
+/// \param exit_code The exit code of the task's child (as per RunForked()).
+///
+/// \param error_slot The task's error slot.
+///
+/// \return The error message ("" for none).
+///
+
+std::string ForkedError(int exit_code, const char* error_slot)
+{
+    std::string error_str(error_slot, strnlen(error_slot, PDSAPI_BINDINGS_ERROR_SLOT_SIZE));
+    
+    if (error_str.empty() && exit_code != 0) {
+        error_str = "ERROR: worker process exited abnormally (status " + std::to_string(exit_code) + ")";
+    }
+    
+    return error_str;
+}   /* ForkedError() */
+
+// ----------------------------------------------------------------------------------------------------- //
+
+#endif  /* PDSAPI_BINDINGS_HAS_FORK */
+
+// ==== END Process pools ============================================================================== //
+
+
+
+// ==== Ensembles ====================================================================================== //
+
+/*
+ *  An Ensemble runs N independently labelled simulations (each with its own command line 
+ *  arguments and parameter overrides), on a pool of worker threads with the GIL released, and
+ *  records a fixed set of channels from each into one shared (n_members, n_records, n_elements)
+ *  array. Since the API is keyed by simulation label, members never share state through the 
+ *  bindings; however, whether the API itself is safe to drive from several threads at once is up
+ *  to the API, so the "serial" mode is provided as a fallback.
+ */
+
+typedef std::variant<double, std::vector<double>> OverrideValue;
+typedef std::tuple<int, std::string, OverrideValue> ParameterOverride;
+
+// ----------------------------------------------------------------------------------------------------- //
+
+///
+/// \fn void ApplyOverride(
+///         const std::string& unique_simulation_label,
+///         const ParameterOverride& parameter_override
+///     )
+///
+/// \brief Applies the given (command, dobject name, value) override, by way of 
+///     ProteusDSAPI::SetDouble (for a float value) or SetDoubleArray (for a list value).
+///
+/// \param unique_simulation_label The API label for the target simulation.
+///
+/// \param parameter_override The override to apply.
+///
+
+void ApplyOverride(
+    const std::string& unique_simulation_label,
+    const ParameterOverride& parameter_override
+)
+{
+    int command = std::get<0>(parameter_override);
+    const std::string& dobject_name = std::get<1>(parameter_override);
+    const OverrideValue& value = std::get<2>(parameter_override);
+    
+    if (std::holds_alternative<double>(value)) {
+        ProteusDSAPI::SetDouble(unique_simulation_label, command, dobject_name, std::get<double>(value));
+    }
+    
+    else {
+        ProteusDSAPI::SetDoubleArray(
+            unique_simulation_label,
+            command,
+            dobject_name,
+            std::get<std::vector<double>>(value)
+        );
+    }
+    
+    NoteMetadataSet(unique_simulation_label, command);
+    
+    return;
+}   /* ApplyOverride() */
+
+// ----------------------------------------------------------------------------------------------------- //
+
+
+
+// ----------------------------------------------------------------------------------------------------- //
+
+///
+/// \fn void RecordRun(
+///         const std::string& unique_simulation_label,
+///         const std::vector<ParameterOverride>& overrides,
+///         double dt_s,
+///         size_t n_steps,
+///         size_t record_every,
+///         const std::vector<DoubleRequest>& channels,
+///         const std::vector<size_t>& channel_offsets,
+///         double* record_ptr
+///     )
+///
+/// \brief Helper function which applies the given overrides to an initialized simulation,
+///     and then advances it n_steps, recording the given channels every record_every steps
+///     (including the initial state) into consecutive rows of record_ptr. Does not touch
+///     the GIL.
+///
+/// \param unique_simulation_label The API label for the target simulation.
+///
+/// \param overrides The (command, dobject name, value) overrides to apply first.
+///
+/// \param dt_s The time step [s].
+///
+/// \param n_steps The number of steps to take.
+///
+/// \param record_every The number of steps between records.
+///
+/// \param channels The (command, dobject name, n_elements) channels to record.
+///
+/// \param channel_offsets The offset of each channel in a record.
+///
+/// \param record_ptr Pointer to the record buffer (n_steps / record_every + 1 records).
+///
+
+void RecordRun(
+    const std::string& unique_simulation_label,
+    const std::vector<ParameterOverride>& overrides,
+    double dt_s,
+    size_t n_steps,
+    size_t record_every,
+    const std::vector<DoubleRequest>& channels,
+    const std::vector<size_t>& channel_offsets,
+    double* record_ptr
+)
+{
+    size_t n_elements = channels.empty() ? 0 :
+        channel_offsets.back() + std::max(std::get<2>(channels.back()), (size_t)1);
+    
+    for (const ParameterOverride& parameter_override : overrides) {
+        ApplyOverride(unique_simulation_label, parameter_override);
+    }
+    
+    GatherDoublesInto(unique_simulation_label, channels, channel_offsets, record_ptr);
+    record_ptr += n_elements;
+    
+    for (size_t step = 1; step <= n_steps; step++) {
+        ProteusDSAPI::AdvanceTime(unique_simulation_label, dt_s);
+        
+        if (step % record_every == 0) {
+            GatherDoublesInto(unique_simulation_label, channels, channel_offsets, record_ptr);
+            record_ptr += n_elements;
+        }
+    }
+    
+    return;
+}   /* RecordRun() */
+
+// ----------------------------------------------------------------------------------------------------- //
+
+
+
+// ----------------------------------------------------------------------------------------------------- //
+
+///
+/// \struct EnsembleMember
+///
+/// \brief A single member (simulation) of an Ensemble.
+///
+
+struct EnsembleMember {
+    std::string unique_simulation_label;
+    std::string arguments;
+    std::vector<ParameterOverride> overrides;
+};  /* EnsembleMember */
+
+// ----------------------------------------------------------------------------------------------------- //
+
+
+
+// ----------------------------------------------------------------------------------------------------- //
+
+///
+/// \class Ensemble
+///
+/// \brief Runs a set of labelled simulations, from initialization through to close, and
+///     records the given channels every record_every steps (including the initial state).
+///     Each member is advanced ceil(end_time_s / dt_s) steps from its start time.
+///
+
+class Ensemble {
+    private:
+        void runMember(size_t, double*);
+        
+    public:
+        double dt_s;
+        double end_time_s;
+        size_t record_every;
+        size_t n_workers;
+        std::string mode;
+        
+        std::vector<DoubleRequest> channels;
+        std::vector<size_t> channel_offsets;
+        size_t n_elements;
+        
+        std::vector<EnsembleMember> members;
+        std::vector<std::string> errors;
+        pybind11::array_t<double> results;
+        
+        Ensemble(double, double, std::vector<DoubleRequest>, size_t, size_t, std::string);
+        
+        size_t nSteps(void) const;
+        size_t nRecords(void) const;
+        
+        void addMember(std::string, std::string, std::vector<ParameterOverride>);
+        void run(void);
+};  /* Ensemble */
+
+// ----------------------------------------------------------------------------------------------------- //
+
+
+
+// ----------------------------------------------------------------------------------------------------- //
+
+///
+/// \fn Ensemble::Ensemble(
+///         double dt_s,
+///         double end_time_s,
+///         std::vector<DoubleRequest> channels,
+///         size_t record_every,
+///         size_t n_workers,
+///         std::string mode
+///     )
+///
+/// \brief Constructor for the Ensemble class.
+///
+/// \param dt_s The time step [s].
+///
+/// \param end_time_s The simulated duration [s].
+///
+/// \param channels The (command, dobject name, n_elements) channels to record.
+///
+/// \param record_every The number of steps between records.
+///
+/// \param n_workers The number of workers (0 for one per hardware thread).
+///
+/// \param mode One of "thread" (members run concurrently on threads), "serial", or (on 
+///     POSIX platforms only) "process" (members run concurrently in fork()ed processes).
+///
+
+Ensemble::Ensemble(
+    double dt_s,
+    double end_time_s,
+    std::vector<DoubleRequest> channels,
+    size_t record_every,
+    size_t n_workers,
+    std::string mode
+)
+{
+    if (dt_s <= 0) {
+        throw std::invalid_argument("ERROR: time step must be > 0");
+    }
+    
+    if (record_every == 0) {
+        throw std::invalid_argument("ERROR: record_every must be > 0");
+    }
+    
+    #ifdef PDSAPI_BINDINGS_HAS_FORK
+        if (mode != "thread" && mode != "serial" && mode != "process") {
+            throw std::invalid_argument(
+                "ERROR: mode must be one of \"thread\", \"serial\", or \"process\""
+            );
+        }
+    #else
+        if (mode != "thread" && mode != "serial") {
+            throw std::invalid_argument("ERROR: mode must be one of \"thread\" or \"serial\"");
+        }
+    #endif
+    
+    this->dt_s = dt_s;
+    this->end_time_s = end_time_s;
+    this->record_every = record_every;
+    this->mode = mode;
+    
+    this->n_workers = n_workers;
+    
+    if (this->n_workers == 0) {
+        this->n_workers = std::max(std::thread::hardware_concurrency(), 1u);
+    }
+    
+    this->channels = channels;
+    this->channel_offsets = DoubleRequestOffsets(channels, SIZE_MAX);
+    this->n_elements = 0;
+    
+    for (const DoubleRequest& channel : channels) {
+        this->n_elements += std::max(std::get<2>(channel), (size_t)1);
+    }
+    
+    return;
+}   /* Ensemble() */
+
+// ----------------------------------------------------------------------------------------------------- //
+
+
+
+// ----------------------------------------------------------------------------------------------------- //
+
+///
+/// \fn size_t Ensemble::nSteps(void) const
+///
+/// \brief Returns the number of steps each member is advanced.
+///
+/// \return The number of steps each member is advanced.
+///
+
+size_t Ensemble::nSteps(void) const
+{
+    return (size_t)ceil(this->end_time_s / this->dt_s - 1e-9);
+}   /* nSteps() */
+
+// ----------------------------------------------------------------------------------------------------- //
+
+
+
+// ----------------------------------------------------------------------------------------------------- //
+
+///
+/// \fn size_t Ensemble::nRecords(void) const
+///
+/// \brief Returns the number of records per member (including the initial state).
+///
+/// \return The number of records per member.
+///
+
+size_t Ensemble::nRecords(void) const
+{
+    return this->nSteps() / this->record_every + 1;
+}   /* nRecords() */
+
+// ----------------------------------------------------------------------------------------------------- //
+
+
+
+// ----------------------------------------------------------------------------------------------------- //
+
+///
+/// \fn void Ensemble::addMember(
+///         std::string unique_simulation_label,
+///         std::string arguments,
+///         std::vector<ParameterOverride> overrides
+///     )
+///
+/// \brief Adds a member to the ensemble.
+///
+/// \param unique_simulation_label The API label for the member (must be unique).
+///
+/// \param arguments The command line arguments for InitializeProteusDS (e.g., 
+///     "-i ./Inputs -o ./Results_1 -overwrite on").
+///
+/// \param overrides The (command, dobject name, value) overrides, applied after 
+///     initialization.
+///
+
+void Ensemble::addMember(
+    std::string unique_simulation_label,
+    std::string arguments,
+    std::vector<ParameterOverride> overrides
+)
+{
+    for (const EnsembleMember& member : this->members) {
+        if (member.unique_simulation_label == unique_simulation_label) {
+            throw std::invalid_argument("ERROR: duplicate member label " + unique_simulation_label);
+        }
+    }
+    
+    EnsembleMember member;
+    member.unique_simulation_label = unique_simulation_label;
+    member.arguments = arguments;
+    member.overrides = overrides;
+    
+    this->members.push_back(member);
+    
+    return;
+}   /* addMember() */
+
+// ----------------------------------------------------------------------------------------------------- //
+
+
+
+// ----------------------------------------------------------------------------------------------------- //
+
+///
+/// \fn void Ensemble::runMember(size_t member_index, double* results_ptr)
+///
+/// \brief Helper method which runs a single member, from initialization through to close,
+///     recording into its slice of the results. Errors are caught and recorded in errors
+///     (and the member is closed all the same, if it was initialized).
+///
+/// \param member_index The index of the member to run.
+///
+/// \param results_ptr Pointer to the (whole) results buffer.
+///
+
+void Ensemble::runMember(size_t member_index, double* results_ptr)
+{
+    const EnsembleMember& member = this->members[member_index];
+    const std::string& label = member.unique_simulation_label;
+    
+    double* record_ptr = results_ptr + member_index * this->nRecords() * this->n_elements;
+    bool is_initialized = false;
+    
+    try {
+        {
+            MetadataInvalidator invalidator(label, -1, true);
+            is_initialized = ProteusDSAPI::InitializeProteusDS(label, member.arguments, false, false);
+        }
+        
+        if (!is_initialized) {
+            this->errors[member_index] = "ERROR: failed to initialize: " + GetErrorMessage(label);
+            return;
+        }
+        
+        ProteusDSAPI::AdvanceTime(label, 0);
+        
+        RecordRun(
+            label,
+            member.overrides,
+            this->dt_s,
+            this->nSteps(),
+            this->record_every,
+            this->channels,
+            this->channel_offsets,
+            record_ptr
+        );
+        
+        is_initialized = false;
+        ProteusDSAPI::Close(label);
+        ForgetMetadata(label);
+    }
+    
+    catch (std::exception& e) {
+        this->errors[member_index] = std::string("ERROR: ") + e.what();
+        
+        //  don't leak a live simulation for a failed member
+        if (is_initialized) {
+            try {
+                ProteusDSAPI::Close(label);
+            }
+            
+            catch (...) {
+                //  keep the original error
+            }
+            
+            ForgetMetadata(label);
+        }
+    }
+    
+    return;
+}   /* runMember() */
+
+// ----------------------------------------------------------------------------------------------------- //
+
+
+
+// ----------------------------------------------------------------------------------------------------- //
+
+///
+/// \fn void Ensemble::run(void)
+///
+/// \brief Runs all members (on up to n_workers threads, in "thread" mode), with the GIL 
+///     released. Each run records into a new results array (so earlier results remain 
+///     valid), and discards previous errors.
+///
+
+void Ensemble::run(void)
+{
+    this->results = pybind11::array_t<double>(
+        {
+            (pybind11::ssize_t)this->members.size(),
+            (pybind11::ssize_t)this->nRecords(),
+            (pybind11::ssize_t)this->n_elements
+        }
+    );
+    
+    double* results_ptr = this->results.mutable_data();
+    size_t n_results = this->results.size();
+    std::fill(results_ptr, results_ptr + n_results, 0);
+    
+    this->errors.assign(this->members.size(), "");
+    
+    //  members reinitialize their labels, so retire any worker or cached metadata of those
+    for (const EnsembleMember& member : this->members) {
+        StopSimulationWorker(member.unique_simulation_label);
+        ForgetMetadata(member.unique_simulation_label);
+    }
+    
+    //  no worker thread may be alive across fork() (see RunForked())
+    if (this->mode == "process") {
+        StopSimulationWorkers();
+    }
+    
+    pybind11::gil_scoped_release release;
+    
+    if (this->mode == "serial") {
+        for (size_t i = 0; i < this->members.size(); i++) {
+            this->runMember(i, results_ptr);
+        }
+        
+        return;
+    }
+    
+    #ifdef PDSAPI_BINDINGS_HAS_FORK
+        if (this->mode == "process") {
+            SharedBuffer shared_results(n_results * sizeof(double));
+            SharedBuffer shared_errors(this->members.size() * PDSAPI_BINDINGS_ERROR_SLOT_SIZE);
+            
+            std::vector<int> exit_codes = RunForked(
+                this->members.size(),
+                this->n_workers,
+                [&](size_t member_index) {
+                    this->runMember(member_index, shared_results.doubles());
+                    
+                    strncpy(
+                        shared_errors.chars() + member_index * PDSAPI_BINDINGS_ERROR_SLOT_SIZE,
+                        this->errors[member_index].c_str(),
+                        PDSAPI_BINDINGS_ERROR_SLOT_SIZE - 1
+                    );
+                    
+                    return this->errors[member_index].empty() ? 0 : 1;
+                }
+            );
+            
+            std::memcpy(results_ptr, shared_results.doubles(), n_results * sizeof(double));
+            
+            for (size_t i = 0; i < this->members.size(); i++) {
+                this->errors[i] = ForkedError(
+                    exit_codes[i],
+                    shared_errors.chars() + i * PDSAPI_BINDINGS_ERROR_SLOT_SIZE
+                );
+            }
+            
+            return;
+        }
+    #endif
+    
+    std::atomic<size_t> next_member(0);
+    std::vector<std::thread> workers;
+    
+    size_t n_threads = std::min(this->n_workers, this->members.size());
+    
+    for (size_t i = 0; i < n_threads; i++) {
+        workers.emplace_back(
+            [this, &next_member, results_ptr]() {
+                size_t member_index = next_member++;
+                
+                while (member_index < this->members.size()) {
+                    this->runMember(member_index, results_ptr);
+                    member_index = next_member++;
+                }
+            }
+        );
+    }
+    
+    for (std::thread& worker : workers) {
+        worker.join();
+    }
+    
+    return;
+}   /* run() */
+
+// ----------------------------------------------------------------------------------------------------- //
+
+// ==== END Ensembles ================================================================================== //
+
+
+
+// ==== Warm start pools =============================================================================== //
+
+/*
+ *  A WarmStartPool initializes a template simulation once (parsing setup.PDSi and all of the 
+ *  .ini/.dat inputs), advances it to a spin-up time, and then runs each member in a fork()ed 
+ *  child that starts from a copy-on-write copy of the template, applies its own overrides, and 
+ *  continues on. Only available on POSIX platforms.
+ *
+ *  NOTE: This assumes the API holds no state that is invalidated by fork() (e.g., threads of
+ *        its own, or open license server connections). By default, file output is switched off
+ *        in the children, since they would otherwise all write to the template's output path.
+ */
+
+#ifdef PDSAPI_BINDINGS_HAS_FORK
+
+// ----------------------------------------------------------------------------------------------------- //
+
+///
+/// \class WarmStartPool
+///
+/// \brief An initialized template simulation, from which members are fork()ed.
+///
+
+class WarmStartPool {
+    public:
+        std::string unique_simulation_label;
+        double spin_up_time_s;
+        bool disable_file_output;
+        bool is_open;
+        
+        std::vector<std::string> errors;
+        
+        WarmStartPool(std::string, std::string, double, bool);
+        
+        pybind11::array_t<double> run(
+            std::vector<std::vector<ParameterOverride>>,
+            double,
+            double,
+            std::vector<DoubleRequest>,
+            size_t,
+            size_t
+        );
+        
+        void close(void);
+};  /* WarmStartPool */
+
+// ----------------------------------------------------------------------------------------------------- //
+
+
+
+// ----------------------------------------------------------------------------------------------------- //
+
+///
+/// \fn WarmStartPool::WarmStartPool(
+///         std::string unique_simulation_label,
+///         std::string arguments,
+///         double spin_up_time_s,
+///         bool disable_file_output
+///     )
+///
+/// \brief Constructor for the WarmStartPool class. Initializes the template simulation,
+///     and advances it to the spin-up time.
+///
+/// \param unique_simulation_label The API label for the template simulation.
+///
+/// \param arguments The command line arguments for InitializeProteusDS.
+///
+/// \param spin_up_time_s The time [s] to advance the template to before forking.
+///
+/// \param disable_file_output Whether to switch off file output in the children (by way
+///     of PDSAPI::fileOutputOff).
+///
+
+WarmStartPool::WarmStartPool(
+    std::string unique_simulation_label,
+    std::string arguments,
+    double spin_up_time_s,
+    bool disable_file_output
+)
+{
+    this->unique_simulation_label = unique_simulation_label;
+    this->spin_up_time_s = spin_up_time_s;
+    this->disable_file_output = disable_file_output;
+    this->is_open = false;
+    
+    StopSimulationWorker(unique_simulation_label);
+    
+    pybind11::gil_scoped_release release;
+    bool is_initialized = false;
+    
+    {
+        MetadataInvalidator invalidator(unique_simulation_label, -1, true);
+        is_initialized = ProteusDSAPI::InitializeProteusDS(unique_simulation_label, arguments, false, false);
+    }
+    
+    if (!is_initialized) {
+        throw std::runtime_error(
+            "ERROR: failed to initialize template: " + GetErrorMessage(unique_simulation_label)
+        );
+    }
+    
+    this->is_open = true;
+    
+    try {
+        ProteusDSAPI::AdvanceTime(unique_simulation_label, 0);
+        
+        if (spin_up_time_s > 0) {
+            ProteusDSAPI::AdvanceTime(unique_simulation_label, spin_up_time_s);
+        }
+    }
+    
+    catch (...) {
+        //  close() never runs for an unconstructed pool, so don't leak the template
+        ProteusDSAPI::Close(unique_simulation_label);
+        ForgetMetadata(unique_simulation_label);
+        this->is_open = false;
+        
+        throw;
+    }
+    
+    return;
+}   /* WarmStartPool() */
+
+// ----------------------------------------------------------------------------------------------------- //
+
+
+
+// ----------------------------------------------------------------------------------------------------- //
+
+///
+/// \fn pybind11::array_t<double> WarmStartPool::run(
+///         std::vector<std::vector<ParameterOverride>> member_overrides,
+///         double dt_s,
+///         double duration_s,
+///         std::vector<DoubleRequest> channels,
+///         size_t record_every,
+///         size_t n_workers
+///     )
+///
+/// \brief Runs one fork()ed member per list of overrides, each continuing on from the 
+///     template for duration_s, with the GIL released. The template itself is not 
+///     advanced, so run() may be called any number of times. Per-member errors are 
+///     recorded in errors.
+///
+/// \param member_overrides The (command, dobject name, value) overrides for each member.
+///
+/// \param dt_s The time step [s].
+///
+/// \param duration_s The simulated duration [s] (after spin-up).
+///
+/// \param channels The (command, dobject name, n_elements) channels to record.
+///
+/// \param record_every The number of steps between records.
+///
+/// \param n_workers The maximum number of concurrent children (0 for one per hardware 
+///     thread).
+///
+/// \return The recorded channels, as an (n_members, n_records, n_elements) array.
+///
+
+pybind11::array_t<double> WarmStartPool::run(
+    std::vector<std::vector<ParameterOverride>> member_overrides,
+    double dt_s,
+    double duration_s,
+    std::vector<DoubleRequest> channels,
+    size_t record_every,
+    size_t n_workers
+)
+{
+    if (!this->is_open) {
+        throw std::runtime_error("ERROR: warm start pool has been closed");
+    }
+    
+    if (dt_s <= 0 || record_every == 0) {
+        throw std::invalid_argument("ERROR: time step and record_every must be > 0");
+    }
+    
+    if (n_workers == 0) {
+        n_workers = std::max(std::thread::hardware_concurrency(), 1u);
+    }
+    
+    size_t n_members = member_overrides.size();
+    size_t n_steps = (size_t)ceil(duration_s / dt_s - 1e-9);
+    size_t n_records = n_steps / record_every + 1;
+    
+    std::vector<size_t> channel_offsets = DoubleRequestOffsets(channels, SIZE_MAX);
+    size_t n_elements = channels.empty() ? 0 :
+        channel_offsets.back() + std::max(std::get<2>(channels.back()), (size_t)1);
+    
+    size_t n_member_doubles = n_records * n_elements;
+    
+    pybind11::array_t<double> results(
+        {(pybind11::ssize_t)n_members, (pybind11::ssize_t)n_records, (pybind11::ssize_t)n_elements}
+    );
+    double* results_ptr = results.mutable_data();
+    
+    std::vector<int> exit_codes;
+    SharedBuffer shared_results(n_members * n_member_doubles * sizeof(double));
+    SharedBuffer shared_errors(n_members * PDSAPI_BINDINGS_ERROR_SLOT_SIZE);
+    
+    //  no worker thread may be alive across fork() (see RunForked())
+    StopSimulationWorkers();
+    
+    {
+        pybind11::gil_scoped_release release;
+        
+        exit_codes = RunForked(
+            n_members,
+            n_workers,
+            [&](size_t member_index) {
+                char* error_slot = shared_errors.chars() + member_index * PDSAPI_BINDINGS_ERROR_SLOT_SIZE;
+                
+                try {
+                    if (this->disable_file_output) {
+                        ProteusDSAPI::SetInt(
+                            this->unique_simulation_label,
+                            PDSAPI::PDSAPI::fileOutputOff,
+                            "",
+                            1
+                        );
+                    }
+                    
+                    RecordRun(
+                        this->unique_simulation_label,
+                        member_overrides[member_index],
+                        dt_s,
+                        n_steps,
+                        record_every,
+                        channels,
+                        channel_offsets,
+                        shared_results.doubles() + member_index * n_member_doubles
+                    );
+                }
+                
+                catch (std::exception& e) {
+                    strncpy(error_slot, e.what(), PDSAPI_BINDINGS_ERROR_SLOT_SIZE - 1);
+                    return 1;
+                }
+                
+                return 0;
+            }
+        );
+        
+        std::memcpy(results_ptr, shared_results.doubles(), n_members * n_member_doubles * sizeof(double));
+    }
+    
+    this->errors.assign(n_members, "");
+    
+    for (size_t i = 0; i < n_members; i++) {
+        this->errors[i] = ForkedError(
+            exit_codes[i],
+            shared_errors.chars() + i * PDSAPI_BINDINGS_ERROR_SLOT_SIZE
+        );
+    }
+    
+    return results;
+}   /* run() */
+
+// ----------------------------------------------------------------------------------------------------- //
+
+
+
+// ----------------------------------------------------------------------------------------------------- //
+
+///
+/// \fn void WarmStartPool::close(void)
+///
+/// \brief Closes the template simulation (by way of Close(), so its worker and cached 
+///     metadata are retired as well). Must be called with the GIL held.
+///
+
+void WarmStartPool::close(void)
+{
+    if (this->is_open) {
+        Close(this->unique_simulation_label);
+        this->is_open = false;
+    }
+    
+    return;
+}   /* close() */
+
+// ----------------------------------------------------------------------------------------------------- //
+
+#endif  /* PDSAPI_BINDINGS_HAS_FORK */
+
+// ==== END Warm start pools =========================================================================== //
+
+
+
+// ==== Snapshots ====================================================================================== //
+
+/*
+ *  A SimulationSnapshot captures the time, the full state vector of every dobject with state 
+ *  (PDSAPI::state, sized by PDSAPI::stateSize), and a configurable set of (command, dobject 
+ *  name, n_elements) parameters, into a single binary buffer drawn from a pool. Restoring is then
+ *  one SetDoubleArray per dobject (plus one per parameter), with no file I/O. The layout is 
+ *  resolved once, on construction, so recapturing into an existing snapshot costs only the Get
+ *  calls themselves.
+ *
+ *  NOTE: Restoring the time relies on the API accepting PDSAPI::time by way of SetDouble.
+ */
+
+// ----------------------------------------------------------------------------------------------------- //
+
+///
+/// \fn std::vector<double> AcquireSnapshotBuffer(size_t n_elements)
+///
+/// \brief Takes a buffer from the snapshot buffer pool (or creates one, if the pool is
+///     empty), resized to n_elements.
+///
+/// \param n_elements The required size of the buffer.
+///
+/// \return The buffer.
+///
+
+std::mutex snapshot_pool_mutex;
+std::vector<std::vector<double>> snapshot_pool;
+
+std::vector<double> AcquireSnapshotBuffer(size_t n_elements)
+{
+    std::vector<double> buffer;
+    
+    {
+        std::lock_guard<std::mutex> lock(snapshot_pool_mutex);
+        
+        if (!snapshot_pool.empty()) {
+            buffer = std::move(snapshot_pool.back());
+            snapshot_pool.pop_back();
+        }
+    }
+    
+    buffer.resize(n_elements, 0);
+    
+    return buffer;
+}   /* AcquireSnapshotBuffer() */
+
+// ----------------------------------------------------------------------------------------------------- //
+
+
+
+// ----------------------------------------------------------------------------------------------------- //
+
+///
+/// \fn void ReleaseSnapshotBuffer(std::vector<double>& buffer)
+///
+/// \brief Returns a buffer to the snapshot buffer pool.
+///
+/// \param buffer The buffer (left empty).
+///
+
+void ReleaseSnapshotBuffer(std::vector<double>& buffer)
+{
+    if (buffer.capacity() == 0) {
+        return;
+    }
+    
+    std::lock_guard<std::mutex> lock(snapshot_pool_mutex);
+    snapshot_pool.push_back(std::move(buffer));
+    buffer.clear();
+    
+    return;
+}   /* ReleaseSnapshotBuffer() */
+
+// ----------------------------------------------------------------------------------------------------- //
+
+
+
+// ----------------------------------------------------------------------------------------------------- //
+
+///
+/// \class SimulationSnapshot
+///
+/// \brief A captured simulation state. The buffer holds the state of each dobject (in 
+///     order), followed by the parameters (packed as per GatherDoubles()).
+///
+
+class SimulationSnapshot {
+    public:
+        const std::string* unique_simulation_label_ptr;
+        double time_s;
+        
+        std::vector<const std::string*> dobject_name_ptrs;
+        std::vector<size_t> state_offsets;
+        std::vector<size_t> state_sizes;
+        size_t n_state_elements;
+        
+        std::vector<DoubleRequest> parameters;
+        std::vector<size_t> parameter_offsets;
+        
+        std::vector<double> buffer;
+        
+        SimulationSnapshot(const Simulation&, std::vector<DoubleRequest>);
+        SimulationSnapshot(const SimulationSnapshot&) = delete;
+        SimulationSnapshot& operator=(const SimulationSnapshot&) = delete;
+        ~SimulationSnapshot(void);
+        
+        const std::string& label(void) const { return *(this->unique_simulation_label_ptr); }
+        
+        void capture(void);
+        void restore(void);
+};  /* SimulationSnapshot */
+
+// ----------------------------------------------------------------------------------------------------- //
+
+
+
+// ----------------------------------------------------------------------------------------------------- //
+
+///
+/// \fn SimulationSnapshot::SimulationSnapshot(
+///         const Simulation& simulation,
+///         std::vector<DoubleRequest> parameters
+///     )
+///
+/// \brief Constructor for the SimulationSnapshot class. Resolves the layout (querying the
+///     state size of every dobject), and captures the current state.
+///
+/// \param simulation The target simulation.
+///
+/// \param parameters The (command, dobject name, n_elements) parameters to capture 
+///     alongside the state (e.g., environment or controller parameters).
+///
+
+SimulationSnapshot::SimulationSnapshot(
+    const Simulation& simulation,
+    std::vector<DoubleRequest> parameters
+)
+{
+    this->unique_simulation_label_ptr = simulation.unique_simulation_label_ptr;
+    this->time_s = 0;
+    this->n_state_elements = 0;
+    
+    for (const std::string& dobject_name : simulation.dobject_names) {
+        int state_size = 0;
+        PDSAPI_TIMED(ProteusDSAPI::GetInt(this->label(), PDSAPI::PDSAPI::stateSize, dobject_name, state_size));
+        
+        if (state_size <= 0) {
+            continue;
+        }
+        
+        this->dobject_name_ptrs.push_back(InternString(dobject_name));
+        this->state_offsets.push_back(this->n_state_elements);
+        this->state_sizes.push_back(state_size);
+        
+        this->n_state_elements += state_size;
+    }
+    
+    this->parameters = parameters;
+    this->parameter_offsets = DoubleRequestOffsets(parameters, SIZE_MAX);
+    
+    size_t n_parameter_elements = parameters.empty() ? 0 :
+        this->parameter_offsets.back() + std::max(std::get<2>(parameters.back()), (size_t)1);
+    
+    this->buffer = AcquireSnapshotBuffer(this->n_state_elements + n_parameter_elements);
+    this->capture();
+    
+    return;
+}   /* SimulationSnapshot() */
+
+// ----------------------------------------------------------------------------------------------------- //
+
+
+
+// ----------------------------------------------------------------------------------------------------- //
+
+///
+/// \fn SimulationSnapshot::~SimulationSnapshot(void)
+///
+/// \brief Destructor for the SimulationSnapshot class. Returns the buffer to the pool.
+///
+
+SimulationSnapshot::~SimulationSnapshot(void)
+{
+    ReleaseSnapshotBuffer(this->buffer);
+    
+    return;
+}   /* ~SimulationSnapshot() */
+
+// ----------------------------------------------------------------------------------------------------- //
+
+
+
+// ----------------------------------------------------------------------------------------------------- //
+
+///
+/// \fn void SimulationSnapshot::capture(void)
+///
+/// \brief (Re)captures the current time, state, and parameters into the buffer.
+///
+
+void SimulationSnapshot::capture(void)
+{
+    SimulationGuard simulation_guard(this->label());
+    
+    PDSAPI_TIMED(ProteusDSAPI::GetDouble(this->label(), PDSAPI::PDSAPI::time, "", this->time_s));
+    
+    for (size_t i = 0; i < this->dobject_name_ptrs.size(); i++) {
+        std::vector<double>& state = Scratch<double>(this->state_sizes[i]);
+        
+        PDSAPI_TIMED(ProteusDSAPI::GetDoubleArray(
+            this->label(),
+            PDSAPI::PDSAPI::state,
+            *(this->dobject_name_ptrs[i]),
+            state
+        ));
+        
+        size_t n_copy = std::min(state.size(), this->state_sizes[i]);
+        std::memcpy(this->buffer.data() + this->state_offsets[i], state.data(), n_copy * sizeof(double));
+    }
+    
+    GatherDoublesInto(
+        this->label(),
+        this->parameters,
+        this->parameter_offsets,
+        this->buffer.data() + this->n_state_elements
+    );
+    
+    return;
+}   /* capture() */
+
+// ----------------------------------------------------------------------------------------------------- //
+
+
+
+// ----------------------------------------------------------------------------------------------------- //
+
+///
+/// \fn void SimulationSnapshot::restore(void)
+///
+/// \brief Restores the captured time, state, and parameters. Setting PDSAPI::time is not
+///     documented API behaviour, so the time is read back first, and an error is thrown 
+///     (before any state is touched) if the API did not accept it.
+///
+
+void SimulationSnapshot::restore(void)
+{
+    PDSAPI_TIMED(ProteusDSAPI::SetDouble(this->label(), PDSAPI::PDSAPI::time, "", this->time_s));
+    
+    double restored_time_s = NAN;
+    PDSAPI_TIMED(ProteusDSAPI::GetDouble(this->label(), PDSAPI::PDSAPI::time, "", restored_time_s));
+    
+    if (!(fabs(restored_time_s - this->time_s) <= 1e-9 * std::max(fabs(this->time_s), 1.0))) {
+        throw std::runtime_error(
+            "ERROR: failed to restore the time of simulation " + this->label() +
+            " (the API did not accept SetDouble(PDSAPI.time))"
+        );
+    }
+    
+    for (size_t i = 0; i < this->dobject_name_ptrs.size(); i++) {
+        std::vector<double>& state = Scratch<double>(this->state_sizes[i]);
+        std::memcpy(
+            state.data(),
+            this->buffer.data() + this->state_offsets[i],
+            this->state_sizes[i] * sizeof(double)
+        );
+        
+        PDSAPI_TIMED(ProteusDSAPI::SetDoubleArray(
+            this->label(),
+            PDSAPI::PDSAPI::state,
+            *(this->dobject_name_ptrs[i]),
+            state
+        ));
+    }
+    
+    const double* parameters_ptr = this->buffer.data() + this->n_state_elements;
+    
+    for (size_t i = 0; i < this->parameters.size(); i++) {
+        int command = std::get<0>(this->parameters[i]);
+        const std::string& dobject_name = std::get<1>(this->parameters[i]);
+        size_t n_elements = std::get<2>(this->parameters[i]);
+        
+        if (n_elements == 0) {
+            PDSAPI_TIMED(ProteusDSAPI::SetDouble(
+                this->label(),
+                command,
+                dobject_name,
+                parameters_ptr[this->parameter_offsets[i]]
+            ));
+        }
+        
+        else {
+            std::vector<double>& values = Scratch<double>(n_elements);
+            std::memcpy(
+                values.data(),
+                parameters_ptr + this->parameter_offsets[i],
+                n_elements * sizeof(double)
+            );
+            
+            PDSAPI_TIMED(ProteusDSAPI::SetDoubleArray(this->label(), command, dobject_name, values));
+        }
+        
+        NoteMetadataSet(this->label(), command);
+    }
+    
+    return;
+}   /* restore() */
+
+// ----------------------------------------------------------------------------------------------------- //
+
+
+
+// ----------------------------------------------------------------------------------------------------- //
+
+///
+/// \fn std::unique_ptr<SimulationSnapshot> Snapshot(
+///         const Simulation& simulation,
+///         std::vector<DoubleRequest> parameters
+///     )
+///
+/// \brief Captures a snapshot of the given simulation, with the GIL released.
+///
+/// \param simulation The target simulation.
+///
+/// \param parameters The (command, dobject name, n_elements) parameters to capture 
+///     alongside the state.
+///
+/// \return The snapshot.
+///
+
+std::unique_ptr<SimulationSnapshot> Snapshot(
+    const Simulation& simulation,
+    std::vector<DoubleRequest> parameters
+)
+{
+    SimulationGuard simulation_guard(simulation.label());
+    PDSAPI_TIME_CALL(FN_SNAPSHOT, -1, "");
+    
+    pybind11::gil_scoped_release release;
+    
+    return std::unique_ptr<SimulationSnapshot>(new SimulationSnapshot(simulation, parameters));
+}   /* Snapshot() */
+
+// ----------------------------------------------------------------------------------------------------- //
+
+
+
+// ----------------------------------------------------------------------------------------------------- //
+
+///
+/// \fn void Restore(const Simulation& simulation, SimulationSnapshot& snapshot)
+///
+/// \brief Restores the given snapshot into the given simulation, with the GIL released.
+///
+/// \param simulation The target simulation.
+///
+/// \param snapshot The snapshot to restore (which must be of the target simulation).
+///
+
+void Restore(const Simulation& simulation, SimulationSnapshot& snapshot)
+{
+    SimulationGuard simulation_guard(simulation.label());
+    PDSAPI_TIME_CALL(FN_RESTORE, -1, "");
+    
+    if (snapshot.unique_simulation_label_ptr != simulation.unique_simulation_label_ptr) {
+        std::string error_str = "ERROR: snapshot is of simulation " + snapshot.label();
+        error_str += ", not " + simulation.label();
+        
+        throw std::invalid_argument(error_str);
+    }
+    
+    pybind11::gil_scoped_release release;
+    snapshot.restore();
+    
+    return;
+}   /* Restore() */
+
+// ----------------------------------------------------------------------------------------------------- //
+
+// ==== END Snapshots ================================================================================== //
+
+
+
+// ==== Recorders ====================================================================================== //
+
+/*
+ *  A Recorder samples a set of (dobject, command, n_elements) channels (plus the time) after each
+ *  time step into a preallocated, columnar ring of fixed-size chunks. Full chunks are handed off to
+ *  a writer thread, which streams each channel to its own .npy file (float64, shape (rows, 
+ *  n_elements)), alongside a time.npy and an index.json that describes the channels. Since the
+ *  .npy headers are rewritten after every chunk, the files can be read back at any time, without
+ *  copying, by way of numpy.load(path, mmap_mode="r") (or numpy.memmap).
+ *
+ *  The sampling cost is bounded: a memcpy per channel, plus a brief lock at chunk boundaries. If
+ *  the writer falls so far behind that no chunk is free, samples are dropped (and counted) rather
+ *  than stalling the loop.
+ */
+
+#define PDSAPI_BINDINGS_NPY_HEADER_SIZE 128
+
+// ----------------------------------------------------------------------------------------------------- //
+
+///
+/// \fn std::string NpyHeader(size_t n_rows, size_t n_columns)
+///
+/// \brief Builds a (fixed size) .npy version 1.0 header for a C-ordered, little-endian 
+///     float64 array of shape (n_rows, n_columns), or (n_rows,) if n_columns is 0.
+///
+/// \param n_rows The number of rows.
+///
+/// \param n_columns The number of columns (0 for a 1D array).
+///
+/// \return The header (PDSAPI_BINDINGS_NPY_HEADER_SIZE bytes).
+///
+
+std::string NpyHeader(size_t n_rows, size_t n_columns)
+{
+    std::string shape_str = "(" + std::to_string(n_rows) + ",";
+    
+    if (n_columns > 0) {
+        shape_str += " " + std::to_string(n_columns);
+    }
+    
+    shape_str += ")";
+    
+    std::string dict_str = "{'descr': '<f8', 'fortran_order': False, 'shape': " + shape_str + ", }";
+    
+    size_t n_dict = PDSAPI_BINDINGS_NPY_HEADER_SIZE - 10;
+    dict_str.resize(n_dict - 1, ' ');
+    dict_str += '\n';
+    
+    std::string header_str = "\x93NUMPY";
+    header_str += (char)1;
+    header_str += (char)0;
+    header_str += (char)(n_dict & 0xFF);
+    header_str += (char)((n_dict >> 8) & 0xFF);
+    header_str += dict_str;
+    
+    return header_str;
+}   /* NpyHeader() */
+
+// ----------------------------------------------------------------------------------------------------- //
+
+
+
+// ----------------------------------------------------------------------------------------------------- //
+
+///
+/// \fn std::string JsonString(const std::string& str)
+///
+/// \brief Quotes a string as a JSON string literal, escaping quotes, backslashes, and control 
+///     characters (labels and dobject names are user-defined, so may contain any of these).
+///
+/// \param str The string to quote.
+///
+/// \return The quoted string.
+///
+
+std::string JsonString(const std::string& str)
+{
+    std::string json_str = "\"";
+    json_str.reserve(str.size() + 2);
+    
+    for (char c : str) {
+        switch (c) {
+            case '"':   json_str += "\\\"";  break;
+            case '\\':  json_str += "\\\\";  break;
+            case '\b':  json_str += "\\b";   break;
+            case '\f':  json_str += "\\f";   break;
+            case '\n':  json_str += "\\n";   break;
+            case '\r':  json_str += "\\r";   break;
+            case '\t':  json_str += "\\t";   break;
+            
+            default:
+                if ((unsigned char)c < 0x20) {
+                    json_str += "\\u00";
+                    json_str += "0123456789abcdef"[((unsigned char)c >> 4) & 0xF];
+                    json_str += "0123456789abcdef"[(unsigned char)c & 0xF];
+                }
+                
+                else {
+                    json_str += c;
+                }
+        }
+    }
+    
+    json_str += "\"";
+    
+    return json_str;
+}   /* JsonString() */
+
+// ----------------------------------------------------------------------------------------------------- //
+
+
+
+// ----------------------------------------------------------------------------------------------------- //
+
+///
+/// \struct RecorderChannel
+///
+/// \brief A single channel of a Recorder.
+///
+
+struct RecorderChannel {
+    DObjectHandle handle;
+    int command;
+    size_t n_elements;
+    size_t n_columns;
+    size_t chunk_offset;
+    std::vector<double> buffer;
+    std::string file_name;
+    std::ofstream file;
+};  /* RecorderChannel */
+
+// ----------------------------------------------------------------------------------------------------- //
+
+
+
+// ----------------------------------------------------------------------------------------------------- //
+
+///
+/// \class Recorder
+///
+/// \brief Samples channels into a ring of chunks, which a writer thread streams to disk.
+///     Each chunk holds the time column followed by each channel's block (chunk_rows x 
+///     n_columns, row-major).
+///
+
+class Recorder : public Observer {
+    private:
+        std::vector<double> ring;
+        size_t chunk_size;
+        
+        std::mutex sample_mutex;
+        std::mutex chunk_mutex;
+        std::condition_variable chunk_condition;
+        std::vector<size_t> free_chunks;
+        std::vector<std::pair<size_t, size_t>> full_chunks;
+        bool is_writing;
+        bool stop_writer;
+        
+        size_t current_chunk;
+        size_t current_row;
+        bool has_chunk;
+        
+        std::ofstream time_file;
+        std::thread writer_thread;
+        
+        void writeIndex(void);
+        void writeChunk(size_t, size_t);
+        void writerLoop(void);
+        void handOff(void);
+        
+    public:
+        const std::string* unique_simulation_label_ptr;
+        std::string directory;
+        size_t chunk_rows;
+        size_t n_chunks;
+        
+        std::vector<std::unique_ptr<RecorderChannel>> channels;
+        
+        std::atomic<size_t> rows_sampled;
+        std::atomic<size_t> rows_written;
+        std::atomic<size_t> rows_dropped;
+        bool is_open;
+        
+        Recorder(
+            const Simulation&,
+            std::vector<std::tuple<DObjectHandle, int, size_t>>,
+            std::string,
+            size_t,
+            size_t
+        );
+        ~Recorder(void);
+        
+        const std::string& label(void) const { return *(this->unique_simulation_label_ptr); }
+        
+        void observe(double) override;
+        void sample(void);
+        void flush(void);
+        void close(void);
+};  /* Recorder */
+
+// ----------------------------------------------------------------------------------------------------- //
+
+
+
+// ----------------------------------------------------------------------------------------------------- //
+
+///
+/// \fn Recorder::Recorder(
+///         const Simulation& simulation,
+///         std::vector<std::tuple<DObjectHandle, int, size_t>> channels,
+///         std::string directory,
+///         size_t chunk_rows,
+///         size_t n_chunks
+///     )
+///
+/// \brief Constructor for the Recorder class. Creates the output directory and files, 
+///     allocates the ring, and starts the writer thread.
+///
+/// \param simulation The target simulation.
+///
+/// \param channels The (dobject handle, command, n_elements) channels to sample (an 
+///     n_elements of 0 denotes a scalar attribute).
+///
+/// \param directory The output directory.
+///
+/// \param chunk_rows The number of rows per chunk.
+///
+/// \param n_chunks The number of chunks in the ring.
+///
+
+Recorder::Recorder(
+    const Simulation& simulation,
+    std::vector<std::tuple<DObjectHandle, int, size_t>> channels,
+    std::string directory,
+    size_t chunk_rows,
+    size_t n_chunks
+)
+{
+    if (chunk_rows == 0 || n_chunks < 2) {
+        throw std::invalid_argument("ERROR: recorder requires chunk_rows > 0 and n_chunks > 1");
+    }
+    
+    this->unique_simulation_label_ptr = simulation.unique_simulation_label_ptr;
+    this->directory = directory;
+    this->chunk_rows = chunk_rows;
+    this->n_chunks = n_chunks;
+    
+    this->rows_sampled = 0;
+    this->rows_written = 0;
+    this->rows_dropped = 0;
+    
+    std::filesystem::create_directories(directory);
+    
+    //  1. set up channels (and their files)
+    size_t chunk_offset = chunk_rows;     // time column comes first
+    
+    for (size_t i = 0; i < channels.size(); i++) {
+        const DObjectHandle& handle = std::get<0>(channels[i]);
+        
+        if (handle.unique_simulation_label_ptr != this->unique_simulation_label_ptr) {
+            throw std::invalid_argument("ERROR: channel dobject belongs to another simulation");
+        }
+        
+        std::unique_ptr<RecorderChannel> channel(new RecorderChannel());
+        channel->handle = handle;
+        channel->command = std::get<1>(channels[i]);
+        channel->n_elements = std::get<2>(channels[i]);
+        channel->n_columns = std::max(channel->n_elements, (size_t)1);
+        channel->chunk_offset = chunk_offset;
+        channel->buffer.resize(channel->n_elements, 0);
+        channel->file_name = "channel_" + std::to_string(i) + ".npy";
+        
+        channel->file.open(
+            (std::filesystem::path(directory) / channel->file_name).string(),
+            std::ios::binary | std::ios::trunc
+        );
+        
+        if (!channel->file.is_open()) {
+            throw std::runtime_error("ERROR: failed to open " + channel->file_name + " in " + directory);
+        }
+        
+        channel->file << NpyHeader(0, channel->n_columns);
+        
+        chunk_offset += chunk_rows * channel->n_columns;
+        this->channels.push_back(std::move(channel));
+    }
+    
+    this->time_file.open(
+        (std::filesystem::path(directory) / "time.npy").string(),
+        std::ios::binary | std::ios::trunc
+    );
+    
+    if (!this->time_file.is_open()) {
+        throw std::runtime_error("ERROR: failed to open time.npy in " + directory);
+    }
+    
+    this->time_file << NpyHeader(0, 0);
+    
+    //  2. allocate ring
+    this->chunk_size = chunk_offset;
+    this->ring.resize(n_chunks * this->chunk_size, 0);
+    
+    for (size_t i = n_chunks; i > 0; i--) {
+        this->free_chunks.push_back(i - 1);
+    }
+    
+    this->has_chunk = false;
+    this->current_chunk = 0;
+    this->current_row = 0;
+    
+    //  3. start writer
+    this->is_writing = false;
+    this->stop_writer = false;
+    this->writeIndex();
+    
+    this->writer_thread = std::thread(&Recorder::writerLoop, this);
+    this->is_open = true;
+    
+    return;
+}   /* Recorder() */
+
+// ----------------------------------------------------------------------------------------------------- //
+
+
+
+// ----------------------------------------------------------------------------------------------------- //
+
+///
+/// \fn Recorder::~Recorder(void)
+///
+/// \brief Destructor for the Recorder class. Closes the recorder (if not already closed).
+///
+
+Recorder::~Recorder(void)
+{
+    this->close();
+    
+    return;
+}   /* ~Recorder() */
+
+// ----------------------------------------------------------------------------------------------------- //
+
+
+
+// ----------------------------------------------------------------------------------------------------- //
+
+///
+/// \fn void Recorder::writeIndex(void)
+///
+/// \brief Helper method which (re)writes index.json.
+///
+
+void Recorder::writeIndex(void)
+{
+    std::ofstream index_file(
+        (std::filesystem::path(this->directory) / "index.json").string(),
+        std::ios::trunc
+    );
+    
+    index_file << "{\n";
+    index_file << "    \"simulation\": " << JsonString(this->label()) << ",\n";
+    index_file << "    \"rows\": " << this->rows_written << ",\n";
+    index_file << "    \"rows_dropped\": " << this->rows_dropped << ",\n";
+    index_file << "    \"time\": \"time.npy\",\n";
+    index_file << "    \"channels\": [";
+    
+    for (size_t i = 0; i < this->channels.size(); i++) {
+        const RecorderChannel& channel = *(this->channels[i]);
+        
+        index_file << (i == 0 ? "\n" : ",\n");
+        index_file << "        {\"file\": \"" << channel.file_name << "\", ";
+        index_file << "\"dobject\": " << JsonString(channel.handle.name()) << ", ";
+        index_file << "\"command\": " << channel.command << ", ";
+        index_file << "\"n_elements\": " << channel.n_elements << "}";
+    }
+    
+    index_file << "\n    ]\n}\n";
+    
+    return;
+}   /* writeIndex() */
+
+// ----------------------------------------------------------------------------------------------------- //
+
+
+
+// ----------------------------------------------------------------------------------------------------- //
+
+///
+/// \fn void Recorder::writeChunk(size_t chunk_index, size_t n_rows)
+///
+/// \brief Helper method (writer thread only) which appends the first n_rows rows of the
+///     given chunk to the files, and then rewrites the headers.
+///
+/// \param chunk_index The index of the chunk to write.
+///
+/// \param n_rows The number of rows in the chunk.
+///
+
+void Recorder::writeChunk(size_t chunk_index, size_t n_rows)
+{
+    const double* chunk_ptr = this->ring.data() + chunk_index * this->chunk_size;
+    size_t n_rows_total = this->rows_written + n_rows;
+    
+    this->time_file.seekp(0, std::ios::end);
+    this->time_file.write((const char*)chunk_ptr, n_rows * sizeof(double));
+    this->time_file.seekp(0, std::ios::beg);
+    this->time_file << NpyHeader(n_rows_total, 0);
+    this->time_file.flush();
+    
+    for (std::unique_ptr<RecorderChannel>& channel : this->channels) {
+        channel->file.seekp(0, std::ios::end);
+        channel->file.write(
+            (const char*)(chunk_ptr + channel->chunk_offset),
+            n_rows * channel->n_columns * sizeof(double)
+        );
+        channel->file.seekp(0, std::ios::beg);
+        channel->file << NpyHeader(n_rows_total, channel->n_columns);
+        channel->file.flush();
+    }
+    
+    this->rows_written = n_rows_total;
+    this->writeIndex();
+    
+    return;
+}   /* writeChunk() */
+
+// ----------------------------------------------------------------------------------------------------- //
+
+
+
+// ----------------------------------------------------------------------------------------------------- //
+
+///
+/// \fn void Recorder::writerLoop(void)
+///
+/// \brief The writer thread: writes full chunks (in order) as they are handed off, and 
+///     returns them to the free list.
+///
+
+void Recorder::writerLoop(void)
+{
+    std::unique_lock<std::mutex> lock(this->chunk_mutex);
+    
+    while (true) {
+        this->chunk_condition.wait(
+            lock,
+            [this]() { return this->stop_writer || !this->full_chunks.empty(); }
+        );
+        
+        if (this->full_chunks.empty()) {
+            return;     // stopping, and nothing left to write
+        }
+        
+        std::pair<size_t, size_t> chunk = this->full_chunks.front();
+        this->full_chunks.erase(this->full_chunks.begin());
+        this->is_writing = true;
+        
+        lock.unlock();
+        this->writeChunk(chunk.first, chunk.second);
+        lock.lock();
+        
+        this->is_writing = false;
+        this->free_chunks.push_back(chunk.first);
+        this->chunk_condition.notify_all();
+    }
+    
+    return;
+}   /* writerLoop() */
+
+// ----------------------------------------------------------------------------------------------------- //
+
+
+
+// ----------------------------------------------------------------------------------------------------- //
+
+///
+/// \fn void Recorder::handOff(void)
+///
+/// \brief Helper method which hands the current (full or partial) chunk off to the writer.
+///     Must be called with sample_mutex held.
+///
+
+void Recorder::handOff(void)
+{
+    if (!this->has_chunk || this->current_row == 0) {
+        return;
+    }
+    
+    {
+        std::lock_guard<std::mutex> lock(this->chunk_mutex);
+        this->full_chunks.push_back(std::make_pair(this->current_chunk, this->current_row));
+    }
+    
+    this->chunk_condition.notify_all();
+    
+    this->has_chunk = false;
+    this->current_row = 0;
+    
+    return;
+}   /* handOff() */
+
+// ----------------------------------------------------------------------------------------------------- //
+
+
+
+// ----------------------------------------------------------------------------------------------------- //
+
+///
+/// \fn void Recorder::observe(double time_s)
+///
+/// \brief Samples all channels (at the given time) into the next row of the ring. Drops 
+///     the sample if no chunk is free. Holds sample_mutex throughout, so that flush() and
+///     close() (from Python, while a loop is running) never race with a sample.
+///
+/// \param time_s The current simulation time [s].
+///
+
+void Recorder::observe(double time_s)
+{
+    std::lock_guard<std::mutex> sample_lock(this->sample_mutex);
+    
+    if (!this->is_open) {
+        return;
+    }
+    
+    if (!this->has_chunk) {
+        std::lock_guard<std::mutex> lock(this->chunk_mutex);
+        
+        if (this->free_chunks.empty()) {
+            this->rows_dropped++;
+            return;
+        }
+        
+        this->current_chunk = this->free_chunks.back();
+        this->free_chunks.pop_back();
+        this->has_chunk = true;
+        this->current_row = 0;
+    }
+    
+    double* chunk_ptr = this->ring.data() + this->current_chunk * this->chunk_size;
+    chunk_ptr[this->current_row] = time_s;
+    
+    for (std::unique_ptr<RecorderChannel>& channel : this->channels) {
+        double* row_ptr = chunk_ptr + channel->chunk_offset + this->current_row * channel->n_columns;
+        
+        if (channel->n_elements == 0) {
+            PDSAPI_TIMED(ProteusDSAPI::GetDouble(
+                this->label(),
+                channel->command,
+                channel->handle.name(),
+                *row_ptr
+            ));
+        }
+        
+        else {
+            PDSAPI_TIMED(ProteusDSAPI::GetDoubleArray(
+                this->label(),
+                channel->command,
+                channel->handle.name(),
+                channel->buffer
+            ));
+            
+            size_t n_copy = std::min(channel->buffer.size(), channel->n_elements);
+            std::memcpy(row_ptr, channel->buffer.data(), n_copy * sizeof(double));
+        }
+    }
+    
+    this->current_row++;
+    this->rows_sampled++;
+    
+    if (this->current_row == this->chunk_rows) {
+        this->handOff();
+    }
+    
+    return;
+}   /* observe() */
+
+// ----------------------------------------------------------------------------------------------------- //
+
+
+
+// ----------------------------------------------------------------------------------------------------- //
+
+///
+/// \fn void Recorder::sample(void)
+///
+/// \brief Samples all channels at the current simulation time (for use outside of 
+///     RunLoop, e.g., after each AdvanceTime in a Python loop).
+///
+
+void Recorder::sample(void)
+{
+    SimulationGuard simulation_guard(this->label());
+    
+    double time_s = 0;
+    PDSAPI_TIMED(ProteusDSAPI::GetDouble(this->label(), PDSAPI::PDSAPI::time, "", time_s));
+    
+    this->observe(time_s);
+    
+    return;
+}   /* sample() */
+
+// ----------------------------------------------------------------------------------------------------- //
+
+
+
+// ----------------------------------------------------------------------------------------------------- //
+
+///
+/// \fn void Recorder::flush(void)
+///
+/// \brief Hands off the current (partial) chunk, and blocks until everything sampled so 
+///     far has been written.
+///
+
+void Recorder::flush(void)
+{
+    {
+        std::lock_guard<std::mutex> sample_lock(this->sample_mutex);
+        this->handOff();
+    }
+    
+    std::unique_lock<std::mutex> lock(this->chunk_mutex);
+    this->chunk_condition.wait(
+        lock,
+        [this]() { return this->full_chunks.empty() && !this->is_writing; }
+    );
+    
+    return;
+}   /* flush() */
+
+// ----------------------------------------------------------------------------------------------------- //
+
+
+
+// ----------------------------------------------------------------------------------------------------- //
+
+///
+/// \fn void Recorder::close(void)
+///
+/// \brief Flushes, stops the writer thread, and closes the files.
+///
+
+void Recorder::close(void)
+{
+    {
+        std::lock_guard<std::mutex> sample_lock(this->sample_mutex);
+        
+        if (!this->is_open) {
+            return;
+        }
+        
+        this->is_open = false;
+        this->handOff();
+    }
+    
+    {
+        std::lock_guard<std::mutex> lock(this->chunk_mutex);
+        this->stop_writer = true;
+    }
+    
+    this->chunk_condition.notify_all();
+    this->writer_thread.join();
+    
+    this->time_file.close();
+    
+    for (std::unique_ptr<RecorderChannel>& channel : this->channels) {
+        channel->file.close();
+    }
+    
+    this->writeIndex();
+    
+    return;
+}   /* close() */
+
+// ----------------------------------------------------------------------------------------------------- //
+
+// ==== END Recorders ================================================================================== //
+
+
+
+// ==== Cable views ==================================================================================== //
+
+/*
+ *  Cable field arrays (e.g., PDSAPI::cablePositions, cableTensions) are sized by a separate 
+ *  *NumberOfSamplePoints query. Here, those sizes are served from the metadata cache (i.e., 
+ *  queried once per simulation, cable, and field, until something changes the cable), and fields 
+ *  are returned as correctly shaped numpy.ndarrays (e.g., (n, 3) for positions), filled in place 
+ *  from one API call per field.
+ */
+
+// ----------------------------------------------------------------------------------------------------- //
+
+///
+/// \struct CableFieldLayout
+///
+/// \brief The sample point count command and number of components (per sample point) of 
+///     a cable field.
+///
+
+struct CableFieldLayout {
+    int count_command;
+    size_t n_components;
+};  /* CableFieldLayout */
+
+// ----------------------------------------------------------------------------------------------------- //
+
+
+
+// ----------------------------------------------------------------------------------------------------- //
+
+///
+/// \fn CableFieldLayout GetCableFieldLayout(int field)
+///
+/// \brief Returns the layout of the given cable field, throwing if it is not a cable 
+///     field.
+///
+/// \param field The cable field (resolved by the PDSAPI::PDSAPI enumeration).
+///
+/// \return The layout of the given cable field. An n_components of 0 means that it is 
+///     given by PDSAPI::cableVonMisesNumberOfRadialSamplePoints.
+///
+
+CableFieldLayout GetCableFieldLayout(int field)
+{
+    switch (field) {
+        case (PDSAPI::PDSAPI::cablePositions):
+            return {PDSAPI::PDSAPI::cablePositionsNumberOfSamplePoints, 3};
+        
+        case (PDSAPI::PDSAPI::cableTensions):
+            return {PDSAPI::PDSAPI::cableTensionNumberOfSamplePoints, 1};
+        
+        case (PDSAPI::PDSAPI::cableBendingRadius):
+            return {PDSAPI::PDSAPI::cableBendingRadiusNumberOfSamplePoints, 1};
+        
+        case (PDSAPI::PDSAPI::cableVonMisesStress):
+            return {PDSAPI::PDSAPI::cableVonMisesNumberOfSamplePoints, 0};
+        
+        case (PDSAPI::PDSAPI::cableVonMisesRGB):
+            return {PDSAPI::PDSAPI::cableVonMisesNumberOfSamplePoints, 3};
+        
+        case (PDSAPI::PDSAPI::cableFlexuralStress):
+            return {PDSAPI::PDSAPI::cableFlexuralStressNumberOfSamplePoints, 1};
+        
+        case (PDSAPI::PDSAPI::cableTemperatures):
+            return {PDSAPI::PDSAPI::cableTemperaturesNumberOfSamplePoints, 1};
+        
+        case (PDSAPI::PDSAPI::cableTemperaturesRGB):
+            return {PDSAPI::PDSAPI::cableTemperaturesNumberOfSamplePoints, 3};
+        
+        default:
+            throw std::invalid_argument("ERROR: " + std::to_string(field) + " is not a cable field");
+    }
+}   /* GetCableFieldLayout() */
+
+// ----------------------------------------------------------------------------------------------------- //
+
+
+
+// ----------------------------------------------------------------------------------------------------- //
+
+///
+/// \fn std::pair<size_t, size_t> GetCableFieldShape(
+///         const std::string* unique_simulation_label_ptr,
+///         const std::string* cable_name_ptr,
+///         int field
+///     )
+///
+/// \brief Returns the (n_sample_points, n_components) shape of the given field of the 
+///     given cable, by way of the metadata cache (so the API is queried only on first use,
+///     or after the cable discretization may have changed).
+///
+/// \param unique_simulation_label_ptr The (interned) API label for the target simulation.
+///
+/// \param cable_name_ptr The (interned) name of the cable of interest.
+///
+/// \param field The cable field (resolved by the PDSAPI::PDSAPI enumeration).
+///
+/// \return The shape of the given field.
+///
+
+std::pair<size_t, size_t> GetCableFieldShape(
+    const std::string* unique_simulation_label_ptr,
+    const std::string* cable_name_ptr,
+    int field
+)
+{
+    CableFieldLayout layout = GetCableFieldLayout(field);
+    
+    auto get_count = [&](int count_command) {
+        return GetMetadata<int>(
+            FN_GET_INT,
+            *unique_simulation_label_ptr,
+            count_command,
+            *cable_name_ptr,
+            0,
+            [&]() {
+                int count = 0;
+                PDSAPI_TIMED(ProteusDSAPI::GetInt(
+                    *unique_simulation_label_ptr,
+                    count_command,
+                    *cable_name_ptr,
+                    count
+                ));
+                
+                return count;
+            }
+        );
+    };
+    
+    int n_sample_points = get_count(layout.count_command);
+    int n_components = (int)layout.n_components;
+    
+    if (n_components == 0) {
+        n_components = get_count(PDSAPI::PDSAPI::cableVonMisesNumberOfRadialSamplePoints);
+    }
+    
+    return std::pair<size_t, size_t>(std::max(n_sample_points, 0), std::max(n_components, 1));
+}   /* GetCableFieldShape() */
+
+// ----------------------------------------------------------------------------------------------------- //
+
+
+
+// ----------------------------------------------------------------------------------------------------- //
+
+///
+/// \fn void GetCableFieldInto(
+///         const std::string& unique_simulation_label,
+///         const std::string& cable_name,
+///         int field,
+///         double* out_ptr,
+///         size_t n_elements
+///     )
+///
+/// \brief Helper function which reads n_elements of the given cable field into out_ptr.
+///     Does not touch the GIL.
+///
+/// \param unique_simulation_label The API label for the target simulation.
+///
+/// \param cable_name The name of the cable of interest.
+///
+/// \param field The cable field (resolved by the PDSAPI::PDSAPI enumeration).
+///
+/// \param out_ptr Pointer to the buffer to be filled.
+///
+/// \param n_elements The number of elements to read.
+///
+
+void GetCableFieldInto(
+    const std::string& unique_simulation_label,
+    const std::string& cable_name,
+    int field,
+    double* out_ptr,
+    size_t n_elements
+)
+{
+    std::vector<double>& buffer = Scratch<double>(n_elements);
+    PDSAPI_TIMED(ProteusDSAPI::GetDoubleArray(unique_simulation_label, field, cable_name, buffer));
+    
+    size_t n_copy = std::min(buffer.size(), n_elements);
+    std::memcpy(out_ptr, buffer.data(), n_copy * sizeof(double));
+    
+    return;
+}   /* GetCableFieldInto() */
+
+// ----------------------------------------------------------------------------------------------------- //
+
+
+
+// ----------------------------------------------------------------------------------------------------- //
+
+///
+/// \fn pybind11::array_t<double> NewCableFieldArray(std::pair<size_t, size_t> shape)
+///
+/// \brief Helper function which allocates an array of the given cable field shape: 
+///     (n_sample_points, n_components), or (n_sample_points,) for a single component.
+///
+/// \param shape The (n_sample_points, n_components) shape.
+///
+/// \return The new array.
+///
+
+pybind11::array_t<double> NewCableFieldArray(std::pair<size_t, size_t> shape)
+{
+    if (shape.second == 1) {
+        return pybind11::array_t<double>((pybind11::ssize_t)shape.first);
+    }
+    
+    return pybind11::array_t<double>(
+        {(pybind11::ssize_t)shape.first, (pybind11::ssize_t)shape.second}
+    );
+}   /* NewCableFieldArray() */
+
+// ----------------------------------------------------------------------------------------------------- //
+
+
+
+// ----------------------------------------------------------------------------------------------------- //
+
+///
+/// \class CableView
+///
+/// \brief A resolved cable, whose fields are read as correctly shaped arrays.
+///
+
+class CableView {
+    public:
+        DObjectHandle handle;
+        
+        CableView(const Simulation&, std::string);
+        
+        std::pair<size_t, size_t> shape(int) const;
+        pybind11::array_t<double> get(int) const;
+        void getInto(int, pybind11::array_t<double, pybind11::array::c_style>) const;
+};  /* CableView */
+
+// ----------------------------------------------------------------------------------------------------- //
+
+
+
+// ----------------------------------------------------------------------------------------------------- //
+
+///
+/// \fn CableView::CableView(const Simulation& simulation, std::string cable_name)
+///
+/// \brief Constructor for the CableView class.
+///
+/// \param simulation The target simulation.
+///
+/// \param cable_name The name of the cable of interest.
+///
+
+CableView::CableView(const Simulation& simulation, std::string cable_name)
+{
+    this->handle = simulation.dobject(cable_name);
+    
+    return;
+}   /* CableView() */
+
+// ----------------------------------------------------------------------------------------------------- //
+
+
+
+// ----------------------------------------------------------------------------------------------------- //
+
+///
+/// \fn std::pair<size_t, size_t> CableView::shape(int field) const
+///
+/// \brief Returns the (n_sample_points, n_components) shape of the given field.
+///
+/// \param field The cable field (resolved by the PDSAPI::PDSAPI enumeration).
+///
+/// \return The shape of the given field.
+///
+
+std::pair<size_t, size_t> CableView::shape(int field) const
+{
+    SimulationGuard simulation_guard(this->handle.label());
+    
+    return GetCableFieldShape(
+        this->handle.unique_simulation_label_ptr,
+        this->handle.dobject_name_ptr,
+        field
+    );
+}   /* shape() */
+
+// ----------------------------------------------------------------------------------------------------- //
+
+
+
+// ----------------------------------------------------------------------------------------------------- //
+
+///
+/// \fn pybind11::array_t<double> CableView::get(int field) const
+///
+/// \brief Reads the given field into a new, correctly shaped array.
+///
+/// \param field The cable field (resolved by the PDSAPI::PDSAPI enumeration).
+///
+/// \return The field values.
+///
+
+pybind11::array_t<double> CableView::get(int field) const
+{
+    SimulationGuard simulation_guard(this->handle.label());
+    PDSAPI_TIME_CALL(FN_CABLE_VIEW_GET, field, this->handle.name());
+    
+    std::pair<size_t, size_t> field_shape = this->shape(field);
+    
+    pybind11::array_t<double> out = NewCableFieldArray(field_shape);
+    double* out_ptr = out.mutable_data();
+    
+    {
+        pybind11::gil_scoped_release release;
+        GetCableFieldInto(
+            this->handle.label(),
+            this->handle.name(),
+            field,
+            out_ptr,
+            field_shape.first * field_shape.second
+        );
+    }
+    
+    return out;
+}   /* get() */
+
+// ----------------------------------------------------------------------------------------------------- //
+
+
+
+// ----------------------------------------------------------------------------------------------------- //
+
+///
+/// \fn void CableView::getInto(
+///         int field,
+///         pybind11::array_t<double, pybind11::array::c_style> out
+///     ) const
+///
+/// \brief Reads the given field into the given (preallocated) array, which must have 
+///     exactly as many elements as the field.
+///
+/// \param field The cable field (resolved by the PDSAPI::PDSAPI enumeration).
+///
+/// \param out The numpy.ndarray to be filled.
+///
+
+void CableView::getInto(int field, pybind11::array_t<double, pybind11::array::c_style> out) const
+{
+    SimulationGuard simulation_guard(this->handle.label());
+    
+    std::pair<size_t, size_t> field_shape = this->shape(field);
+    size_t n_elements = field_shape.first * field_shape.second;
+    
+    if ((size_t)out.size() != n_elements) {
+        std::string error_str = "ERROR: field has " + std::to_string(n_elements);
+        error_str += " elements, but the given array has " + std::to_string(out.size());
+        
+        throw std::invalid_argument(error_str);
+    }
+    
+    double* out_ptr = out.mutable_data();
+    
+    {
+        pybind11::gil_scoped_release release;
+        GetCableFieldInto(this->handle.label(), this->handle.name(), field, out_ptr, n_elements);
+    }
+    
+    return;
+}   /* getInto() */
+
+// ----------------------------------------------------------------------------------------------------- //
+
+
+
+// ----------------------------------------------------------------------------------------------------- //
+
+///
+/// \fn pybind11::dict GetCableFields(
+///         const Simulation& simulation,
+///         std::vector<std::string> cable_names,
+///         std::vector<int> fields
+///     )
+///
+/// \brief Reads the given fields of each of the given cables (one API call per field per
+///     cable, with the GIL released) into new, correctly shaped arrays.
+///
+/// \param simulation The target simulation.
+///
+/// \param cable_names The names of the cables of interest.
+///
+/// \param fields The cable fields (resolved by the PDSAPI::PDSAPI enumeration).
+///
+/// \return A dict, keyed by cable name, of lists of arrays (one per field, in order).
+///
+
+pybind11::dict GetCableFields(
+    const Simulation& simulation,
+    std::vector<std::string> cable_names,
+    std::vector<int> fields
+)
+{
+    SimulationGuard simulation_guard(simulation.label());
+    PDSAPI_TIME_CALL(FN_GET_CABLE_FIELDS, -1, "");
+    
+    std::vector<CableView> views;
+    std::vector<double*> out_ptrs;
+    std::vector<size_t> out_sizes;
+    
+    pybind11::dict cable_dict;
+    
+    //  1. resolve shapes and allocate arrays (with the GIL)
+    for (const std::string& cable_name : cable_names) {
+        views.push_back(CableView(simulation, cable_name));
+        pybind11::list field_list;
+        
+        for (int field : fields) {
+            std::pair<size_t, size_t> field_shape = views.back().shape(field);
+            
+            pybind11::array_t<double> out = NewCableFieldArray(field_shape);
+            out_ptrs.push_back(out.mutable_data());
+            out_sizes.push_back(field_shape.first * field_shape.second);
+            
+            field_list.append(out);
+        }
+        
+        cable_dict[cable_name.c_str()] = field_list;
+    }
+    
+    //  2. fill arrays (without the GIL)
+    {
+        pybind11::gil_scoped_release release;
+        
+        for (size_t i = 0; i < views.size(); i++) {
+            for (size_t j = 0; j < fields.size(); j++) {
+                size_t k = i * fields.size() + j;
+                
+                GetCableFieldInto(
+                    views[i].handle.label(),
+                    views[i].handle.name(),
+                    fields[j],
+                    out_ptrs[k],
+                    out_sizes[k]
+                );
+            }
+        }
+    }
+    
+    return cable_dict;
+}   /* GetCableFields() */
+
+// ----------------------------------------------------------------------------------------------------- //
+
+// ==== END Cable views ================================================================================ //
+
+
+
+// ==== Rigid body fleets ============================================================================== //
+
+/*
+ *  GetRigidBodyFleet() reads the given fields of every RigidBody in a simulation (as discovered
+ *  and cached by Simulation::refresh()) into a single (n_bodies, k) matrix, where k is the total
+ *  width of the fields (concatenated in order). The matrix is Fortran-ordered (i.e., a structure
+ *  of arrays), so that each column (a single component of a single field, across the fleet) is 
+ *  contiguous, and it is filled with the GIL released. SetRigidBodyFleet() is the matching bulk 
+ *  setter (e.g., for PDSAPI::rigidBodyForceAndDerivGlobal and rigidBodyMomentAndDerivGlobal).
+ */
+
+// ----------------------------------------------------------------------------------------------------- //
+
+///
+/// \typedef FleetField
+///
+/// \brief A fleet field: either a command (of known width), or a (command, width) pair.
+///
+
+typedef std::variant<int, std::pair<int, size_t>> FleetField;
+
+// ----------------------------------------------------------------------------------------------------- //
+
+
+
+// ----------------------------------------------------------------------------------------------------- //
+
+///
+/// \fn size_t GetRigidBodyFieldWidth(const FleetField& field, int* command_ptr)
+///
+/// \brief Resolves the command and width of the given fleet field. Built-in widths cover
+///     only the 3-vectors and the (force, dforce/dt) and (moment, dmoment/dt) pairs (6 
+///     wide); anything else (e.g., the orientation, or mooring loads) must be given as a 
+///     (command, width) pair. Either way, GetRigidBodyFleet() checks the width the API 
+///     actually returns.
+///
+/// \param field The fleet field.
+///
+/// \param command_ptr Pointer to the resolved command.
+///
+/// \return The field width.
+///
+
+size_t GetRigidBodyFieldWidth(const FleetField& field, int* command_ptr)
+{
+    if (std::holds_alternative<std::pair<int, size_t>>(field)) {
+        *command_ptr = std::get<std::pair<int, size_t>>(field).first;
+        return std::get<std::pair<int, size_t>>(field).second;
+    }
+    
+    *command_ptr = std::get<int>(field);
+    
+    switch (*command_ptr) {
+        case (PDSAPI::PDSAPI::rigidBodyPosition):
+        case (PDSAPI::PDSAPI::rigidBodyVelocityGlobal):
+        case (PDSAPI::PDSAPI::rigidBodyVelocityBody):
+        case (PDSAPI::PDSAPI::rigidBodyAccelerationGlobal):
+        case (PDSAPI::PDSAPI::rigidBodyAccelerationBody):
+        case (PDSAPI::PDSAPI::rigidBodyAngularVelocityBody):
+        case (PDSAPI::PDSAPI::rigidBodyAngularAccelerationBody):
+            return 3;
+        
+        case (PDSAPI::PDSAPI::rigidBodyForceAndDerivGlobal):
+        case (PDSAPI::PDSAPI::rigidBodyForceAndDerivBody):
+        case (PDSAPI::PDSAPI::rigidBodyMomentAndDerivGlobal):
+        case (PDSAPI::PDSAPI::rigidBodyMomentAndDerivBody):
+            return 6;
+        
+        default:
+            std::string error_str = "ERROR: width of field " + std::to_string(*command_ptr);
+            error_str += " is not known; give it as a (command, width) pair";
+            
+            throw std::invalid_argument(error_str);
+    }
+}   /* GetRigidBodyFieldWidth() */
+
+// ----------------------------------------------------------------------------------------------------- //
+
+
+
+// ----------------------------------------------------------------------------------------------------- //
+
+///
+/// \fn pybind11::array_t<double, pybind11::array::f_style> GetRigidBodyFleet(
+///         const Simulation& simulation,
+///         std::vector<FleetField> fields
+///     )
+///
+/// \brief Reads the given fields of every RigidBody into a new (n_bodies, k) matrix (rows
+///     in the order of Simulation::rigid_body_name_ptrs), with the GIL released. Throws if
+///     the API returns a field of other than the expected width.
+///
+/// \param simulation The target simulation.
+///
+/// \param fields The fields (commands, or (command, width) pairs).
+///
+/// \return The (Fortran-ordered) matrix.
+///
+
+pybind11::array_t<double, pybind11::array::f_style> GetRigidBodyFleet(
+    const Simulation& simulation,
+    std::vector<FleetField> fields
+)
+{
+    SimulationGuard simulation_guard(simulation.label());
+    PDSAPI_TIME_CALL(FN_GET_RIGID_BODY_FLEET, -1, "");
+    
+    std::vector<int> commands(fields.size(), 0);
+    std::vector<size_t> widths(fields.size(), 0);
+    size_t n_columns = 0;
+    
+    for (size_t j = 0; j < fields.size(); j++) {
+        widths[j] = GetRigidBodyFieldWidth(fields[j], &(commands[j]));
+        n_columns += widths[j];
+    }
+    
+    size_t n_bodies = simulation.rigid_body_name_ptrs.size();
+    
+    pybind11::array_t<double, pybind11::array::f_style> out(
+        {(pybind11::ssize_t)n_bodies, (pybind11::ssize_t)n_columns}
+    );
+    double* out_ptr = out.mutable_data();
+    
+    {
+        pybind11::gil_scoped_release release;
+        
+        const std::string& unique_simulation_label = simulation.label();
+        
+        for (size_t j = 0, column = 0; j < fields.size(); column += widths[j], j++) {
+            std::vector<double>& buffer = Scratch<double>(widths[j]);
+            
+            for (size_t i = 0; i < n_bodies; i++) {
+                PDSAPI_TIMED(ProteusDSAPI::GetDoubleArray(
+                    unique_simulation_label,
+                    commands[j],
+                    *(simulation.rigid_body_name_ptrs[i]),
+                    buffer
+                ));
+                
+                if (buffer.size() != widths[j]) {
+                    std::string error_str = "ERROR: field " + std::to_string(commands[j]) + " of ";
+                    error_str += *(simulation.rigid_body_name_ptrs[i]) + " has width ";
+                    error_str += std::to_string(buffer.size()) + ", expected " + std::to_string(widths[j]);
+                    
+                    throw std::runtime_error(error_str);
+                }
+                
+                for (size_t c = 0; c < widths[j]; c++) {
+                    out_ptr[(column + c) * n_bodies + i] = buffer[c];
+                }
+            }
+        }
+    }
+    
+    return out;
+}   /* GetRigidBodyFleet() */
+
+// ----------------------------------------------------------------------------------------------------- //
+
+
+
+// ----------------------------------------------------------------------------------------------------- //
+
+///
+/// \fn void SetRigidBodyFleet(
+///         const Simulation& simulation,
+///         int command,
+///         pybind11::array_t<double> values,
+///         bool clear_forces
+///     )
+///
+/// \brief Writes the given (n_bodies, width) matrix (of any memory order) to every 
+///     RigidBody (rows in the order of Simulation::rigid_body_name_ptrs), one row per body, 
+///     with the GIL released.
+///
+/// \param simulation The target simulation.
+///
+/// \param command The field to set (e.g., PDSAPI::rigidBodyForceAndDerivGlobal).
+///
+/// \param values The (n_bodies, width) matrix.
+///
+/// \param clear_forces If true, clear each body's force accumulator first.
+///
+
+void SetRigidBodyFleet(
+    const Simulation& simulation,
+    int command,
+    pybind11::array_t<double> values,
+    bool clear_forces
+)
+{
+    SimulationGuard simulation_guard(simulation.label());
+    PDSAPI_TIME_CALL(FN_SET_RIGID_BODY_FLEET, command, "");
+    
+    size_t n_bodies = simulation.rigid_body_name_ptrs.size();
+    
+    if (values.ndim() != 2 || (size_t)values.shape(0) != n_bodies) {
+        std::string error_str = "ERROR: expected an (" + std::to_string(n_bodies);
+        error_str += ", width) matrix";
+        
+        throw std::invalid_argument(error_str);
+    }
+    
+    size_t width = values.shape(1);
+    auto values_view = values.unchecked<2>();
+    
+    {
+        pybind11::gil_scoped_release release;
+        
+        const std::string& unique_simulation_label = simulation.label();
+        std::vector<double>& buffer = Scratch<double>(width);
+        
+        for (size_t i = 0; i < n_bodies; i++) {
+            const std::string& dobject_name = *(simulation.rigid_body_name_ptrs[i]);
+            
+            if (clear_forces) {
+                PDSAPI_TIMED(ProteusDSAPI::SetInt(
+                    unique_simulation_label,
+                    PDSAPI::PDSAPI::rigidBodyClearForcesMoments,
+                    dobject_name,
+                    1
+                ));
+            }
+            
+            for (size_t c = 0; c < width; c++) {
+                buffer[c] = values_view(i, c);
+            }
+            
+            PDSAPI_TIMED(ProteusDSAPI::SetDoubleArray(unique_simulation_label, command, dobject_name, buffer));
+        }
+    }
+    
+    return;
+}   /* SetRigidBodyFleet() */
+
+// ----------------------------------------------------------------------------------------------------- //
+
+// ==== END Rigid body fleets ========================================================================== //
+
+
+
+// ==== Publishers ===================================================================================== //
+
+/*
+ *  A Publisher samples a set of (dobject, command, n_elements) channels (plus the time) after each
+ *  time step, and publishes them as the latest frame in a named shared memory segment, so that 
+ *  other processes (viewers, dashboards, loggers) can sample it at their own rate without ever 
+ *  blocking the writer. The segment (POSIX shm_open(), or a named file mapping on Windows) is laid 
+ *  out as
+ *
+ *      [0, 128)                    PublisherHeader (little-endian uint64s)
+ *      [128, slot_offset)          the channel index (JSON, NUL padded)
+ *      [slot_offset, ...)          n_slots (= 2) frames of frame_bytes each: the time, followed 
+ *                                  by each channel's n_columns doubles, in order
+ *
+ *  Each slot is guarded by its own sequence counter (a seqlock: odd while being written). The
+ *  writer fills the slot that is *not* the latest, and then flips latest_slot, so a reader that
+ *  copies the latest slot and finds its sequence unchanged (and even) has a consistent frame, and
+ *  readers only ever have to retry if they are more than a whole frame behind. The writer shares
+ *  no locks with readers, and makes no copies beyond the one into the segment. Readers poll 
+ *  version until it is nonzero (i.e., the segment is fully initialized). See 
+ *  ProteusDSAPIReader.py for a reader. Creating a Publisher replaces a closed segment of the same
+ *  name, but fails if a live one (is_closed unset) exists.
+ */
+
+#ifdef PDSAPI_BINDINGS_HAS_FORK
+    #define PDSAPI_BINDINGS_HAS_SHM
+#elif defined(_WIN32)
+    #define PDSAPI_BINDINGS_HAS_SHM
+#endif
+
+#ifdef PDSAPI_BINDINGS_HAS_SHM
+
+#define PDSAPI_BINDINGS_SHM_VERSION 1
+#define PDSAPI_BINDINGS_SHM_N_SLOTS 2
+#define PDSAPI_BINDINGS_SHM_ALIGNMENT 64
+
+// ----------------------------------------------------------------------------------------------------- //
+
+///
+/// \struct PublisherHeader
+///
+/// \brief The header at the start of a Publisher's shared memory segment (128 bytes).
+///
+
+struct PublisherHeader {
+    std::atomic<uint64_t> version;
+    uint64_t n_slots;
+    uint64_t frame_bytes;
+    uint64_t index_offset;
+    uint64_t index_bytes;
+    uint64_t slot_offset;
+    std::atomic<uint64_t> latest_slot;
+    std::atomic<uint64_t> frames_published;
+    std::atomic<uint64_t> is_closed;
+    std::atomic<uint64_t> slot_sequences[PDSAPI_BINDINGS_SHM_N_SLOTS];
+    std::atomic<uint64_t> slot_frames[PDSAPI_BINDINGS_SHM_N_SLOTS];
+    uint64_t reserved[3];
+};  /* PublisherHeader */
+
+static_assert(sizeof(PublisherHeader) == 128, "PublisherHeader must be 128 bytes");
+static_assert(std::atomic<uint64_t>::is_always_lock_free, "shared memory requires lock free atomics");
+
+// ----------------------------------------------------------------------------------------------------- //
+
+
+
+#ifndef _WIN32
+
+// ----------------------------------------------------------------------------------------------------- //
+
+///
+/// \fn bool IsClosedSegment(const std::string& posix_name)
+///
+/// \brief Returns whether the given (existing) POSIX shared memory segment is that of a
+///     closed Publisher (fully initialized, with is_closed set), and so may be replaced.
+///
+/// \param posix_name The name of the segment (with its leading slash).
+///
+/// \return Whether the segment is that of a closed Publisher.
+///
+
+bool IsClosedSegment(const std::string& posix_name)
+{
+    int file_descriptor = shm_open(posix_name.c_str(), O_RDONLY, 0);
+    
+    if (file_descriptor < 0) {
+        return false;
+    }
+    
+    struct stat file_stat;
+    
+    if (fstat(file_descriptor, &file_stat) != 0 || (size_t)file_stat.st_size < sizeof(PublisherHeader)) {
+        close(file_descriptor);
+        return false;
+    }
+    
+    void* ptr = mmap(nullptr, sizeof(PublisherHeader), PROT_READ, MAP_SHARED, file_descriptor, 0);
+    close(file_descriptor);
+    
+    if (ptr == MAP_FAILED) {
+        return false;
+    }
+    
+    const PublisherHeader* header_ptr = (const PublisherHeader*)ptr;
+    bool is_closed = (
+        header_ptr->version.load(std::memory_order_acquire) == PDSAPI_BINDINGS_SHM_VERSION &&
+        header_ptr->is_closed.load(std::memory_order_acquire) != 0
+    );
+    
+    munmap(ptr, sizeof(PublisherHeader));
+    
+    return is_closed;
+}   /* IsClosedSegment() */
+
+// ----------------------------------------------------------------------------------------------------- //
+
+#endif  /* _WIN32 */
+
+
+
+// ----------------------------------------------------------------------------------------------------- //
+
+///
+/// \class SharedSegment
+///
+/// \brief A named shared memory segment, created (replacing a closed Publisher's segment 
+///     of the same name, but never one still in use) and zero filled on construction, and 
+///     unmapped (and, optionally, unlinked) on destruction.
+///
+
+class SharedSegment {
+    private:
+        #ifdef _WIN32
+            HANDLE mapping_handle;
+        #endif
+        
+    public:
+        std::string name;
+        void* ptr;
+        size_t n_bytes;
+        bool unlink_on_close;
+        
+        SharedSegment(std::string, size_t, bool);
+        SharedSegment(const SharedSegment&) = delete;
+        SharedSegment& operator=(const SharedSegment&) = delete;
+        ~SharedSegment(void);
+        
+        char* chars(void) const { return (char*)(this->ptr); }
+};  /* SharedSegment */
+
+
+SharedSegment::SharedSegment(std::string name, size_t n_bytes, bool unlink_on_close)
+{
+    if (name.empty() || name.find('/') != std::string::npos || name.find('\\') != std::string::npos) {
+        throw std::invalid_argument("ERROR: shared memory name must be nonempty, without slashes");
+    }
+    
+    this->name = name;
+    this->n_bytes = n_bytes;
+    this->unlink_on_close = unlink_on_close;
+    
+    #ifdef _WIN32
+        this->mapping_handle = CreateFileMappingA(
+            INVALID_HANDLE_VALUE,
+            nullptr,
+            PAGE_READWRITE,
+            (DWORD)((uint64_t)n_bytes >> 32),
+            (DWORD)((uint64_t)n_bytes & 0xFFFFFFFF),
+            name.c_str()
+        );
+        
+        if (this->mapping_handle == nullptr) {
+            std::string error_str = "ERROR: failed to create shared memory " + name;
+            error_str += " (error " + std::to_string(GetLastError()) + ")";
+            
+            throw std::runtime_error(error_str);
+        }
+        
+        if (GetLastError() == ERROR_ALREADY_EXISTS) {
+            CloseHandle(this->mapping_handle);
+            throw std::runtime_error("ERROR: shared memory " + name + " is already in use");
+        }
+        
+        this->ptr = MapViewOfFile(this->mapping_handle, FILE_MAP_ALL_ACCESS, 0, 0, n_bytes);
+        
+        if (this->ptr == nullptr) {
+            CloseHandle(this->mapping_handle);
+            throw std::runtime_error("ERROR: failed to map shared memory " + name);
+        }
+    #else
+        std::string posix_name = "/" + name;
+        
+        int file_descriptor = shm_open(posix_name.c_str(), O_CREAT | O_EXCL | O_RDWR, 0644);
+        
+        //  a segment left behind by a closed writer is replaced (not reused); a live one is not
+        if (file_descriptor < 0 && errno == EEXIST) {
+            if (!IsClosedSegment(posix_name)) {
+                std::string error_str = "ERROR: shared memory " + name + " is already in use (if its ";
+                error_str += "writer crashed, remove it, e.g., /dev/shm/" + name + ")";
+                
+                throw std::runtime_error(error_str);
+            }
+            
+            shm_unlink(posix_name.c_str());
+            file_descriptor = shm_open(posix_name.c_str(), O_CREAT | O_EXCL | O_RDWR, 0644);
+        }
+        
+        if (file_descriptor < 0) {
+            std::string error_str = "ERROR: failed to create shared memory " + name + ": ";
+            error_str += strerror(errno);
+            
+            throw std::runtime_error(error_str);
+        }
+        
+        if (ftruncate(file_descriptor, (off_t)n_bytes) != 0) {
+            std::string error_str = "ERROR: failed to size shared memory " + name + ": ";
+            error_str += strerror(errno);
+            
+            close(file_descriptor);
+            shm_unlink(posix_name.c_str());
+            
+            throw std::runtime_error(error_str);
+        }
+        
+        this->ptr = mmap(nullptr, n_bytes, PROT_READ | PROT_WRITE, MAP_SHARED, file_descriptor, 0);
+        close(file_descriptor);
+        
+        if (this->ptr == MAP_FAILED) {
+            shm_unlink(posix_name.c_str());
+            throw std::runtime_error("ERROR: failed to map shared memory " + name + ": " + strerror(errno));
+        }
+    #endif
+    
+    std::memset(this->ptr, 0, n_bytes);
+    
+    return;
+}   /* SharedSegment() */
+
+
+SharedSegment::~SharedSegment(void)
+{
+    #ifdef _WIN32
+        //  a named file mapping is released along with its last handle
+        UnmapViewOfFile(this->ptr);
+        CloseHandle(this->mapping_handle);
+    #else
+        munmap(this->ptr, this->n_bytes);
+        
+        if (this->unlink_on_close) {
+            shm_unlink(("/" + this->name).c_str());
+        }
+    #endif
+    
+    return;
+}   /* ~SharedSegment() */
+
+// ----------------------------------------------------------------------------------------------------- //
+
+
+
+// ----------------------------------------------------------------------------------------------------- //
+
+///
+/// \struct PublisherChannel
+///
+/// \brief A single channel of a Publisher.
+///
+
+struct PublisherChannel {
+    DObjectHandle handle;
+    int command;
+    size_t n_elements;
+    size_t n_columns;
+    size_t frame_offset;
+};  /* PublisherChannel */
+
+// ----------------------------------------------------------------------------------------------------- //
+
+
+
+// ----------------------------------------------------------------------------------------------------- //
+
+///
+/// \class Publisher
+///
+/// \brief Samples channels after each time step, and publishes them as the latest frame 
+///     in a double buffered, seqlocked shared memory segment.
+///
+
+class Publisher : public Observer {
+    private:
+        std::mutex publish_mutex;
+        std::unique_ptr<SharedSegment> segment;
+        std::vector<double> frame;
+        std::vector<double> buffer;
+        
+        PublisherHeader* header(void) const { return (PublisherHeader*)(this->segment->ptr); }
+        
+        std::string indexJson(void) const;
+        
+    public:
+        const std::string* unique_simulation_label_ptr;
+        std::string name;
+        std::vector<PublisherChannel> channels;
+        
+        std::atomic<size_t> frames_published;
+        bool is_open;
+        
+        Publisher(
+            const Simulation&,
+            std::vector<std::tuple<DObjectHandle, int, size_t>>,
+            std::string,
+            bool
+        );
+        ~Publisher(void);
+        
+        const std::string& label(void) const { return *(this->unique_simulation_label_ptr); }
+        
+        void observe(double) override;
+        void publish(void);
+        void close(void);
+};  /* Publisher */
+
+// ----------------------------------------------------------------------------------------------------- //
+
+
+
+// ----------------------------------------------------------------------------------------------------- //
+
+///
+/// \fn Publisher::Publisher(
+///         const Simulation& simulation,
+///         std::vector<std::tuple<DObjectHandle, int, size_t>> channels,
+///         std::string name,
+///         bool unlink_on_close
+///     )
+///
+/// \brief Constructor for the Publisher class. Lays out the frame, and creates and 
+///     initializes the shared memory segment.
+///
+/// \param simulation The target simulation.
+///
+/// \param channels The (dobject handle, command, n_elements) channels to publish (an 
+///     n_elements of 0 denotes a scalar attribute).
+///
+/// \param name The name of the shared memory segment (as passed to, e.g., 
+///     multiprocessing.shared_memory.SharedMemory on the reader side).
+///
+/// \param unlink_on_close If true, remove the segment's name on close (POSIX only; on 
+///     Windows, the segment lives as long as any process has it open).
+///
+
+Publisher::Publisher(
+    const Simulation& simulation,
+    std::vector<std::tuple<DObjectHandle, int, size_t>> channels,
+    std::string name,
+    bool unlink_on_close
+)
+{
+    this->unique_simulation_label_ptr = simulation.unique_simulation_label_ptr;
+    this->name = name;
+    this->frames_published = 0;
+    this->is_open = false;
+    
+    //  1. lay out frame (time first)
+    size_t frame_offset = 1;
+    size_t max_elements = 0;
+    
+    for (size_t i = 0; i < channels.size(); i++) {
+        const DObjectHandle& handle = std::get<0>(channels[i]);
+        
+        if (handle.unique_simulation_label_ptr != this->unique_simulation_label_ptr) {
+            throw std::invalid_argument("ERROR: channel dobject belongs to another simulation");
+        }
+        
+        PublisherChannel channel;
+        channel.handle = handle;
+        channel.command = std::get<1>(channels[i]);
+        channel.n_elements = std::get<2>(channels[i]);
+        channel.n_columns = std::max(channel.n_elements, (size_t)1);
+        channel.frame_offset = frame_offset;
+        
+        frame_offset += channel.n_columns;
+        max_elements = std::max(max_elements, channel.n_elements);
+        this->channels.push_back(channel);
+    }
+    
+    this->frame.resize(frame_offset, 0);
+    this->buffer.resize(max_elements, 0);
+    
+    //  2. create segment
+    std::string index_str = this->indexJson();
+    
+    auto align = [](size_t n_bytes) {
+        return ((n_bytes + PDSAPI_BINDINGS_SHM_ALIGNMENT - 1) / PDSAPI_BINDINGS_SHM_ALIGNMENT)
+            * PDSAPI_BINDINGS_SHM_ALIGNMENT;
+    };
+    
+    size_t frame_bytes = align(frame_offset * sizeof(double));
+    size_t slot_offset = align(sizeof(PublisherHeader) + index_str.size() + 1);
+    
+    this->segment.reset(
+        new SharedSegment(
+            name,
+            slot_offset + PDSAPI_BINDINGS_SHM_N_SLOTS * frame_bytes,
+            unlink_on_close
+        )
+    );
+    
+    //  3. initialize header and index (version last, so that readers see a complete segment)
+    PublisherHeader* header_ptr = this->header();
+    
+    header_ptr->n_slots = PDSAPI_BINDINGS_SHM_N_SLOTS;
+    header_ptr->frame_bytes = frame_bytes;
+    header_ptr->index_offset = sizeof(PublisherHeader);
+    header_ptr->index_bytes = index_str.size();
+    header_ptr->slot_offset = slot_offset;
+    header_ptr->latest_slot.store(0, std::memory_order_relaxed);
+    
+    std::memcpy(this->segment->chars() + sizeof(PublisherHeader), index_str.data(), index_str.size());
+    
+    header_ptr->version.store(PDSAPI_BINDINGS_SHM_VERSION, std::memory_order_release);
+    
+    this->is_open = true;
+    
+    return;
+}   /* Publisher() */
+
+// ----------------------------------------------------------------------------------------------------- //
+
+
+
+// ----------------------------------------------------------------------------------------------------- //
+
+///
+/// \fn Publisher::~Publisher(void)
+///
+/// \brief Destructor for the Publisher class. Closes the publisher (if not already closed).
+///
+
+Publisher::~Publisher(void)
+{
+    this->close();
+    
+    return;
+}   /* ~Publisher() */
+
+// ----------------------------------------------------------------------------------------------------- //
+
+
+
+// ----------------------------------------------------------------------------------------------------- //
+
+///
+/// \fn std::string Publisher::indexJson(void) const
+///
+/// \brief Helper method which builds the channel index (JSON) written into the segment.
+///
+/// \return The channel index.
+///
+
+std::string Publisher::indexJson(void) const
+{
+    std::string index_str = "{\"simulation\": " + JsonString(this->label()) + ", \"channels\": [";
+    
+    for (size_t i = 0; i < this->channels.size(); i++) {
+        const PublisherChannel& channel = this->channels[i];
+        
+        index_str += (i == 0 ? "" : ", ");
+        index_str += "{\"dobject\": " + JsonString(channel.handle.name()) + ", ";
+        index_str += "\"command\": " + std::to_string(channel.command) + ", ";
+        index_str += "\"n_elements\": " + std::to_string(channel.n_elements) + ", ";
+        index_str += "\"offset\": " + std::to_string(channel.frame_offset) + "}";
+    }
+    
+    index_str += "]}";
+    
+    return index_str;
+}   /* indexJson() */
+
+// ----------------------------------------------------------------------------------------------------- //
+
+
+
+// ----------------------------------------------------------------------------------------------------- //
+
+///
+/// \fn void Publisher::observe(double time_s)
+///
+/// \brief Samples all channels (at the given time) into a private frame, and then copies 
+///     it into the non-latest slot (under that slot's seqlock) and makes it the latest. 
+///     Single writer only. Holds publish_mutex throughout, so that close() (from Python, 
+///     while a loop is running) never releases the segment under it.
+///
+/// \param time_s The current simulation time [s].
+///
+
+void Publisher::observe(double time_s)
+{
+    std::lock_guard<std::mutex> publish_lock(this->publish_mutex);
+    
+    if (!this->is_open) {
+        return;
+    }
+    
+    //  1. sample (outside of the seqlock, since API calls dominate)
+    this->frame[0] = time_s;
+    
+    for (const PublisherChannel& channel : this->channels) {
+        double* row_ptr = this->frame.data() + channel.frame_offset;
+        
+        if (channel.n_elements == 0) {
+            PDSAPI_TIMED(ProteusDSAPI::GetDouble(
+                this->label(),
+                channel.command,
+                channel.handle.name(),
+                *row_ptr
+            ));
+        }
+        
+        else {
+            this->buffer.resize(channel.n_elements);
+            
+            PDSAPI_TIMED(ProteusDSAPI::GetDoubleArray(
+                this->label(),
+                channel.command,
+                channel.handle.name(),
+                this->buffer
+            ));
+            
+            size_t n_copy = std::min(this->buffer.size(), channel.n_elements);
+            std::memcpy(row_ptr, this->buffer.data(), n_copy * sizeof(double));
+        }
+    }
+    
+    //  2. publish
+    PublisherHeader* header_ptr = this->header();
+    
+    size_t slot = (header_ptr->latest_slot.load(std::memory_order_relaxed) + 1) % PDSAPI_BINDINGS_SHM_N_SLOTS;
+    uint64_t sequence = header_ptr->slot_sequences[slot].load(std::memory_order_relaxed);
+    uint64_t frame_number = this->frames_published + 1;
+    
+    header_ptr->slot_sequences[slot].store(sequence + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    
+    std::memcpy(
+        this->segment->chars() + header_ptr->slot_offset + slot * header_ptr->frame_bytes,
+        this->frame.data(),
+        this->frame.size() * sizeof(double)
+    );
+    header_ptr->slot_frames[slot].store(frame_number, std::memory_order_relaxed);
+    
+    header_ptr->slot_sequences[slot].store(sequence + 2, std::memory_order_release);
+    header_ptr->latest_slot.store(slot, std::memory_order_release);
+    header_ptr->frames_published.store(frame_number, std::memory_order_release);
+    
+    this->frames_published = frame_number;
+    
+    return;
+}   /* observe() */
+
+// ----------------------------------------------------------------------------------------------------- //
+
+
+
+// ----------------------------------------------------------------------------------------------------- //
+
+///
+/// \fn void Publisher::publish(void)
+///
+/// \brief Publishes all channels at the current simulation time (for use outside of 
+///     RunLoop, e.g., after each AdvanceTime in a Python loop).
+///
+
+void Publisher::publish(void)
+{
+    SimulationGuard simulation_guard(this->label());
+    
+    double time_s = 0;
+    PDSAPI_TIMED(ProteusDSAPI::GetDouble(this->label(), PDSAPI::PDSAPI::time, "", time_s));
+    
+    this->observe(time_s);
+    
+    return;
+}   /* publish() */
+
+// ----------------------------------------------------------------------------------------------------- //
+
+
+
+// ----------------------------------------------------------------------------------------------------- //
+
+///
+/// \fn void Publisher::close(void)
+///
+/// \brief Marks the segment as closed (so that readers can stop), and releases it (once
+///     any observe() in progress has finished).
+///
+
+void Publisher::close(void)
+{
+    std::lock_guard<std::mutex> publish_lock(this->publish_mutex);
+    
+    if (!this->is_open) {
+        return;
+    }
+    
+    this->is_open = false;
+    this->header()->is_closed.store(1, std::memory_order_release);
+    this->segment.reset();
+    
+    return;
+}   /* close() */
+
+// ----------------------------------------------------------------------------------------------------- //
+
+#endif  /* PDSAPI_BINDINGS_HAS_SHM */
+
+// ==== END Publishers ================================================================================= //
+
+
+
+// ==== Forcing streams ================================================================================ //
+
+/*
+ *  A ForcingStream replays a columnar time series (e.g., a measured sea state, or external 
+ *  per-body loads) into a simulation: before each time step, it interpolates (linearly, holding 
+ *  the end values outside of the record) every channel at the current simulation time, and
+ *  applies them by way of SetDouble or SetDoubleArray. The time series is a set of .npy files 
+ *  (float64, C-ordered): a time file of shape (n_rows,), strictly increasing, and one file per 
+ *  channel of shape (n_rows,) or (n_rows, n_columns). The directories written by a Recorder are 
+ *  valid input.
+ *
+ *  The files are memory mapped (read only), rather than loaded, and the pages in a window ahead of
+ *  the read cursor are prefetched (madvise(MADV_WILLNEED), or PrefetchVirtualMemory() on Windows),
+ *  while those more than a window behind it are released (madvise(MADV_DONTNEED), or 
+ *  VirtualUnlock() on Windows), so that resident memory stays flat however long the record is.
+ *
+ *  Load channels (rigidBody*AndDeriv*) add to a body's force accumulator, so by default the stream
+ *  clears the forces of each body it loads before applying; when other controllers act on the
+ *  same bodies, run the stream first (or at the highest priority).
+ */
+
+#ifdef PDSAPI_BINDINGS_HAS_SHM     // i.e., memory mapping is available
+
+// ----------------------------------------------------------------------------------------------------- //
+
+///
+/// \class MappedFile
+///
+/// \brief A read only memory mapping of a whole file.
+///
+
+class MappedFile {
+    private:
+        #ifdef _WIN32
+            HANDLE file_handle;
+            HANDLE mapping_handle;
+        #endif
+        
+        void range(size_t, size_t, char**, size_t*) const;
+        
+    public:
+        std::string path;
+        const char* data;
+        size_t n_bytes;
+        
+        MappedFile(std::string);
+        MappedFile(const MappedFile&) = delete;
+        MappedFile& operator=(const MappedFile&) = delete;
+        ~MappedFile(void);
+        
+        void willNeed(size_t, size_t) const;
+        void dontNeed(size_t, size_t) const;
+};  /* MappedFile */
+
+
+MappedFile::MappedFile(std::string path)
+{
+    this->path = path;
+    this->data = nullptr;
+    this->n_bytes = 0;
+    
+    #ifdef _WIN32
+        this->file_handle = CreateFileA(
+            path.c_str(),
+            GENERIC_READ,
+            FILE_SHARE_READ,
+            nullptr,
+            OPEN_EXISTING,
+            FILE_ATTRIBUTE_NORMAL,
+            nullptr
+        );
+        
+        if (this->file_handle == INVALID_HANDLE_VALUE) {
+            throw std::runtime_error("ERROR: failed to open " + path);
+        }
+        
+        LARGE_INTEGER file_size;
+        
+        if (!GetFileSizeEx(this->file_handle, &file_size) || file_size.QuadPart == 0) {
+            CloseHandle(this->file_handle);
+            throw std::runtime_error("ERROR: failed to size (or empty) " + path);
+        }
+        
+        this->n_bytes = (size_t)file_size.QuadPart;
+        this->mapping_handle = CreateFileMappingA(this->file_handle, nullptr, PAGE_READONLY, 0, 0, nullptr);
+        
+        if (this->mapping_handle == nullptr) {
+            CloseHandle(this->file_handle);
+            throw std::runtime_error("ERROR: failed to map " + path);
+        }
+        
+        this->data = (const char*)MapViewOfFile(this->mapping_handle, FILE_MAP_READ, 0, 0, 0);
+        
+        if (this->data == nullptr) {
+            CloseHandle(this->mapping_handle);
+            CloseHandle(this->file_handle);
+            throw std::runtime_error("ERROR: failed to map " + path);
+        }
+    #else
+        int file_descriptor = open(path.c_str(), O_RDONLY);
+        
+        if (file_descriptor < 0) {
+            throw std::runtime_error("ERROR: failed to open " + path + ": " + strerror(errno));
+        }
+        
+        struct stat file_stat;
+        
+        if (fstat(file_descriptor, &file_stat) != 0 || file_stat.st_size == 0) {
+            close(file_descriptor);
+            throw std::runtime_error("ERROR: failed to size (or empty) " + path);
+        }
+        
+        this->n_bytes = (size_t)file_stat.st_size;
+        void* ptr = mmap(nullptr, this->n_bytes, PROT_READ, MAP_SHARED, file_descriptor, 0);
+        close(file_descriptor);
+        
+        if (ptr == MAP_FAILED) {
+            throw std::runtime_error("ERROR: failed to map " + path + ": " + strerror(errno));
+        }
+        
+        this->data = (const char*)ptr;
+    #endif
+    
+    return;
+}   /* MappedFile() */
+
+
+MappedFile::~MappedFile(void)
+{
+    #ifdef _WIN32
+        UnmapViewOfFile(this->data);
+        CloseHandle(this->mapping_handle);
+        CloseHandle(this->file_handle);
+    #else
+        munmap((void*)(this->data), this->n_bytes);
+    #endif
+    
+    return;
+}   /* ~MappedFile() */
+
+// ----------------------------------------------------------------------------------------------------- //
+
+
+
+// ----------------------------------------------------------------------------------------------------- //
+
+///
+/// \fn void MappedFile::range(
+///         size_t offset,
+///         size_t n_bytes,
+///         char** start_ptr,
+///         size_t* n_range_bytes
+///     ) const
+///
+/// \brief Helper method which widens the given byte range (clamped to the file) out to 
+///     whole pages.
+///
+/// \param offset The offset of the range [bytes].
+///
+/// \param n_bytes The length of the range [bytes].
+///
+/// \param start_ptr Pointer to the (page aligned) start of the range.
+///
+/// \param n_range_bytes Pointer to the length of the widened range (0 if empty) [bytes].
+///
+
+void MappedFile::range(size_t offset, size_t n_bytes, char** start_ptr, size_t* n_range_bytes) const
+{
+    static size_t page_size = 0;
+    
+    if (page_size == 0) {
+        #ifdef _WIN32
+            SYSTEM_INFO system_info;
+            GetSystemInfo(&system_info);
+            page_size = system_info.dwPageSize;
+        #else
+            page_size = (size_t)sysconf(_SC_PAGESIZE);
+        #endif
+    }
+    
+    size_t end = std::min(offset + n_bytes, this->n_bytes);
+    offset = std::min(offset, end);
+    
+    uintptr_t start_address = (uintptr_t)(this->data + offset) & ~(uintptr_t)(page_size - 1);
+    uintptr_t end_address = (uintptr_t)(this->data + end);
+    
+    *start_ptr = (char*)start_address;
+    *n_range_bytes = (end > offset) ? (size_t)(end_address - start_address) : 0;
+    
+    return;
+}   /* range() */
+
+// ----------------------------------------------------------------------------------------------------- //
+
+
+
+// ----------------------------------------------------------------------------------------------------- //
+
+///
+/// \fn void MappedFile::willNeed(size_t offset, size_t n_bytes) const
+///
+/// \brief Hints that the given byte range will be read soon (i.e., starts reading it in).
+///
+/// \param offset The offset of the range [bytes].
+///
+/// \param n_bytes The length of the range [bytes].
+///
+
+void MappedFile::willNeed(size_t offset, size_t n_bytes) const
+{
+    char* start_ptr = nullptr;
+    size_t n_range_bytes = 0;
+    this->range(offset, n_bytes, &start_ptr, &n_range_bytes);
+    
+    if (n_range_bytes == 0) {
+        return;
+    }
+    
+    #ifdef _WIN32
+        WIN32_MEMORY_RANGE_ENTRY range_entry;
+        range_entry.VirtualAddress = start_ptr;
+        range_entry.NumberOfBytes = n_range_bytes;
+        
+        PrefetchVirtualMemory(GetCurrentProcess(), 1, &range_entry, 0);
+    #else
+        madvise(start_ptr, n_range_bytes, MADV_WILLNEED);
+    #endif
+    
+    return;
+}   /* willNeed() */
+
+// ----------------------------------------------------------------------------------------------------- //
+
+
+
+// ----------------------------------------------------------------------------------------------------- //
+
+///
+/// \fn void MappedFile::dontNeed(size_t offset, size_t n_bytes) const
+///
+/// \brief Hints that the given byte range will not be read again soon (i.e., releases its
+///     pages; being a read only file mapping, they are simply read back in if they are).
+///
+/// \param offset The offset of the range [bytes].
+///
+/// \param n_bytes The length of the range [bytes].
+///
+
+void MappedFile::dontNeed(size_t offset, size_t n_bytes) const
+{
+    char* start_ptr = nullptr;
+    size_t n_range_bytes = 0;
+    this->range(offset, n_bytes, &start_ptr, &n_range_bytes);
+    
+    if (n_range_bytes == 0) {
+        return;
+    }
+    
+    #ifdef _WIN32
+        //  unlocking unlocked pages removes them from the working set
+        VirtualUnlock(start_ptr, n_range_bytes);
+    #else
+        madvise(start_ptr, n_range_bytes, MADV_DONTNEED);
+    #endif
+    
+    return;
+}   /* dontNeed() */
+
+// ----------------------------------------------------------------------------------------------------- //
+
+
+
+// ----------------------------------------------------------------------------------------------------- //
+
+///
+/// \fn size_t ParseNpyHeader(const MappedFile& file, std::vector<size_t>* shape_ptr)
+///
+/// \brief Parses the header of a mapped .npy file (version 1, 2, or 3), throwing unless it
+///     holds a C-ordered, little-endian float64 array of one or two dimensions, starting at 
+///     an 8-byte aligned offset.
+///
+/// \param file The mapped .npy file.
+///
+/// \param shape_ptr Pointer to the shape of the array.
+///
+/// \return The offset of the array data [bytes].
+///
+
+size_t ParseNpyHeader(const MappedFile& file, std::vector<size_t>* shape_ptr)
+{
+    const unsigned char* bytes = (const unsigned char*)(file.data);
+    
+    if (file.n_bytes < 10 || std::memcmp(bytes, "\x93NUMPY", 6) != 0) {
+        throw std::invalid_argument("ERROR: " + file.path + " is not a .npy file");
+    }
+    
+    size_t header_offset = (bytes[6] == 1) ? 10 : 12;
+    size_t n_header = (bytes[6] == 1) ?
+        (size_t)(bytes[8] | (bytes[9] << 8)) :
+        (size_t)(bytes[8] | (bytes[9] << 8) | (bytes[10] << 16) | ((size_t)bytes[11] << 24));
+    
+    if (header_offset + n_header > file.n_bytes) {
+        throw std::invalid_argument("ERROR: " + file.path + " has a truncated header");
+    }
+    
+    //  the data is read in place (as doubles), so must be aligned (as numpy.save always pads it)
+    if ((header_offset + n_header) % sizeof(double) != 0) {
+        throw std::invalid_argument("ERROR: " + file.path + " has a misaligned data offset");
+    }
+    
+    std::string header_str(file.data + header_offset, n_header);
+    
+    if (
+        header_str.find("'descr': '<f8'") == std::string::npos ||
+        header_str.find("'fortran_order': False") == std::string::npos
+    ) {
+        throw std::invalid_argument("ERROR: " + file.path + " must hold C-ordered, little-endian float64");
+    }
+    
+    size_t shape_start = header_str.find("'shape': (");
+    size_t shape_end = header_str.find(')', shape_start);
+    
+    if (shape_start == std::string::npos || shape_end == std::string::npos) {
+        throw std::invalid_argument("ERROR: " + file.path + " has no shape");
+    }
+    
+    shape_ptr->clear();
+    
+    for (const std::string& dimension_str : ParseNameList(header_str.substr(shape_start + 10, shape_end - shape_start - 10))) {
+        if (dimension_str.find_first_of("0123456789") != std::string::npos) {
+            shape_ptr->push_back(std::stoull(dimension_str));
+        }
+    }
+    
+    if (shape_ptr->empty() || shape_ptr->size() > 2) {
+        throw std::invalid_argument("ERROR: " + file.path + " must hold a 1D or 2D array");
+    }
+    
+    size_t n_elements = (*shape_ptr)[0] * (shape_ptr->size() == 2 ? (*shape_ptr)[1] : 1);
+    
+    if (header_offset + n_header + n_elements * sizeof(double) > file.n_bytes) {
+        throw std::invalid_argument("ERROR: " + file.path + " is truncated");
+    }
+    
+    return header_offset + n_header;
+}   /* ParseNpyHeader() */
+
+// ----------------------------------------------------------------------------------------------------- //
+
+
+
+// ----------------------------------------------------------------------------------------------------- //
+
+///
+/// \struct ForcingChannel
+///
+/// \brief A single channel of a ForcingStream.
+///
+
+struct ForcingChannel {
+    DObjectHandle handle;
+    int command;
+    size_t n_elements;
+    size_t n_columns;
+    std::unique_ptr<MappedFile> file;
+    size_t data_offset;
+    const double* rows_ptr;
+    std::vector<double> buffer;
+};  /* ForcingChannel */
+
+// ----------------------------------------------------------------------------------------------------- //
+
+
+
+// ----------------------------------------------------------------------------------------------------- //
+
+///
+/// \class ForcingStream
+///
+/// \brief A controller that replays memory mapped time series into a simulation (see 
+///     above). Bound to the simulation itself (its handle is the empty dobject), so it 
+///     never clears forces by way of ClearForces(); see clears_loads instead.
+///
+
+class ForcingStream : public Controller {
+    private:
+        std::unique_ptr<MappedFile> time_file;
+        size_t time_offset;
+        const double* times_ptr;
+        
+        std::vector<const std::string*> loaded_dobject_name_ptrs;
+        
+        bool has_prefetched;
+        size_t prefetch_row;
+        size_t release_row;
+        
+        void prefetch(size_t);
+        
+    public:
+        std::vector<std::unique_ptr<ForcingChannel>> channels;
+        size_t n_rows;
+        size_t cursor;
+        double time_offset_s;
+        size_t prefetch_rows;
+        bool clears_loads;
+        
+        ForcingStream(
+            const Simulation&,
+            std::string,
+            std::vector<std::tuple<DObjectHandle, int, size_t, std::string>>,
+            double,
+            size_t,
+            bool
+        );
+        
+        double startTime(void) const { return this->times_ptr[0] - this->time_offset_s; }
+        double endTime(void) const { return this->times_ptr[this->n_rows - 1] - this->time_offset_s; }
+        
+        void reset(void) override;
+        void update(double, double) override;
+        void apply(void) override;
+        void applyNow(void);
+};  /* ForcingStream */
+
+// ----------------------------------------------------------------------------------------------------- //
+
+
+
+// ----------------------------------------------------------------------------------------------------- //
+
+///
+/// \fn ForcingStream::ForcingStream(
+///         const Simulation& simulation,
+///         std::string time_path,
+///         std::vector<std::tuple<DObjectHandle, int, size_t, std::string>> channels,
+///         double time_offset_s,
+///         size_t prefetch_rows,
+///         bool clears_loads
+///     )
+///
+/// \brief Constructor for the ForcingStream class. Maps and validates all files.
+///
+/// \param simulation The target simulation.
+///
+/// \param time_path The path to the time .npy file (record time [s]).
+///
+/// \param channels The (dobject handle, command, n_elements, .npy path) channels to apply 
+///     (an n_elements of 0 denotes a scalar attribute, set from the first column).
+///
+/// \param time_offset_s The record time at simulation time zero [s].
+///
+/// \param prefetch_rows The number of rows to prefetch ahead of the cursor (and to keep
+///     behind it).
+///
+/// \param clears_loads If true, clear the forces of each loaded body before applying.
+///
+
+ForcingStream::ForcingStream(
+    const Simulation& simulation,
+    std::string time_path,
+    std::vector<std::tuple<DObjectHandle, int, size_t, std::string>> channels,
+    double time_offset_s,
+    size_t prefetch_rows,
+    bool clears_loads
+) : Controller(simulation.dobject(""), 0)
+{
+    this->clears_forces = false;
+    this->time_offset_s = time_offset_s;
+    this->prefetch_rows = std::max(prefetch_rows, (size_t)1);
+    this->clears_loads = clears_loads;
+    
+    //  1. map time
+    std::vector<size_t> shape;
+    this->time_file.reset(new MappedFile(time_path));
+    this->time_offset = ParseNpyHeader(*(this->time_file), &shape);
+    
+    if (shape.size() != 1 || shape[0] == 0) {
+        throw std::invalid_argument("ERROR: " + time_path + " must hold a non-empty 1D array");
+    }
+    
+    this->n_rows = shape[0];
+    this->times_ptr = (const double*)(this->time_file->data + this->time_offset);
+    
+    for (size_t i = 1; i < this->n_rows; i++) {
+        if (!(this->times_ptr[i] > this->times_ptr[i - 1])) {
+            throw std::invalid_argument("ERROR: " + time_path + " must be strictly increasing");
+        }
+    }
+    
+    //  2. map channels
+    for (size_t i = 0; i < channels.size(); i++) {
+        std::unique_ptr<ForcingChannel> channel(new ForcingChannel());
+        channel->handle = std::get<0>(channels[i]);
+        channel->command = std::get<1>(channels[i]);
+        channel->n_elements = std::get<2>(channels[i]);
+        
+        if (channel->handle.unique_simulation_label_ptr != simulation.unique_simulation_label_ptr) {
+            throw std::invalid_argument("ERROR: channel dobject belongs to another simulation");
+        }
+        
+        channel->file.reset(new MappedFile(std::get<3>(channels[i])));
+        channel->data_offset = ParseNpyHeader(*(channel->file), &shape);
+        channel->n_columns = (shape.size() == 2) ? shape[1] : 1;
+        
+        if (shape[0] != this->n_rows || channel->n_columns < std::max(channel->n_elements, (size_t)1)) {
+            std::string error_str = "ERROR: " + channel->file->path + " must have " + std::to_string(this->n_rows);
+            error_str += " rows and at least " + std::to_string(std::max(channel->n_elements, (size_t)1));
+            error_str += " columns";
+            
+            throw std::invalid_argument(error_str);
+        }
+        
+        channel->rows_ptr = (const double*)(channel->file->data + channel->data_offset);
+        channel->buffer.resize(std::max(channel->n_elements, (size_t)1), 0);
+        
+        switch (channel->command) {
+            case (PDSAPI::PDSAPI::rigidBodyForceAndDerivGlobal):
+            case (PDSAPI::PDSAPI::rigidBodyForceAndDerivBody):
+            case (PDSAPI::PDSAPI::rigidBodyMomentAndDerivGlobal):
+            case (PDSAPI::PDSAPI::rigidBodyMomentAndDerivBody): {
+                const std::string* dobject_name_ptr = channel->handle.dobject_name_ptr;
+                
+                if (
+                    std::find(
+                        this->loaded_dobject_name_ptrs.begin(),
+                        this->loaded_dobject_name_ptrs.end(),
+                        dobject_name_ptr
+                    ) == this->loaded_dobject_name_ptrs.end()
+                ) {
+                    this->loaded_dobject_name_ptrs.push_back(dobject_name_ptr);
+                }
+                
+                break;
+            }
+            
+            default: {
+                break;
+            }
+        }
+        
+        this->channels.push_back(std::move(channel));
+    }
+    
+    this->reset();
+    
+    return;
+}   /* ForcingStream() */
+
+// ----------------------------------------------------------------------------------------------------- //
+
+
+
+// ----------------------------------------------------------------------------------------------------- //
+
+///
+/// \fn void ForcingStream::prefetch(size_t row)
+///
+/// \brief Helper method which, once the cursor has left the last prefetched window 
+///     (forward by a window, or back at all), prefetches the next two windows of every 
+///     file, and releases everything more than a window behind the cursor.
+///
+/// \param row The current row.
+///
+
+void ForcingStream::prefetch(size_t row)
+{
+    if (
+        this->has_prefetched &&
+        row >= this->prefetch_row &&
+        row < this->prefetch_row + this->prefetch_rows
+    ) {
+        return;
+    }
+    
+    size_t release_end = (row > this->prefetch_rows) ? row - this->prefetch_rows : 0;
+    this->release_row = std::min(this->release_row, release_end);     // in case of a jump back
+    
+    auto advise = [&](const MappedFile& file, size_t data_offset, size_t row_bytes) {
+        file.willNeed(data_offset + row * row_bytes, 2 * this->prefetch_rows * row_bytes);
+        
+        if (release_end > this->release_row) {
+            //  (the header page, shared with row 0, is simply read back in if needed)
+            file.dontNeed(
+                data_offset + this->release_row * row_bytes,
+                (release_end - this->release_row) * row_bytes
+            );
+        }
+    };
+    
+    advise(*(this->time_file), this->time_offset, sizeof(double));
+    
+    for (std::unique_ptr<ForcingChannel>& channel : this->channels) {
+        advise(*(channel->file), channel->data_offset, channel->n_columns * sizeof(double));
+    }
+    
+    this->has_prefetched = true;
+    this->prefetch_row = row;
+    this->release_row = release_end;
+    
+    return;
+}   /* prefetch() */
+
+// ----------------------------------------------------------------------------------------------------- //
+
+
+
+// ----------------------------------------------------------------------------------------------------- //
+
+///
+/// \fn void ForcingStream::reset(void)
+///
+/// \brief Rewinds the cursor to the start of the record.
+///
+
+void ForcingStream::reset(void)
+{
+    this->cursor = 0;
+    this->has_prefetched = false;
+    this->prefetch_row = 0;
+    this->release_row = 0;
+    
+    this->prefetch(0);
+    
+    return;
+}   /* reset() */
+
+// ----------------------------------------------------------------------------------------------------- //
+
+
+
+// ----------------------------------------------------------------------------------------------------- //
+
+///
+/// \fn void ForcingStream::update(double time_s, double dt_s)
+///
+/// \brief Interpolates every channel at the given simulation time (moving the cursor 
+///     forward, or searching if time has gone back, e.g., after a Restore).
+///
+/// \param time_s The current simulation time [s].
+///
+/// \param dt_s The time step [s] (unused).
+///
+
+void ForcingStream::update(double time_s, double /* dt_s */)
+{
+    double record_time_s = time_s + this->time_offset_s;
+    
+    //  1. locate row (times_ptr[cursor] <= record time < times_ptr[cursor + 1], clamped)
+    if (record_time_s < this->times_ptr[this->cursor]) {
+        this->cursor = std::upper_bound(
+            this->times_ptr,
+            this->times_ptr + this->n_rows,
+            record_time_s
+        ) - this->times_ptr;
+        
+        this->cursor = (this->cursor > 0) ? this->cursor - 1 : 0;
+    }
+    
+    while (this->cursor + 1 < this->n_rows && this->times_ptr[this->cursor + 1] <= record_time_s) {
+        this->cursor++;
+    }
+    
+    this->prefetch(this->cursor);
+    
+    //  2. interpolate
+    size_t row = this->cursor;
+    size_t next_row = std::min(row + 1, this->n_rows - 1);
+    double weight = 0;
+    
+    if (next_row > row && record_time_s > this->times_ptr[row]) {
+        weight = std::min(
+            (record_time_s - this->times_ptr[row]) / (this->times_ptr[next_row] - this->times_ptr[row]),
+            1.0
+        );
+    }
+    
+    for (std::unique_ptr<ForcingChannel>& channel : this->channels) {
+        const double* row_ptr = channel->rows_ptr + row * channel->n_columns;
+        const double* next_row_ptr = channel->rows_ptr + next_row * channel->n_columns;
+        
+        for (size_t i = 0; i < channel->buffer.size(); i++) {
+            channel->buffer[i] = row_ptr[i] + weight * (next_row_ptr[i] - row_ptr[i]);
+        }
+    }
+    
+    return;
+}   /* update() */
+
+// ----------------------------------------------------------------------------------------------------- //
+
+
+
+// ----------------------------------------------------------------------------------------------------- //
+
+///
+/// \fn void ForcingStream::apply(void)
+///
+/// \brief Applies the (held) interpolated values, first clearing the forces of each loaded
+///     body (if clears_loads).
+///
+
+void ForcingStream::apply(void)
+{
+    const std::string& unique_simulation_label = this->handle.label();
+    
+    if (this->clears_loads) {
+        for (const std::string* dobject_name_ptr : this->loaded_dobject_name_ptrs) {
+            PDSAPI_TIMED(ProteusDSAPI::SetInt(
+                unique_simulation_label,
+                PDSAPI::PDSAPI::rigidBodyClearForcesMoments,
+                *dobject_name_ptr,
+                1
+            ));
+        }
+    }
+    
+    for (std::unique_ptr<ForcingChannel>& channel : this->channels) {
+        if (channel->n_elements == 0) {
+            PDSAPI_TIMED(ProteusDSAPI::SetDouble(
+                unique_simulation_label,
+                channel->command,
+                channel->handle.name(),
+                channel->buffer[0]
+            ));
+        }
+        
+        else {
+            PDSAPI_TIMED(ProteusDSAPI::SetDoubleArray(
+                unique_simulation_label,
+                channel->command,
+                channel->handle.name(),
+                channel->buffer
+            ));
+        }
+        
+        NoteMetadataSet(unique_simulation_label, channel->command);
+    }
+    
+    return;
+}   /* apply() */
+
+// ----------------------------------------------------------------------------------------------------- //
+
+
+
+// ----------------------------------------------------------------------------------------------------- //
+
+///
+/// \fn void ForcingStream::applyNow(void)
+///
+/// \brief Updates at the current simulation time and applies (for use outside of RunLoop,
+///     e.g., before each AdvanceTime in a Python loop).
+///
+
+void ForcingStream::applyNow(void)
+{
+    SimulationGuard simulation_guard(this->handle.label());
+    
+    double time_s = 0;
+    PDSAPI_TIMED(ProteusDSAPI::GetDouble(this->handle.label(), PDSAPI::PDSAPI::time, "", time_s));
+    
+    this->update(time_s, 0);
+    this->apply();
+    
+    return;
+}   /* applyNow() */
+
+// ----------------------------------------------------------------------------------------------------- //
+
+#endif  /* PDSAPI_BINDINGS_HAS_SHM */
+
+// ==== END Forcing streams ============================================================================ //
+
+
+
+// ==== Joint force banks ============================================================================== //
+
+/*
+ *  A JointForceBank applies one force law across many joints (e.g., dozens of PTOs) in a single
+ *  controller: it reads each joint's state, gathers the driving variable x (by default, the joint
+ *  velocity, state index 0) into a contiguous (structure of arrays) buffer, evaluates F(x) and
+ *  dF/dx for the whole batch in one kernel, and writes each [F, dF/dt] pair back, where dF/dt is
+ *  estimated as dF/dx * dx/dt (dx/dt by finite difference over the last update; zero on the 
+ *  first). The laws (all with per-joint parameters) are
+ *
+ *      linear          F = -c * x
+ *      quadratic       F = -c * x * |x|
+ *      Coulomb         F = -F_c * sign(x) - c * x, with F_c ramped linearly over |x| < deadband
+ *      lookup          F = table(x), linearly interpolated and clamped (one table per bank)
+ *
+ *  Each law is a specialization of EvaluateJointForceLaw<>(). Where SSE2 is available (always, on
+ *  x64), the linear, quadratic, and Coulomb kernels process two joints per instruction, and the 
+ *  remaining loops are written so as to auto-vectorize; the lookup kernel is scalar (a gather).
  */
 
 // ----------------------------------------------------------------------------------------------------- //
 
 ///
-/// \fn std::vector<double> GetDoubleArray(
-///         std::string unique_simulation_label,
-///         int command,
-///         std::string dobject_name,
-///         size_t n_elements
+/// \enum JointForceLaw
+///
+/// \brief The force laws of a JointForceBank.
+///
+
+enum JointForceLaw {
+    JOINT_FORCE_LINEAR,
+    JOINT_FORCE_QUADRATIC,
+    JOINT_FORCE_COULOMB,
+    JOINT_FORCE_LOOKUP
+};  /* JointForceLaw */
+
+// ----------------------------------------------------------------------------------------------------- //
+
+
+
+// ----------------------------------------------------------------------------------------------------- //
+
+///
+/// \struct JointForceParameters
+///
+/// \brief The (structure of arrays) parameters of a JointForceBank: per-joint damping
+///     coefficients, Coulomb forces, and deadbands, plus a single lookup table.
+///
+
+struct JointForceParameters {
+    std::vector<double> coefficients;
+    std::vector<double> coulomb_forces;
+    std::vector<double> deadbands;
+    std::vector<double> x_table;
+    std::vector<double> force_table;
+};  /* JointForceParameters */
+
+// ----------------------------------------------------------------------------------------------------- //
+
+
+
+// ----------------------------------------------------------------------------------------------------- //
+
+///
+/// \fn template <int law>
+///     void EvaluateJointForceLaw(
+///         const JointForceParameters& parameters,
+///         size_t n_joints,
+///         const double* x_ptr,
+///         double* force_ptr,
+///         double* dforce_dx_ptr
 ///     )
 ///
-/// \brief Wrapper on ProteusDSAPI::GetDoubleArray that creates and returns the desired
-///     std::vector<double>.
+/// \brief Evaluates F(x) and dF/dx for a batch of joints, under the given law (see the 
+///     specializations below).
 ///
-/// \param unique_simulation_label The API label for the target simulation.
+/// \param parameters The law parameters (per-joint vectors of at least n_joints).
 ///
-/// \param command Defines the attribute of interest (resolved by the PDSAPI::PDSAPI 
-///     enumeration).
+/// \param n_joints The number of joints.
 ///
-/// \param dobject_name Defines the dobject of interest.
+/// \param x_ptr Pointer to the driving variable of each joint.
 ///
-/// \param n_elements Defines the size of the std::vector<double> to be returned.
+/// \param force_ptr Pointer to the force of each joint (output).
 ///
-/// \return The desired std::vector<double>.
+/// \param dforce_dx_ptr Pointer to dF/dx of each joint (output).
 ///
 
-std::vector<double> GetDoubleArray(
-    std::string unique_simulation_label,
-    int command,
-    std::string dobject_name,
-    size_t n_elements
+template <int law>
+void EvaluateJointForceLaw(
+    const JointForceParameters& parameters,
+    size_t n_joints,
+    const double* x_ptr,
+    double* force_ptr,
+    double* dforce_dx_ptr
+);
+
+
+template <>
+void EvaluateJointForceLaw<JOINT_FORCE_LINEAR>(
+    const JointForceParameters& parameters,
+    size_t n_joints,
+    const double* x_ptr,
+    double* force_ptr,
+    double* dforce_dx_ptr
+)
+{
+    const double* c_ptr = parameters.coefficients.data();
+    size_t i = 0;
+    
+    #ifdef PDSAPI_BINDINGS_HAS_SSE2
+        const __m128d sign_mask = _mm_set1_pd(-0.0);
+        
+        for (; i + 2 <= n_joints; i += 2) {
+            __m128d minus_c = _mm_xor_pd(sign_mask, _mm_loadu_pd(c_ptr + i));
+            
+            _mm_storeu_pd(force_ptr + i, _mm_mul_pd(minus_c, _mm_loadu_pd(x_ptr + i)));
+            _mm_storeu_pd(dforce_dx_ptr + i, minus_c);
+        }
+    #endif
+    
+    for (; i < n_joints; i++) {
+        force_ptr[i] = -1 * c_ptr[i] * x_ptr[i];
+        dforce_dx_ptr[i] = -1 * c_ptr[i];
+    }
+    
+    return;
+}   /* EvaluateJointForceLaw<JOINT_FORCE_LINEAR>() */
+
+
+template <>
+void EvaluateJointForceLaw<JOINT_FORCE_QUADRATIC>(
+    const JointForceParameters& parameters,
+    size_t n_joints,
+    const double* x_ptr,
+    double* force_ptr,
+    double* dforce_dx_ptr
+)
+{
+    const double* c_ptr = parameters.coefficients.data();
+    size_t i = 0;
+    
+    #ifdef PDSAPI_BINDINGS_HAS_SSE2
+        const __m128d sign_mask = _mm_set1_pd(-0.0);
+        const __m128d minus_two = _mm_set1_pd(-2.0);
+        
+        for (; i + 2 <= n_joints; i += 2) {
+            __m128d c = _mm_loadu_pd(c_ptr + i);
+            __m128d x = _mm_loadu_pd(x_ptr + i);
+            __m128d abs_x = _mm_andnot_pd(sign_mask, x);
+            __m128d c_abs_x = _mm_mul_pd(c, abs_x);
+            
+            _mm_storeu_pd(force_ptr + i, _mm_xor_pd(sign_mask, _mm_mul_pd(c_abs_x, x)));
+            _mm_storeu_pd(dforce_dx_ptr + i, _mm_mul_pd(minus_two, c_abs_x));
+        }
+    #endif
+    
+    for (; i < n_joints; i++) {
+        double c_abs_x = c_ptr[i] * fabs(x_ptr[i]);
+        
+        force_ptr[i] = -1 * (c_abs_x * x_ptr[i]);
+        dforce_dx_ptr[i] = -2 * c_abs_x;
+    }
+    
+    return;
+}   /* EvaluateJointForceLaw<JOINT_FORCE_QUADRATIC>() */
+
+
+template <>
+void EvaluateJointForceLaw<JOINT_FORCE_COULOMB>(
+    const JointForceParameters& parameters,
+    size_t n_joints,
+    const double* x_ptr,
+    double* force_ptr,
+    double* dforce_dx_ptr
+)
+{
+    const double* c_ptr = parameters.coefficients.data();
+    const double* coulomb_ptr = parameters.coulomb_forces.data();
+    const double* deadband_ptr = parameters.deadbands.data();
+    size_t i = 0;
+    
+    #ifdef PDSAPI_BINDINGS_HAS_SSE2
+        const __m128d zero = _mm_setzero_pd();
+        const __m128d one = _mm_set1_pd(1.0);
+        const __m128d sign_mask = _mm_set1_pd(-0.0);
+        
+        for (; i + 2 <= n_joints; i += 2) {
+            __m128d c = _mm_loadu_pd(c_ptr + i);
+            __m128d coulomb = _mm_loadu_pd(coulomb_ptr + i);
+            __m128d deadband = _mm_loadu_pd(deadband_ptr + i);
+            __m128d x = _mm_loadu_pd(x_ptr + i);
+            
+            //  inside the deadband: F_c * x / deadband (masked out, NaN or not, if outside)
+            __m128d is_inside = _mm_cmplt_pd(_mm_andnot_pd(sign_mask, x), deadband);
+            __m128d slope = _mm_div_pd(coulomb, deadband);
+            __m128d inside_force = _mm_and_pd(is_inside, _mm_mul_pd(slope, x));
+            __m128d inside_slope = _mm_and_pd(is_inside, slope);
+            
+            //  outside: F_c * sign(x)
+            __m128d sign = _mm_sub_pd(
+                _mm_and_pd(_mm_cmpgt_pd(x, zero), one),
+                _mm_and_pd(_mm_cmplt_pd(x, zero), one)
+            );
+            __m128d outside_force = _mm_andnot_pd(is_inside, _mm_mul_pd(coulomb, sign));
+            
+            __m128d friction = _mm_or_pd(inside_force, outside_force);
+            
+            _mm_storeu_pd(force_ptr + i, _mm_xor_pd(sign_mask, _mm_add_pd(friction, _mm_mul_pd(c, x))));
+            _mm_storeu_pd(dforce_dx_ptr + i, _mm_xor_pd(sign_mask, _mm_add_pd(inside_slope, c)));
+        }
+    #endif
+    
+    for (; i < n_joints; i++) {
+        double x = x_ptr[i];
+        
+        if (fabs(x) < deadband_ptr[i]) {
+            double slope = coulomb_ptr[i] / deadband_ptr[i];
+            
+            force_ptr[i] = -1 * (slope * x + c_ptr[i] * x);
+            dforce_dx_ptr[i] = -1 * (slope + c_ptr[i]);
+        }
+        
+        else {
+            double sign = (x > 0) ? 1 : ((x < 0) ? -1 : 0);
+            
+            force_ptr[i] = -1 * (coulomb_ptr[i] * sign + c_ptr[i] * x);
+            dforce_dx_ptr[i] = -1 * c_ptr[i];
+        }
+    }
+    
+    return;
+}   /* EvaluateJointForceLaw<JOINT_FORCE_COULOMB>() */
+
+
+template <>
+void EvaluateJointForceLaw<JOINT_FORCE_LOOKUP>(
+    const JointForceParameters& parameters,
+    size_t n_joints,
+    const double* x_ptr,
+    double* force_ptr,
+    double* dforce_dx_ptr
 )
 {
-    std::vector<double> return_vector(n_elements, 0);
-    ProteusDSAPI::GetDoubleArray(unique_simulation_label, command, dobject_name, return_vector);
+    const std::vector<double>& x_table = parameters.x_table;
+    const std::vector<double>& force_table = parameters.force_table;
     
-    return return_vector;
-}   /* GetDoubleArray() */
+    for (size_t i = 0; i < n_joints; i++) {
+        double x = x_ptr[i];
+        
+        //  NaN x (e.g., from a diverging simulation) falls into the lower clamp
+        if (!(x > x_table.front())) {
+            force_ptr[i] = force_table.front();
+            dforce_dx_ptr[i] = 0;
+        }
+        
+        else if (x >= x_table.back()) {
+            force_ptr[i] = force_table.back();
+            dforce_dx_ptr[i] = 0;
+        }
+        
+        else {
+            size_t j = std::upper_bound(x_table.begin(), x_table.end(), x) - x_table.begin();
+            j = std::min(std::max(j, (size_t)1), x_table.size() - 1);
+            
+            double slope = (force_table[j] - force_table[j - 1]) / (x_table[j] - x_table[j - 1]);
+            
+            force_ptr[i] = force_table[j - 1] + slope * (x - x_table[j - 1]);
+            dforce_dx_ptr[i] = slope;
+        }
+    }
+    
+    return;
+}   /* EvaluateJointForceLaw<JOINT_FORCE_LOOKUP>() */
 
 // ----------------------------------------------------------------------------------------------------- //
 
@@ -120,36 +8882,67 @@ std::vector<double> GetDoubleArray(
 // ----------------------------------------------------------------------------------------------------- //
 
 ///
-/// \fn double GetDouble(
-///         std::string unique_simulation_label,
-///         int command,
-///         std::string dobject_name
+/// \fn void EvaluateJointForces(
+///         int law,
+///         const JointForceParameters& parameters,
+///         size_t n_joints,
+///         const double* x_ptr,
+///         double* force_ptr,
+///         double* dforce_dx_ptr
 ///     )
 ///
-/// \brief Wrapper on ProteusDSAPI::GetDouble that creates and returns the desired
-///     double.
+/// \brief Dispatches to the kernel of the given law.
 ///
-/// \param unique_simulation_label The API label for the target simulation.
+/// \param law The force law (resolved by the JointForceLaw enumeration).
 ///
-/// \param command Defines the attribute of interest (resolved by the PDSAPI::PDSAPI 
-///     enumeration).
+/// \param parameters The law parameters.
 ///
-/// \param dobject_name Defines the dobject of interest.
+/// \param n_joints The number of joints.
 ///
-/// \return The desired double.
+/// \param x_ptr Pointer to the driving variable of each joint.
+///
+/// \param force_ptr Pointer to the force of each joint (output).
+///
+/// \param dforce_dx_ptr Pointer to dF/dx of each joint (output).
 ///
 
-double GetDouble(
-    std::string unique_simulation_label,
-    int command,
-    std::string dobject_name
+void EvaluateJointForces(
+    int law,
+    const JointForceParameters& parameters,
+    size_t n_joints,
+    const double* x_ptr,
+    double* force_ptr,
+    double* dforce_dx_ptr
 )
 {
-    double return_double = 0;
-    ProteusDSAPI::GetDouble(unique_simulation_label, command, dobject_name, return_double);
+    switch (law) {
+        case (JOINT_FORCE_LINEAR): {
+            EvaluateJointForceLaw<JOINT_FORCE_LINEAR>(parameters, n_joints, x_ptr, force_ptr, dforce_dx_ptr);
+            break;
+        }
+        
+        case (JOINT_FORCE_QUADRATIC): {
+            EvaluateJointForceLaw<JOINT_FORCE_QUADRATIC>(parameters, n_joints, x_ptr, force_ptr, dforce_dx_ptr);
+            break;
+        }
+        
+        case (JOINT_FORCE_COULOMB): {
+            EvaluateJointForceLaw<JOINT_FORCE_COULOMB>(parameters, n_joints, x_ptr, force_ptr, dforce_dx_ptr);
+            break;
+        }
+        
+        case (JOINT_FORCE_LOOKUP): {
+            EvaluateJointForceLaw<JOINT_FORCE_LOOKUP>(parameters, n_joints, x_ptr, force_ptr, dforce_dx_ptr);
+            break;
+        }
+        
+        default: {
+            throw std::invalid_argument("ERROR: unknown joint force law " + std::to_string(law));
+        }
+    }
     
-    return return_double;
-}   /* GetDouble() */
+    return;
+}   /* EvaluateJointForces() */
 
 // ----------------------------------------------------------------------------------------------------- //
 
@@ -158,40 +8951,220 @@ double GetDouble(
 // ----------------------------------------------------------------------------------------------------- //
 
 ///
-/// \fn std::vector<double> GetIntArray(
-///         std::string unique_simulation_label,
-///         int command,
-///         std::string dobject_name,
-///         size_t n_elements
+/// \class JointForceBank
+///
+/// \brief A controller that applies one force law across many joints (see above). Bound to
+///     the simulation itself (its handle is the empty dobject), so it never clears forces 
+///     by way of ClearForces(); see clears_joint_forces instead.
+///
+
+class JointForceBank : public Controller {
+    private:
+        std::vector<double> state_buffer;
+        std::vector<double> output_buffer;
+        bool has_previous;
+        
+    public:
+        int law;
+        size_t state_index;
+        bool clears_joint_forces;
+        
+        std::vector<DObjectHandle> joints;
+        JointForceParameters parameters;
+        
+        std::vector<double> x;
+        std::vector<double> x_previous;
+        std::vector<double> force;
+        std::vector<double> dforce_dx;
+        std::vector<double> dforce_dt;
+        
+        JointForceBank(
+            const Simulation&,
+            std::vector<std::string>,
+            int,
+            std::vector<double>,
+            std::vector<double>,
+            std::vector<double>,
+            std::vector<double>,
+            std::vector<double>,
+            size_t,
+            int,
+            bool
+        );
+        
+        void reset(void) override;
+        void update(double, double) override;
+        void apply(void) override;
+        void applyNow(double);
+        
+        pybind11::tuple evaluate(pybind11::array_t<double, pybind11::array::c_style>) const;
+};  /* JointForceBank */
+
+// ----------------------------------------------------------------------------------------------------- //
+
+
+
+// ----------------------------------------------------------------------------------------------------- //
+
+///
+/// \fn JointForceBank::JointForceBank(
+///         const Simulation& simulation,
+///         std::vector<std::string> joint_names,
+///         int law,
+///         std::vector<double> coefficients,
+///         std::vector<double> coulomb_forces,
+///         std::vector<double> deadbands,
+///         std::vector<double> x_table,
+///         std::vector<double> force_table,
+///         size_t state_index,
+///         int output_command,
+///         bool clears_joint_forces
 ///     )
 ///
-/// \brief Wrapper on ProteusDSAPI::GetIntArray that creates and returns the desired
-///     std::vector<int>.
+/// \brief Constructor for the JointForceBank class. Per-joint parameters may be given 
+///     once per joint, or once (for all joints); those a law does not use may be empty.
 ///
-/// \param unique_simulation_label The API label for the target simulation.
+/// \param simulation The target simulation.
 ///
-/// \param command Defines the attribute of interest (resolved by the PDSAPI::PDSAPI 
-///     enumeration).
+/// \param joint_names The names of the joint dobjects.
 ///
-/// \param dobject_name Defines the dobject of interest.
+/// \param law The force law (resolved by the JointForceLaw enumeration).
 ///
-/// \param n_elements Defines the size of the std::vector<int> to be returned.
+/// \param coefficients The damping coefficients (linear, quadratic, and Coulomb laws).
 ///
-/// \return The desired std::vector<int>.
+/// \param coulomb_forces The Coulomb forces (Coulomb law).
+///
+/// \param deadbands The deadbands, over which the Coulomb force ramps up (Coulomb law).
+///
+/// \param x_table The (increasing) x values of the table (lookup law).
+///
+/// \param force_table The force values of the table (lookup law).
+///
+/// \param state_index The state index of the driving variable x.
+///
+/// \param output_command The command to write [F, dF/dt] to.
+///
+/// \param clears_joint_forces If true, clear each joint's forces before applying.
 ///
 
-std::vector<int> GetIntArray(
-    std::string unique_simulation_label,
-    int command,
-    std::string dobject_name,
-    size_t n_elements
-)
+JointForceBank::JointForceBank(
+    const Simulation& simulation,
+    std::vector<std::string> joint_names,
+    int law,
+    std::vector<double> coefficients,
+    std::vector<double> coulomb_forces,
+    std::vector<double> deadbands,
+    std::vector<double> x_table,
+    std::vector<double> force_table,
+    size_t state_index,
+    int output_command,
+    bool clears_joint_forces
+) : Controller(simulation.dobject(""), 0)
 {
-    std::vector<int> return_vector(n_elements, 0);
-    ProteusDSAPI::GetIntArray(unique_simulation_label, command, dobject_name, return_vector);
+    if (joint_names.empty()) {
+        throw std::invalid_argument("ERROR: joint force bank requires at least one joint");
+    }
     
-    return return_vector;
-}   /* GetIntArray() */
+    this->clears_forces = false;
+    this->output_command = output_command;
+    this->law = law;
+    this->state_index = state_index;
+    this->clears_joint_forces = clears_joint_forces;
+    
+    for (const std::string& joint_name : joint_names) {
+        this->joints.push_back(simulation.dobject(joint_name));
+    }
+    
+    size_t n_joints = this->joints.size();
+    
+    //  1. broadcast (and check) per-joint parameters
+    auto per_joint = [n_joints](std::vector<double> values, const char* name, bool is_used) {
+        if (!is_used) {
+            values.resize(n_joints, 0);
+        }
+        
+        else if (values.size() == 1) {
+            values.resize(n_joints, values[0]);
+        }
+        
+        else if (values.size() != n_joints) {
+            std::string error_str = "ERROR: expected 1 or " + std::to_string(n_joints) + " ";
+            error_str += name + std::string(", got ") + std::to_string(values.size());
+            
+            throw std::invalid_argument(error_str);
+        }
+        
+        return values;
+    };
+    
+    bool is_coulomb = (law == JOINT_FORCE_COULOMB);
+    
+    this->parameters.coefficients = per_joint(
+        (is_coulomb && coefficients.empty()) ? std::vector<double>(1, 0) : coefficients,
+        "coefficients",
+        law != JOINT_FORCE_LOOKUP
+    );
+    this->parameters.coulomb_forces = per_joint(coulomb_forces, "coulomb_forces", is_coulomb);
+    this->parameters.deadbands = per_joint(
+        (is_coulomb && deadbands.empty()) ? std::vector<double>(1, 0) : deadbands,
+        "deadbands",
+        is_coulomb
+    );
+    
+    if (law == JOINT_FORCE_LOOKUP) {
+        if (x_table.empty() || x_table.size() != force_table.size()) {
+            throw std::invalid_argument("ERROR: lookup tables must be non-empty and of equal size");
+        }
+        
+        if (!std::is_sorted(x_table.begin(), x_table.end())) {
+            throw std::invalid_argument("ERROR: lookup table x values must be increasing");
+        }
+        
+        this->parameters.x_table = x_table;
+        this->parameters.force_table = force_table;
+    }
+    
+    else if (law < JOINT_FORCE_LINEAR || law > JOINT_FORCE_LOOKUP) {
+        throw std::invalid_argument("ERROR: unknown joint force law " + std::to_string(law));
+    }
+    
+    //  2. size state and (structure of arrays) buffers
+    for (const DObjectHandle& joint : this->joints) {
+        int state_size = GetMetadata<int>(
+            FN_GET_INT,
+            joint.label(),
+            PDSAPI::PDSAPI::stateSize,
+            joint.name(),
+            0,
+            [&]() {
+                int n_state = 0;
+                PDSAPI_TIMED(ProteusDSAPI::GetInt(joint.label(), PDSAPI::PDSAPI::stateSize, joint.name(), n_state));
+                
+                return n_state;
+            }
+        );
+        
+        if (state_index >= (size_t)std::max(state_size, 2)) {
+            std::string error_str = "ERROR: state index " + std::to_string(state_index);
+            error_str += " is out of range for dobject " + joint.name();
+            
+            throw std::invalid_argument(error_str);
+        }
+        
+        this->state_buffer.resize(std::max(this->state_buffer.size(), (size_t)std::max(state_size, 2)), 0);
+    }
+    
+    this->output_buffer.resize(2, 0);
+    
+    this->x.resize(n_joints, 0);
+    this->x_previous.resize(n_joints, 0);
+    this->force.resize(n_joints, 0);
+    this->dforce_dx.resize(n_joints, 0);
+    this->dforce_dt.resize(n_joints, 0);
+    this->has_previous = false;
+    
+    return;
+}   /* JointForceBank() */
 
 // ----------------------------------------------------------------------------------------------------- //
 
@@ -200,36 +9173,78 @@ std::vector<int> GetIntArray(
 // ----------------------------------------------------------------------------------------------------- //
 
 ///
-/// \fn double GetInt(
-///         std::string unique_simulation_label,
-///         int command,
-///         std::string dobject_name
-///     )
+/// \fn void JointForceBank::reset(void)
 ///
-/// \brief Wrapper on ProteusDSAPI::GetInt that creates and returns the desired
-///     int.
+/// \brief Forgets the previous x (so the next dF/dt estimate is zero).
 ///
-/// \param unique_simulation_label The API label for the target simulation.
+
+void JointForceBank::reset(void)
+{
+    this->has_previous = false;
+    
+    return;
+}   /* reset() */
+
+// ----------------------------------------------------------------------------------------------------- //
+
+
+
+// ----------------------------------------------------------------------------------------------------- //
+
 ///
-/// \param command Defines the attribute of interest (resolved by the PDSAPI::PDSAPI 
-///     enumeration).
+/// \fn void JointForceBank::update(double time_s, double dt_s)
 ///
-/// \param dobject_name Defines the dobject of interest.
+/// \brief Reads every joint's state, gathers x, evaluates the law for the whole batch, and
+///     estimates dF/dt = dF/dx * (x - x_previous) / dt.
 ///
-/// \return The desired int.
+/// \param time_s The current simulation time [s] (unused).
+///
+/// \param dt_s The time since the last update [s].
 ///
 
-double GetInt(
-    std::string unique_simulation_label,
-    int command,
-    std::string dobject_name
-)
+void JointForceBank::update(double /* time_s */, double dt_s)
 {
-    int return_int = 0;
-    ProteusDSAPI::GetInt(unique_simulation_label, command, dobject_name, return_int);
+    size_t n_joints = this->joints.size();
     
-    return return_int;
-}   /* GetInt() */
+    //  1. gather
+    for (size_t i = 0; i < n_joints; i++) {
+        PDSAPI_TIMED(ProteusDSAPI::GetDoubleArray(
+            this->joints[i].label(),
+            PDSAPI::PDSAPI::state,
+            this->joints[i].name(),
+            this->state_buffer
+        ));
+        
+        this->x[i] = this->state_buffer[this->state_index];
+    }
+    
+    //  2. evaluate
+    EvaluateJointForces(
+        this->law,
+        this->parameters,
+        n_joints,
+        this->x.data(),
+        this->force.data(),
+        this->dforce_dx.data()
+    );
+    
+    //  3. estimate dF/dt
+    double inverse_dt = (this->has_previous && dt_s > 0) ? 1 / dt_s : 0;
+    
+    const double* x_ptr = this->x.data();
+    const double* dforce_dx_ptr = this->dforce_dx.data();
+    double* x_previous_ptr = this->x_previous.data();
+    double* dforce_dt_ptr = this->dforce_dt.data();
+    
+    for (size_t i = 0; i < n_joints; i++) {
+        dforce_dt_ptr[i] = dforce_dx_ptr[i] * (x_ptr[i] - x_previous_ptr[i]) * inverse_dt;
+        x_previous_ptr[i] = x_ptr[i];
+    }
+    
+    this->has_previous = true;
+    
+    return;
+}   /* update() */
 
 // ----------------------------------------------------------------------------------------------------- //
 
@@ -238,36 +9253,64 @@ double GetInt(
 // ----------------------------------------------------------------------------------------------------- //
 
 ///
-/// \fn double GetString(
-///         std::string unique_simulation_label,
-///         int command,
-///         std::string dobject_name
-///     )
+/// \fn void JointForceBank::apply(void)
 ///
-/// \brief Wrapper on ProteusDSAPI::GetString that creates and returns the desired
-///     std::string.
+/// \brief Writes each joint's (held) [F, dF/dt] pair, first clearing its forces (if 
+///     clears_joint_forces).
 ///
-/// \param unique_simulation_label The API label for the target simulation.
+
+void JointForceBank::apply(void)
+{
+    for (size_t i = 0; i < this->joints.size(); i++) {
+        const DObjectHandle& joint = this->joints[i];
+        
+        if (this->clears_joint_forces) {
+            PDSAPI_TIMED(ProteusDSAPI::SetInt(
+                joint.label(),
+                PDSAPI::PDSAPI::rigidBodyClearForcesMoments,
+                joint.name(),
+                1
+            ));
+        }
+        
+        this->output_buffer[0] = this->force[i];
+        this->output_buffer[1] = this->dforce_dt[i];
+        
+        PDSAPI_TIMED(ProteusDSAPI::SetDoubleArray(
+            joint.label(),
+            this->output_command,
+            joint.name(),
+            this->output_buffer
+        ));
+    }
+    
+    return;
+}   /* apply() */
+
+// ----------------------------------------------------------------------------------------------------- //
+
+
+
+// ----------------------------------------------------------------------------------------------------- //
+
 ///
-/// \param command Defines the attribute of interest (resolved by the PDSAPI::PDSAPI 
-///     enumeration).
+/// \fn void JointForceBank::applyNow(double dt_s)
 ///
-/// \param dobject_name Defines the dobject of interest.
+/// \brief Updates and applies (for use outside of RunLoop, e.g., before each AdvanceTime 
+///     in a Python loop), in one call.
 ///
-/// \return The desired std::string.
+/// \param dt_s The time since the last update [s].
 ///
 
-std::string GetString(
-    std::string unique_simulation_label,
-    int command,
-    std::string dobject_name
-) 
+void JointForceBank::applyNow(double dt_s)
 {
-    std::string return_string = "";
-    ProteusDSAPI::GetString(unique_simulation_label, command, dobject_name, return_string);
+    SimulationGuard simulation_guard(this->handle.label());
     
-    return return_string;
-}   /* GetString() */
+    this->update(0, dt_s);
+    this->apply();
+    
+    return;
+}   /* applyNow() */
 
 // ----------------------------------------------------------------------------------------------------- //
 
@@ -276,27 +9319,42 @@ std::string GetString(
 // ----------------------------------------------------------------------------------------------------- //
 
 ///
-/// \fn std::string GetErrorMessage(std::string unique_simulation_label)
+/// \fn pybind11::tuple JointForceBank::evaluate(
+///         pybind11::array_t<double, pybind11::array::c_style> x
+///     ) const
 ///
-/// \brief Wrapper on ProteusDSAPI::GetErrorMessage that creates and returns the desired
-///     std::string (i.e., the error message).
+/// \brief Evaluates the law for the given x (one per joint), without touching the 
+///     simulation (e.g., to check or plot the law).
 ///
-/// \param unique_simulation_label The API label for the target simulation.
+/// \param x The driving variable of each joint.
 ///
-/// \return The desired error message (std::string).
+/// \return A (force, dF/dx) tuple of arrays.
 ///
 
-std::string GetErrorMessage(std::string unique_simulation_label)
+pybind11::tuple JointForceBank::evaluate(pybind11::array_t<double, pybind11::array::c_style> x) const
 {
-    std::string error_message = "";
-    ProteusDSAPI::GetErrorMessage(unique_simulation_label, error_message);
+    if ((size_t)x.size() != this->joints.size()) {
+        throw std::invalid_argument("ERROR: expected one x per joint");
+    }
     
-    return error_message;
-}   /* GetErrorMessage() */
+    pybind11::array_t<double> force((pybind11::ssize_t)x.size());
+    pybind11::array_t<double> dforce_dx((pybind11::ssize_t)x.size());
+    
+    EvaluateJointForces(
+        this->law,
+        this->parameters,
+        x.size(),
+        x.data(),
+        force.mutable_data(),
+        dforce_dx.mutable_data()
+    );
+    
+    return pybind11::make_tuple(force, dforce_dx);
+}   /* evaluate() */
 
 // ----------------------------------------------------------------------------------------------------- //
 
-// ==== END Get wrappers =============================================================================== //
+// ==== END Joint force banks ========================================================================== //
 
 
 
@@ -428,34 +9486,689 @@ PYBIND11_MODULE(ProteusDSAPI, m) {
     // ---- Bindings for ProteusDSAPI.h (C++) ---------------------------------------------------------- //
     
     // this initializes ProteusDS using command line parameters
-    m.def("InitializeProteusDS", &(ProteusDSAPI::InitializeProteusDS));
+    m.def("InitializeProteusDS", BindApi<FN_INITIALIZE_PROTEUSDS>(&(ProteusDSAPI::InitializeProteusDS)));
     
     // this terminates the ProteusDS simulation
-    m.def("Close", &(ProteusDSAPI::Close));
+    m.def("Close", &(Close));
     
     // this moves the ProteusDS simulation ahead by dt (finite) seconds
-    m.def("AdvanceTime", &(ProteusDSAPI::AdvanceTime));
+    m.def("AdvanceTime", BindApi<FN_ADVANCE_TIME>(&(ProteusDSAPI::AdvanceTime)));
     
     // this provides an interface for DObject interaction
+    //
+    // NOTE: The NumPy overloads are registered first, and only accept exactly matching arrays
+    //       (C-contiguous, float64 or numpy.intc), so that everything else falls through to the
+    //       original std::vector (i.e., list) overloads.
+    m.def(
+        "GetDoubleArray",
+        &(GetDoubleArrayNumPy),
+        pybind11::arg("unique_simulation_label"),
+        pybind11::arg("command"),
+        pybind11::arg("dobject_name"),
+        pybind11::arg("out").noconvert()
+    );
     m.def("GetDoubleArray", &(GetDoubleArray));
     m.def("GetDouble", &(GetDouble));
+    m.def(
+        "GetIntArray",
+        &(GetIntArrayNumPy),
+        pybind11::arg("unique_simulation_label"),
+        pybind11::arg("command"),
+        pybind11::arg("dobject_name"),
+        pybind11::arg("out").noconvert()
+    );
     m.def("GetIntArray", &(GetIntArray));
     m.def("GetInt", &(GetInt));
     m.def("GetString", &(GetString));
     m.def("GetErrorMessage", &(GetErrorMessage));
+    m.def("GetDObjectNames", &(GetDObjectNames));
+    m.def("GetDObjectTypes", &(GetDObjectTypes));
+    m.def("RefreshMetadata", &(RefreshMetadata));
     
-    m.def("SetDoubleArray", &(ProteusDSAPI::SetDoubleArray));
-    m.def("SetDouble", &(ProteusDSAPI::SetDouble));
-    m.def("SetIntArray", &(ProteusDSAPI::SetIntArray));
-    m.def("SetInt", &(ProteusDSAPI::SetInt));
-    m.def("SetString", &(ProteusDSAPI::SetString));
+    m.def(
+        "SetDoubleArray",
+        &(SetDoubleArrayNumPy),
+        pybind11::arg("unique_simulation_label"),
+        pybind11::arg("command"),
+        pybind11::arg("dobject_name"),
+        pybind11::arg("values").noconvert()
+    );
+    m.def("SetDoubleArray", BindApi<FN_SET_DOUBLE_ARRAY>(&(ProteusDSAPI::SetDoubleArray)));
+    m.def("SetDouble", BindApi<FN_SET_DOUBLE>(&(ProteusDSAPI::SetDouble)));
+    m.def(
+        "SetIntArray",
+        &(SetIntArrayNumPy),
+        pybind11::arg("unique_simulation_label"),
+        pybind11::arg("command"),
+        pybind11::arg("dobject_name"),
+        pybind11::arg("values").noconvert()
+    );
+    m.def("SetIntArray", BindApi<FN_SET_INT_ARRAY>(&(ProteusDSAPI::SetIntArray)));
+    m.def("SetInt", BindApi<FN_SET_INT>(&(ProteusDSAPI::SetInt)));
+    m.def("SetString", BindApi<FN_SET_STRING>(&(ProteusDSAPI::SetString)));
+    
+    // this provides a batched (one crossing, GIL released) interface for DObject interaction
+    m.def(
+        "GatherDoubles",
+        &(GatherDoubles),
+        pybind11::arg("unique_simulation_label"),
+        pybind11::arg("requests"),
+        pybind11::arg("out").noconvert()
+    );
+    m.def(
+        "ScatterDoubles",
+        &(ScatterDoubles),
+        pybind11::arg("unique_simulation_label"),
+        pybind11::arg("requests"),
+        pybind11::arg("values").noconvert()
+    );
     
     // this provides an interface to the experimental custom cable commands
-    m.def("DisconnectCable", &(ProteusDSAPI::DisconnectCable));
-    m.def("MakeDCableDCablePointConnection", &(ProteusDSAPI::MakeDCableDCablePointConnection));
-    m.def("SetCableEndNodeKinematicMode", &(ProteusDSAPI::SetCableEndNodeKinematicMode));
+    m.def("DisconnectCable", BindApi<FN_DISCONNECT_CABLE>(&(ProteusDSAPI::DisconnectCable)));
+    m.def("MakeDCableDCablePointConnection", BindApi<FN_MAKE_DCABLE_DCABLE_POINT_CONNECTION>(&(ProteusDSAPI::MakeDCableDCablePointConnection)));
+    m.def("SetCableEndNodeKinematicMode", BindApi<FN_SET_CABLE_END_NODE_KINEMATIC_MODE>(&(ProteusDSAPI::SetCableEndNodeKinematicMode)));
     
     // ---- END Bindings for ProteusDSAPI.h (C++) ------------------------------------------------------ //
+    
+    
+    
+    // ---- Bindings for handles and plans ------------------------------------------------------------- //
+    
+    pybind11::class_<DObjectHandle>(m, "DObjectHandle")
+        .def_property_readonly("simulation_label", &DObjectHandle::label)
+        .def_property_readonly("name", &DObjectHandle::name)
+        .def_readonly("type", &DObjectHandle::dobject_type)
+        .def(
+            "__repr__",
+            [](const DObjectHandle& handle) {
+                return "<DObjectHandle " + handle.label() + "/" + handle.name() + ">";
+            }
+        );
+    
+    pybind11::class_<Simulation>(m, "Simulation")
+        .def(pybind11::init<std::string>(), pybind11::arg("unique_simulation_label"))
+        .def_property_readonly("label", &Simulation::label)
+        .def_readonly("dobject_names", &Simulation::dobject_names)
+        .def_readonly("dobject_types", &Simulation::dobject_types)
+        .def_property_readonly(
+            "rigid_bodies",
+            [](const Simulation& simulation) {
+                std::vector<std::string> rigid_body_names;
+                
+                for (const std::string* name_ptr : simulation.rigid_body_name_ptrs) {
+                    rigid_body_names.push_back(*name_ptr);
+                }
+                
+                return rigid_body_names;
+            }
+        )
+        .def("refresh", &Simulation::refresh)
+        .def("dobject", &Simulation::dobject, pybind11::arg("dobject_name"))
+        .def(
+            "advance_time",
+            &Simulation::advanceTime,
+            pybind11::arg("dt"),
+            pybind11::call_guard<pybind11::gil_scoped_release>()
+        )
+        .def(
+            "advance_time_async",
+            [](const Simulation& simulation, double dt) {
+                return AdvanceTimeAsync(simulation.label(), dt);
+            },
+            pybind11::arg("dt")
+        );
+    
+    pybind11::class_<RequestPlan>(m, "RequestPlan")
+        .def(pybind11::init<const Simulation&>(), pybind11::arg("simulation"))
+        .def(
+            "read",
+            &RequestPlan::read,
+            pybind11::arg("handle"),
+            pybind11::arg("command"),
+            pybind11::arg("n_elements") = 0
+        )
+        .def("read_int", &RequestPlan::readInt, pybind11::arg("handle"), pybind11::arg("command"))
+        .def(
+            "write",
+            &RequestPlan::write,
+            pybind11::arg("handle"),
+            pybind11::arg("command"),
+            pybind11::arg("n_elements") = 0
+        )
+        .def("write_int", &RequestPlan::writeInt, pybind11::arg("handle"), pybind11::arg("command"))
+        .def("freeze", &RequestPlan::freeze)
+        .def("gather", &RequestPlan::gather, pybind11::call_guard<pybind11::gil_scoped_release>())
+        .def("scatter", &RequestPlan::scatter, pybind11::call_guard<pybind11::gil_scoped_release>())
+        .def("execute", &RequestPlan::execute, pybind11::call_guard<pybind11::gil_scoped_release>())
+        .def_property_readonly(
+            "read_values",
+            [](pybind11::object self) {
+                RequestPlan& plan = self.cast<RequestPlan&>();
+                plan.freeze();
+                
+                return pybind11::array_t<double>(
+                    plan.read_values.size(),
+                    plan.read_values.data(),
+                    self
+                );
+            }
+        )
+        .def_property_readonly(
+            "write_values",
+            [](pybind11::object self) {
+                RequestPlan& plan = self.cast<RequestPlan&>();
+                plan.freeze();
+                
+                return pybind11::array_t<double>(
+                    plan.write_values.size(),
+                    plan.write_values.data(),
+                    self
+                );
+            }
+        );
+    
+    // ---- END Bindings for handles and plans --------------------------------------------------------- //
+    
+    
+    
+    // ---- Bindings for controllers and step loop ----------------------------------------------------- //
+    
+    pybind11::class_<Controller>(m, "Controller")
+        .def_readonly("handle", &Controller::handle)
+        .def_readwrite("clears_forces", &Controller::clears_forces)
+        .def_readwrite("output_command", &Controller::output_command)
+        .def_readonly("output", &Controller::output)
+        .def("reset", &Controller::reset);
+    
+    pybind11::class_<Observer>(m, "Observer")
+        .def("observe", &Observer::observe, pybind11::arg("time"));
+    
+    pybind11::class_<LinearJointDamping, Controller>(m, "LinearJointDamping")
+        .def(
+            pybind11::init<const DObjectHandle&, double>(),
+            pybind11::arg("handle"),
+            pybind11::arg("damping_coefficient")
+        )
+        .def_readwrite("damping_coefficient", &LinearJointDamping::damping_coefficient);
+    
+    pybind11::class_<QuadraticJointDamping, Controller>(m, "QuadraticJointDamping")
+        .def(
+            pybind11::init<const DObjectHandle&, double>(),
+            pybind11::arg("handle"),
+            pybind11::arg("damping_coefficient")
+        )
+        .def_readwrite("damping_coefficient", &QuadraticJointDamping::damping_coefficient);
+    
+    pybind11::class_<PIDController, Controller>(m, "PIDController")
+        .def(
+            pybind11::init<const DObjectHandle&, size_t, double, double, double, double>(),
+            pybind11::arg("handle"),
+            pybind11::arg("state_index"),
+            pybind11::arg("set_point"),
+            pybind11::arg("k_p"),
+            pybind11::arg("k_i") = 0.0,
+            pybind11::arg("k_d") = 0.0
+        )
+        .def_readwrite("set_point", &PIDController::set_point)
+        .def_readwrite("k_p", &PIDController::k_p)
+        .def_readwrite("k_i", &PIDController::k_i)
+        .def_readwrite("k_d", &PIDController::k_d);
+    
+    pybind11::class_<TableForceController, Controller>(m, "TableForceController")
+        .def(
+            pybind11::init<const DObjectHandle&, size_t, std::vector<double>, std::vector<double>>(),
+            pybind11::arg("handle"),
+            pybind11::arg("state_index"),
+            pybind11::arg("x_table"),
+            pybind11::arg("force_table")
+        );
+    
+    m.def(
+        "RunLoop",
+        &(RunLoop),
+        pybind11::arg("simulation"),
+        pybind11::arg("dt"),
+        pybind11::arg("end_time"),
+        pybind11::arg("controllers"),
+        pybind11::arg("callback") = pybind11::none(),
+        pybind11::arg("callback_every") = 1,
+        pybind11::arg("observers") = std::vector<Observer*>()
+    );
+    
+    // ---- END Bindings for controllers and step loop ------------------------------------------------- //
+    
+    
+    
+    // ---- Bindings for schedulers -------------------------------------------------------------------- //
+    
+    pybind11::class_<CallbackController, Controller>(m, "CallbackController")
+        .def(
+            pybind11::init<const DObjectHandle&, pybind11::object, int>(),
+            pybind11::arg("handle"),
+            pybind11::arg("callback"),
+            pybind11::arg("output_command") = (int)PDSAPI::PDSAPI::rigidBodyJointForceAndDeriv
+        )
+        .def_readwrite("callback", &CallbackController::callback);
+    
+    pybind11::class_<Scheduler>(m, "Scheduler")
+        .def(pybind11::init<const Simulation&>(), pybind11::arg("simulation"))
+        .def(
+            "add_controller",
+            &Scheduler::addController,
+            pybind11::arg("controller"),
+            pybind11::arg("period"),
+            pybind11::arg("priority") = 0,
+            pybind11::arg("phase") = 0.0,
+            pybind11::keep_alive<1, 2>()
+        )
+        .def(
+            "add_callback",
+            &Scheduler::addCallback,
+            pybind11::arg("callback"),
+            pybind11::arg("period"),
+            pybind11::arg("priority") = 0,
+            pybind11::arg("phase") = 0.0
+        )
+        .def(
+            "breakpoints",
+            &Scheduler::breakpoints,
+            pybind11::arg("start_time"),
+            pybind11::arg("end_time")
+        )
+        .def(
+            "run",
+            &Scheduler::run,
+            pybind11::arg("end_time"),
+            pybind11::arg("observers") = std::vector<Observer*>()
+        )
+        .def("stop", &Scheduler::stop)
+        .def_readonly("n_breakpoints", &Scheduler::n_breakpoints)
+        .def_property_readonly(
+            "task_runs",
+            [](const Scheduler& scheduler) {
+                std::vector<size_t> task_runs;
+                
+                for (const ScheduledTask& task : scheduler.tasks) {
+                    task_runs.push_back(task.n_runs);
+                }
+                
+                return task_runs;
+            }
+        );
+    
+    // ---- END Bindings for schedulers ---------------------------------------------------------------- //
+    
+    
+    
+    // ---- Bindings for ensembles --------------------------------------------------------------------- //
+    
+    pybind11::class_<Ensemble>(m, "Ensemble")
+        .def(
+            pybind11::init<double, double, std::vector<DoubleRequest>, size_t, size_t, std::string>(),
+            pybind11::arg("dt"),
+            pybind11::arg("end_time"),
+            pybind11::arg("channels"),
+            pybind11::arg("record_every") = 1,
+            pybind11::arg("n_workers") = 0,
+            pybind11::arg("mode") = "thread"
+        )
+        .def(
+            "add_member",
+            &Ensemble::addMember,
+            pybind11::arg("unique_simulation_label"),
+            pybind11::arg("arguments"),
+            pybind11::arg("overrides") = std::vector<ParameterOverride>()
+        )
+        .def("run", &Ensemble::run)
+        .def_readonly("channel_offsets", &Ensemble::channel_offsets)
+        .def_readonly("errors", &Ensemble::errors)
+        .def_readonly("results", &Ensemble::results)
+        .def_property_readonly(
+            "labels",
+            [](const Ensemble& ensemble) {
+                std::vector<std::string> labels;
+                
+                for (const EnsembleMember& member : ensemble.members) {
+                    labels.push_back(member.unique_simulation_label);
+                }
+                
+                return labels;
+            }
+        );
+    
+    // ---- END Bindings for ensembles ----------------------------------------------------------------- //
+    
+    
+    
+    // ---- Bindings for warm start pools -------------------------------------------------------------- //
+    
+    #ifdef PDSAPI_BINDINGS_HAS_FORK
+        pybind11::class_<WarmStartPool>(m, "WarmStartPool")
+            .def(
+                pybind11::init<std::string, std::string, double, bool>(),
+                pybind11::arg("unique_simulation_label"),
+                pybind11::arg("arguments"),
+                pybind11::arg("spin_up_time") = 0.0,
+                pybind11::arg("disable_file_output") = true
+            )
+            .def(
+                "run",
+                &WarmStartPool::run,
+                pybind11::arg("member_overrides"),
+                pybind11::arg("dt"),
+                pybind11::arg("duration"),
+                pybind11::arg("channels"),
+                pybind11::arg("record_every") = 1,
+                pybind11::arg("n_workers") = 0
+            )
+            .def("close", &WarmStartPool::close)
+            .def_readonly("unique_simulation_label", &WarmStartPool::unique_simulation_label)
+            .def_readonly("spin_up_time", &WarmStartPool::spin_up_time_s)
+            .def_readonly("errors", &WarmStartPool::errors);
+    #endif
+    
+    // ---- END Bindings for warm start pools ---------------------------------------------------------- //
+    
+    
+    
+    // ---- Bindings for snapshots --------------------------------------------------------------------- //
+    
+    pybind11::class_<SimulationSnapshot>(m, "SimulationSnapshot")
+        .def_property_readonly("simulation_label", &SimulationSnapshot::label)
+        .def_readonly("time", &SimulationSnapshot::time_s)
+        .def_readonly("state_offsets", &SimulationSnapshot::state_offsets)
+        .def_readonly("state_sizes", &SimulationSnapshot::state_sizes)
+        .def_readonly("parameter_offsets", &SimulationSnapshot::parameter_offsets)
+        .def_property_readonly(
+            "dobject_names",
+            [](const SimulationSnapshot& snapshot) {
+                std::vector<std::string> dobject_names;
+                
+                for (const std::string* dobject_name_ptr : snapshot.dobject_name_ptrs) {
+                    dobject_names.push_back(*dobject_name_ptr);
+                }
+                
+                return dobject_names;
+            }
+        )
+        .def_property_readonly(
+            "values",
+            [](pybind11::object self) {
+                SimulationSnapshot& snapshot = self.cast<SimulationSnapshot&>();
+                
+                return pybind11::array_t<double>(
+                    snapshot.buffer.size(),
+                    snapshot.buffer.data(),
+                    self
+                );
+            }
+        )
+        .def(
+            "capture",
+            &SimulationSnapshot::capture,
+            pybind11::call_guard<pybind11::gil_scoped_release>()
+        );
+    
+    m.def(
+        "Snapshot",
+        &(Snapshot),
+        pybind11::arg("simulation"),
+        pybind11::arg("parameters") = std::vector<DoubleRequest>()
+    );
+    m.def("Restore", &(Restore), pybind11::arg("simulation"), pybind11::arg("snapshot"));
+    
+    // ---- END Bindings for snapshots ----------------------------------------------------------------- //
+    
+    
+    
+    // ---- Bindings for recorders --------------------------------------------------------------------- //
+    
+    pybind11::class_<Recorder, Observer>(m, "Recorder")
+        .def(
+            pybind11::init<
+                const Simulation&,
+                std::vector<std::tuple<DObjectHandle, int, size_t>>,
+                std::string,
+                size_t,
+                size_t
+            >(),
+            pybind11::arg("simulation"),
+            pybind11::arg("channels"),
+            pybind11::arg("directory"),
+            pybind11::arg("chunk_rows") = 1024,
+            pybind11::arg("n_chunks") = 8
+        )
+        .def("sample", &Recorder::sample, pybind11::call_guard<pybind11::gil_scoped_release>())
+        .def("flush", &Recorder::flush, pybind11::call_guard<pybind11::gil_scoped_release>())
+        .def("close", &Recorder::close, pybind11::call_guard<pybind11::gil_scoped_release>())
+        .def_readonly("directory", &Recorder::directory)
+        .def_property_readonly(
+            "rows_sampled",
+            [](const Recorder& recorder) { return recorder.rows_sampled.load(); }
+        )
+        .def_property_readonly(
+            "rows_written",
+            [](const Recorder& recorder) { return recorder.rows_written.load(); }
+        )
+        .def_property_readonly(
+            "rows_dropped",
+            [](const Recorder& recorder) { return recorder.rows_dropped.load(); }
+        );
+    
+    // ---- END Bindings for recorders ----------------------------------------------------------------- //
+    
+    
+    
+    // ---- Bindings for cable views ------------------------------------------------------------------- //
+    
+    pybind11::class_<CableView>(m, "CableView")
+        .def(
+            pybind11::init<const Simulation&, std::string>(),
+            pybind11::arg("simulation"),
+            pybind11::arg("cable_name")
+        )
+        .def_readonly("handle", &CableView::handle)
+        .def("shape", &CableView::shape, pybind11::arg("field"))
+        .def(
+            "get",
+            &CableView::getInto,
+            pybind11::arg("field"),
+            pybind11::arg("out").noconvert()
+        )
+        .def("get", &CableView::get, pybind11::arg("field"));
+    
+    m.def(
+        "GetCableFields",
+        &(GetCableFields),
+        pybind11::arg("simulation"),
+        pybind11::arg("cable_names"),
+        pybind11::arg("fields")
+    );
+    
+    // ---- END Bindings for cable views --------------------------------------------------------------- //
+    
+    
+    
+    // ---- Bindings for rigid body fleets ------------------------------------------------------------- //
+    
+    m.def(
+        "GetRigidBodyFleet",
+        &(GetRigidBodyFleet),
+        pybind11::arg("simulation"),
+        pybind11::arg("fields")
+    );
+    m.def(
+        "SetRigidBodyFleet",
+        &(SetRigidBodyFleet),
+        pybind11::arg("simulation"),
+        pybind11::arg("command"),
+        pybind11::arg("values"),
+        pybind11::arg("clear_forces") = false
+    );
+    
+    // ---- END Bindings for rigid body fleets --------------------------------------------------------- //
+    
+    
+    
+    // ---- Bindings for publishers -------------------------------------------------------------------- //
+    
+    #ifdef PDSAPI_BINDINGS_HAS_SHM
+        pybind11::class_<Publisher, Observer>(m, "Publisher")
+            .def(
+                pybind11::init<
+                    const Simulation&,
+                    std::vector<std::tuple<DObjectHandle, int, size_t>>,
+                    std::string,
+                    bool
+                >(),
+                pybind11::arg("simulation"),
+                pybind11::arg("channels"),
+                pybind11::arg("name"),
+                pybind11::arg("unlink_on_close") = true
+            )
+            .def("publish", &Publisher::publish, pybind11::call_guard<pybind11::gil_scoped_release>())
+            .def("close", &Publisher::close, pybind11::call_guard<pybind11::gil_scoped_release>())
+            .def_readonly("name", &Publisher::name)
+            .def_property_readonly(
+                "frames_published",
+                [](const Publisher& publisher) { return publisher.frames_published.load(); }
+            );
+    #endif
+    
+    // ---- END Bindings for publishers ---------------------------------------------------------------- //
+    
+    
+    
+    // ---- Bindings for forcing streams --------------------------------------------------------------- //
+    
+    #ifdef PDSAPI_BINDINGS_HAS_SHM
+        pybind11::class_<ForcingStream, Controller>(m, "ForcingStream")
+            .def(
+                pybind11::init<
+                    const Simulation&,
+                    std::string,
+                    std::vector<std::tuple<DObjectHandle, int, size_t, std::string>>,
+                    double,
+                    size_t,
+                    bool
+                >(),
+                pybind11::arg("simulation"),
+                pybind11::arg("time_file"),
+                pybind11::arg("channels"),
+                pybind11::arg("time_offset") = 0.0,
+                pybind11::arg("prefetch_rows") = 4096,
+                pybind11::arg("clears_loads") = true
+            )
+            .def("apply", &ForcingStream::applyNow, pybind11::call_guard<pybind11::gil_scoped_release>())
+            .def_readonly("n_rows", &ForcingStream::n_rows)
+            .def_readonly("cursor", &ForcingStream::cursor)
+            .def_readwrite("time_offset", &ForcingStream::time_offset_s)
+            .def_readwrite("clears_loads", &ForcingStream::clears_loads)
+            .def_property_readonly("start_time", &ForcingStream::startTime)
+            .def_property_readonly("end_time", &ForcingStream::endTime);
+    #endif
+    
+    // ---- END Bindings for forcing streams ----------------------------------------------------------- //
+    
+    
+    
+    // ---- Bindings for joint force banks ------------------------------------------------------------- //
+    
+    pybind11::enum_<JointForceLaw>(m, "JointForceLaw")
+        .value("LINEAR", JointForceLaw::JOINT_FORCE_LINEAR)
+        .value("QUADRATIC", JointForceLaw::JOINT_FORCE_QUADRATIC)
+        .value("COULOMB", JointForceLaw::JOINT_FORCE_COULOMB)
+        .value("LOOKUP", JointForceLaw::JOINT_FORCE_LOOKUP);
+    
+    pybind11::class_<JointForceBank, Controller>(m, "JointForceBank")
+        .def(
+            pybind11::init<
+                const Simulation&,
+                std::vector<std::string>,
+                int,
+                std::vector<double>,
+                std::vector<double>,
+                std::vector<double>,
+                std::vector<double>,
+                std::vector<double>,
+                size_t,
+                int,
+                bool
+            >(),
+            pybind11::arg("simulation"),
+            pybind11::arg("joints"),
+            pybind11::arg("law"),
+            pybind11::arg("coefficients") = std::vector<double>(),
+            pybind11::arg("coulomb_forces") = std::vector<double>(),
+            pybind11::arg("deadbands") = std::vector<double>(),
+            pybind11::arg("x_table") = std::vector<double>(),
+            pybind11::arg("force_table") = std::vector<double>(),
+            pybind11::arg("state_index") = 0,
+            pybind11::arg("output_command") = (int)PDSAPI::PDSAPI::rigidBodyJointForceAndDeriv,
+            pybind11::arg("clears_joint_forces") = true
+        )
+        .def(
+            "apply",
+            &JointForceBank::applyNow,
+            pybind11::arg("dt"),
+            pybind11::call_guard<pybind11::gil_scoped_release>()
+        )
+        .def("evaluate", &JointForceBank::evaluate, pybind11::arg("x"))
+        .def_readonly("law", &JointForceBank::law)
+        .def_readonly("joints", &JointForceBank::joints)
+        .def_readonly("force", &JointForceBank::force)
+        .def_readonly("dforce_dt", &JointForceBank::dforce_dt)
+        .def_readwrite("clears_joint_forces", &JointForceBank::clears_joint_forces);
+    
+    // ---- END Bindings for joint force banks --------------------------------------------------------- //
+    
+    
+    
+    // ---- Bindings for instrumentation --------------------------------------------------------------- //
+    
+    #ifdef PDSAPI_BINDINGS_INSTRUMENT
+        m.attr("INSTRUMENTED") = true;
+        
+        m.def("GetInstrumentation", &(GetInstrumentation));
+        m.def("ResetInstrumentation", &(ResetInstrumentation));
+        m.def(
+            "SetInstrumentation",
+            [](bool enabled) { instrumentation_enabled.store(enabled); },
+            pybind11::arg("enabled")
+        );
+    #else
+        m.attr("INSTRUMENTED") = false;
+        
+        m.def("GetInstrumentation", []() { return pybind11::list(); });
+        m.def("ResetInstrumentation", []() { return; });
+        m.def("SetInstrumentation", [](bool) { return; }, pybind11::arg("enabled"));
+    #endif  /* PDSAPI_BINDINGS_INSTRUMENT */
+    
+    // ---- END Bindings for instrumentation ----------------------------------------------------------- //
+    
+    
+    
+    // ---- Bindings for asynchronous stepping --------------------------------------------------------- //
+    
+    m.def(
+        "AdvanceTimeAsync",
+        [](const Simulation& simulation, double dt) {
+            return AdvanceTimeAsync(simulation.label(), dt);
+        },
+        pybind11::arg("simulation"),
+        pybind11::arg("dt")
+    );
+    m.def(
+        "AdvanceTimeAsync",
+        &(AdvanceTimeAsync),
+        pybind11::arg("unique_simulation_label"),
+        pybind11::arg("dt")
+    );
+    
+    //  stop worker threads before the interpreter shuts down
+    pybind11::module_::import("atexit").attr("register")(pybind11::cpp_function(&StopSimulationWorkers));
+    
+    // ---- END Bindings for asynchronous stepping ----------------------------------------------------- //
 
 }   /* PYBIND11_MODULE() */
 
@@ -0,0 +1,280 @@
+"""
+    Copyright 2023 - Anthony Truelove MASc, P.Eng.
+    
+    Redistribution and use in source and binary forms, with or without modification, are
+    permitted provided that the following conditions are met:
+    
+    1. Redistributions of source code must retain the above copyright notice, this list of
+    conditions and the following disclaimer.
+    
+    2. Redistributions in binary form must reproduce the above copyright notice, this list
+    of conditions and the following disclaimer in the documentation and/or other materials
+    provided with the distribution.
+    
+    3. Neither the name of the copyright holder nor the names of its contributors may be
+    used to endorse or promote products derived from this software without specific prior
+    written permission.
+    
+    THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS “AS IS” AND ANY
+    EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+    MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL
+    THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+    SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT
+    OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+    HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR
+    TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+    SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE. 
+"""
+
+"""
+    Anthony Truelove MASc, P.Eng.  
+    email:   wtruelove@uvic.ca
+    github:  gears1763-2 
+    
+    A small reader for the shared memory segments written by `ProteusDSAPI.Publisher` (see the
+    Publishers section of `PYBIND11_ProteusDSAPI.cpp` for the layout). It does not need the
+    bindings (or the ProteusDS API) to be importable, only NumPy, so it can be used from any
+    process (a viewer, a dashboard, a logger) on the same machine. For example,
+    
+        from ProteusDSAPIReader import Subscriber
+        
+        subscriber = Subscriber("pds_live")
+        frame = subscriber.read()
+        print(frame.frame_number, frame.time, frame.values[0])
+    
+    or, from the command line (to print the latest frame twice a second),
+    
+    >  python(3) ProteusDSAPIReader.py pds_live --period 0.5
+    
+    The reader takes no locks, and never blocks the writer: it copies the latest frame, and 
+    retries if the writer overwrote it mid-copy (which requires the reader to fall more than a 
+    whole frame behind). Note that the retry check relies on the loads being issued in program 
+    order, which holds on x86(-64) but not on every architecture.
+"""
+
+
+import argparse
+import collections
+import json
+import sys
+import time
+
+from multiprocessing import shared_memory
+
+import numpy as np
+
+
+SHM_VERSION = 1
+
+#   header fields (as uint64 indices; see PublisherHeader)
+HEADER_VERSION = 0
+HEADER_N_SLOTS = 1
+HEADER_FRAME_BYTES = 2
+HEADER_INDEX_OFFSET = 3
+HEADER_INDEX_BYTES = 4
+HEADER_SLOT_OFFSET = 5
+HEADER_LATEST_SLOT = 6
+HEADER_FRAMES_PUBLISHED = 7
+HEADER_IS_CLOSED = 8
+HEADER_SLOT_SEQUENCES = 9
+HEADER_SIZE = 16
+
+
+Frame = collections.namedtuple("Frame", ["frame_number", "time", "values"])
+
+
+def attach(name):
+    """
+    Attaches to an existing segment without taking ownership of it (i.e., without the
+    resource tracker unlinking it when this process exits).
+    """
+    
+    if sys.version_info >= (3, 13):
+        return shared_memory.SharedMemory(name=name, track=False)
+    
+    segment = shared_memory.SharedMemory(name=name)
+    
+    if sys.platform != "win32":
+        from multiprocessing import resource_tracker
+        resource_tracker.unregister(segment._name, "shared_memory")
+    
+    return segment
+
+
+class Subscriber:
+    """
+    A reader of a Publisher's shared memory segment. `channels` lists the published channels 
+    (dicts of dobject, command, n_elements, and offset), in the order of `Frame.values`.
+    """
+    
+    def __init__(self, name, timeout_s=10.0):
+        """
+        Attaches to the named segment, waiting up to timeout_s for it to be created and
+        initialized.
+        """
+        
+        deadline = time.monotonic() + timeout_s
+        
+        while True:
+            try:
+                self.segment = attach(name)
+                break
+            
+            except FileNotFoundError:
+                if time.monotonic() > deadline:
+                    raise
+                
+                time.sleep(0.01)
+        
+        self.header = np.ndarray((HEADER_SIZE,), dtype="<u8", buffer=self.segment.buf)
+        
+        while int(self.header[HEADER_VERSION]) == 0:
+            if time.monotonic() > deadline:
+                raise TimeoutError("segment " + name + " was never initialized")
+            
+            time.sleep(0.01)
+        
+        if int(self.header[HEADER_VERSION]) != SHM_VERSION:
+            raise RuntimeError("segment " + name + " has an unsupported version")
+        
+        self.name = name
+        self.n_slots = int(self.header[HEADER_N_SLOTS])
+        
+        index_offset = int(self.header[HEADER_INDEX_OFFSET])
+        index_bytes = int(self.header[HEADER_INDEX_BYTES])
+        index = json.loads(bytes(self.segment.buf[index_offset : index_offset + index_bytes]))
+        
+        self.simulation = index["simulation"]
+        self.channels = index["channels"]
+        
+        n_frame = 1 + sum(max(channel["n_elements"], 1) for channel in self.channels)
+        frame_bytes = int(self.header[HEADER_FRAME_BYTES])
+        slot_offset = int(self.header[HEADER_SLOT_OFFSET])
+        
+        self.slots = [
+            np.ndarray(
+                (n_frame,),
+                dtype="<f8",
+                buffer=self.segment.buf,
+                offset=slot_offset + slot * frame_bytes
+            )
+            for slot in range(self.n_slots)
+        ]
+        
+        self.frame_number = 0
+        
+        return
+    
+    
+    @property
+    def frames_published(self):
+        return int(self.header[HEADER_FRAMES_PUBLISHED])
+    
+    
+    @property
+    def is_closed(self):
+        return int(self.header[HEADER_IS_CLOSED]) != 0
+    
+    
+    def channel_index(self, dobject, command):
+        """
+        Returns the position (in `Frame.values`) of the given channel.
+        """
+        
+        for i, channel in enumerate(self.channels):
+            if channel["dobject"] == dobject and channel["command"] == int(command):
+                return i
+        
+        raise KeyError((dobject, command))
+    
+    
+    def read(self, max_retries=1000):
+        """
+        Returns a consistent copy of the latest frame (or None if nothing has been published
+        yet). Scalar channels are returned as floats, and array channels as 1D arrays.
+        """
+        
+        for _ in range(max_retries):
+            if self.frames_published == 0:
+                return None
+            
+            slot = int(self.header[HEADER_LATEST_SLOT])
+            sequence = int(self.header[HEADER_SLOT_SEQUENCES + slot])
+            
+            if sequence % 2 == 1:
+                continue
+            
+            frame = self.slots[slot].copy()
+            frame_number = int(self.header[HEADER_SLOT_SEQUENCES + self.n_slots + slot])
+            
+            if int(self.header[HEADER_SLOT_SEQUENCES + slot]) == sequence:
+                break
+        
+        else:
+            raise RuntimeError("failed to read a consistent frame from " + self.name)
+        
+        values = []
+        
+        for channel in self.channels:
+            offset = channel["offset"]
+            
+            if channel["n_elements"] == 0:
+                values.append(float(frame[offset]))
+            
+            else:
+                values.append(frame[offset : offset + channel["n_elements"]])
+        
+        self.frame_number = frame_number
+        
+        return Frame(frame_number, float(frame[0]), values)
+    
+    
+    def read_new(self):
+        """
+        As read(), but returns None unless a newer frame than the last one read is available.
+        """
+        
+        if self.frames_published <= self.frame_number:
+            return None
+        
+        return self.read()
+    
+    
+    def close(self):
+        """
+        Detaches from the segment (without removing it).
+        """
+        
+        self.slots = []
+        self.header = None
+        self.segment.close()
+        
+        return
+
+
+if __name__ == "__main__":
+    parser = argparse.ArgumentParser(description="Prints frames from a ProteusDSAPI Publisher.")
+    parser.add_argument("name", help="the name of the shared memory segment")
+    parser.add_argument("--period", type=float, default=1.0, help="the sampling period [s]")
+    args = parser.parse_args()
+    
+    subscriber = Subscriber(args.name)
+    
+    print("simulation:", subscriber.simulation)
+    
+    for i, channel in enumerate(subscriber.channels):
+        print("channel", i, ":", channel["dobject"], channel["command"], channel["n_elements"])
+    
+    try:
+        while not subscriber.is_closed:
+            frame = subscriber.read_new()
+            
+            if frame is not None:
+                print(frame.frame_number, frame.time, frame.values)
+            
+            time.sleep(args.period)
+    
+    except KeyboardInterrupt:
+        pass
+    
+    subscriber.close()
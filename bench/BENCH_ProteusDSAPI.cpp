@@ -0,0 +1,406 @@
+/*
+ *  Copyright 2023 - Anthony Truelove MASc, P.Eng.
+ *
+ *  Redistribution and use in source and binary forms, with or without modification, are
+ *  permitted provided that the following conditions are met:
+ *
+ *  1. Redistributions of source code must retain the above copyright notice, this list of
+ *  conditions and the following disclaimer.
+ *
+ *  2. Redistributions in binary form must reproduce the above copyright notice, this list
+ *  of conditions and the following disclaimer in the documentation and/or other materials
+ *  provided with the distribution.
+ *
+ *  3. Neither the name of the copyright holder nor the names of its contributors may be
+ *  used to endorse or promote products derived from this software without specific prior
+ *  written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS “AS IS” AND ANY
+ *  EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ *  MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL
+ *  THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ *  SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT
+ *  OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ *  HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR
+ *  TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ *  SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE. 
+ */
+
+/*
+ *  Anthony Truelove MASc, P.Eng.  
+ *  email:   wtruelove@uvic.ca
+ *  github:  gears1763-2 
+ *
+ *  Source file for C++ level benchmarks of the bindings (i.e., of the wrappers themselves, 
+ *  without Python call overhead), built against the stub API by setup_bench.py and run by 
+ *  bench_bindings.py.
+ *
+ *  The harness works in the same way as Google Benchmark: each benchmark is first calibrated (by 
+ *  growing the iteration count until a batch takes at least min_time), and then repeated at that
+ *  fixed iteration count, reporting the min, median, and mean time per iteration. Benchmarks
+ *  prefixed "api/" call the (stub) API directly, as a baseline for the wrappers.
+ */
+
+
+///
+/// \file BENCH_ProteusDSAPI.cpp
+///
+/// \brief Source file for C++ level benchmarks of the bindings.
+///
+/// Source file for C++ level benchmarks of the bindings. The bindings are compiled into this 
+/// translation unit, so that the wrappers can be called directly.
+///
+
+
+#include "../PYBIND11_ProteusDSAPI.cpp"
+
+
+// ==== Benchmark harness ============================================================================== //
+
+#define BENCH_LABEL "BenchCpp"
+#define BENCH_MAX_ITERATIONS 1000000000
+
+// ----------------------------------------------------------------------------------------------------- //
+
+///
+/// \struct BenchmarkResult
+///
+/// \brief The result of a single benchmark.
+///
+
+struct BenchmarkResult {
+    std::string name;
+    size_t iterations;
+    size_t repetitions;
+    size_t bytes_per_iteration;
+    double ns_min;
+    double ns_median;
+    double ns_mean;
+};  /* BenchmarkResult */
+
+
+volatile double benchmark_sink = 0;
+
+// ----------------------------------------------------------------------------------------------------- //
+
+
+
+// ----------------------------------------------------------------------------------------------------- //
+
+///
+/// \fn template <typename Body> double TimeBatch(Body& body, size_t n_iterations)
+///
+/// \brief Times n_iterations calls of the given body.
+///
+/// \param body The benchmark body.
+///
+/// \param n_iterations The number of iterations.
+///
+/// \return The elapsed time [s].
+///
+
+template <typename Body>
+double TimeBatch(Body& body, size_t n_iterations)
+{
+    std::chrono::steady_clock::time_point start_time = std::chrono::steady_clock::now();
+    
+    for (size_t i = 0; i < n_iterations; i++) {
+        body();
+    }
+    
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start_time;
+    
+    return elapsed.count();
+}   /* TimeBatch() */
+
+// ----------------------------------------------------------------------------------------------------- //
+
+
+
+// ----------------------------------------------------------------------------------------------------- //
+
+///
+/// \fn template <typename Body> BenchmarkResult RunBenchmark(
+///         const std::string& name,
+///         Body body,
+///         double min_time_s,
+///         size_t repetitions,
+///         size_t bytes_per_iteration
+///     )
+///
+/// \brief Calibrates and then runs the given benchmark.
+///
+/// \param name The benchmark name.
+///
+/// \param body The benchmark body (a callable taking no arguments).
+///
+/// \param min_time_s The minimum time per repetition [s].
+///
+/// \param repetitions The number of repetitions.
+///
+/// \param bytes_per_iteration The payload per iteration (for throughput, 0 if not applicable).
+///
+/// \return The benchmark result.
+///
+
+template <typename Body>
+BenchmarkResult RunBenchmark(
+    const std::string& name,
+    Body body,
+    double min_time_s,
+    size_t repetitions,
+    size_t bytes_per_iteration
+)
+{
+    //  1. calibrate (grow by the predicted factor, at most 10x at a time)
+    size_t n_iterations = 1;
+    
+    while (n_iterations < BENCH_MAX_ITERATIONS) {
+        double elapsed_s = TimeBatch(body, n_iterations);
+        
+        if (elapsed_s >= min_time_s) {
+            break;
+        }
+        
+        double multiplier = (elapsed_s > 0) ? 1.4 * min_time_s / elapsed_s : 10;
+        multiplier = std::min(std::max(multiplier, 2.0), 10.0);
+        
+        n_iterations = std::min((size_t)(n_iterations * multiplier), (size_t)BENCH_MAX_ITERATIONS);
+    }
+    
+    //  2. repeat at a fixed iteration count
+    std::vector<double> ns_per_iteration;
+    
+    for (size_t r = 0; r < std::max(repetitions, (size_t)1); r++) {
+        ns_per_iteration.push_back(1e9 * TimeBatch(body, n_iterations) / n_iterations);
+    }
+    
+    std::sort(ns_per_iteration.begin(), ns_per_iteration.end());
+    
+    BenchmarkResult result;
+    result.name = name;
+    result.iterations = n_iterations;
+    result.repetitions = ns_per_iteration.size();
+    result.bytes_per_iteration = bytes_per_iteration;
+    result.ns_min = ns_per_iteration.front();
+    result.ns_median = ns_per_iteration[ns_per_iteration.size() / 2];
+    result.ns_mean = 0;
+    
+    for (double ns : ns_per_iteration) {
+        result.ns_mean += ns / ns_per_iteration.size();
+    }
+    
+    return result;
+}   /* RunBenchmark() */
+
+// ----------------------------------------------------------------------------------------------------- //
+
+// ==== END Benchmark harness ========================================================================== //
+
+
+
+// ==== Benchmarks ===================================================================================== //
+
+///
+/// \fn pybind11::list RunBenchmarks(double min_time_s, size_t repetitions, std::string filter)
+///
+/// \brief Runs every benchmark whose name contains the given filter, against a fresh stub 
+///     simulation.
+///
+/// \param min_time_s The minimum time per repetition [s].
+///
+/// \param repetitions The number of repetitions.
+///
+/// \param filter Only benchmarks whose names contain this are run ("" for all).
+///
+/// \return A list of dicts (one per benchmark).
+///
+
+pybind11::list RunBenchmarks(double min_time_s, size_t repetitions, std::string filter)
+{
+    const std::string label = BENCH_LABEL;
+    
+    if (!ProteusDSAPI::InitializeProteusDS(label, "-stubRigidBodies 16", false, false)) {
+        throw std::runtime_error("ERROR: failed to initialize stub simulation " + label);
+    }
+    
+    ProteusDSAPI::AdvanceTime(label, 0);
+    
+    std::vector<BenchmarkResult> results;
+    
+    auto run = [&](const std::string& name, auto body, size_t bytes_per_iteration) {
+        if (name.find(filter) == std::string::npos) {
+            return;
+        }
+        
+        results.push_back(RunBenchmark(name, body, min_time_s, repetitions, bytes_per_iteration));
+    };
+    
+    //  1. scalars and strings
+    run(
+        "api/GetDouble",
+        [&]() {
+            double value = 0;
+            ProteusDSAPI::GetDouble(label, PDSAPI::PDSAPI::time, "", value);
+            benchmark_sink = value;
+        },
+        0
+    );
+    
+    run(
+        "GetDouble",
+        [&]() { benchmark_sink = GetDouble(label, PDSAPI::PDSAPI::time, ""); },
+        0
+    );
+    
+    run(
+        "api/GetString/dObjectNames",
+        [&]() {
+            std::string value;
+            ProteusDSAPI::GetString(label, PDSAPI::PDSAPI::dObjectNames, "", value);
+            benchmark_sink = value.size();
+        },
+        0
+    );
+    
+    run(
+        "GetString/dObjectNames",
+        [&]() { benchmark_sink = GetString(label, PDSAPI::PDSAPI::dObjectNames, "").size(); },
+        0
+    );
+    
+    run(
+        "AdvanceTime",
+        [&]() { ProteusDSAPI::AdvanceTime(label, 1.0 / 60); },
+        0
+    );
+    
+    //  2. arrays (sweeping sizes from 2 to 1e6)
+    std::vector<size_t> sizes = {2, 10, 100, 1000, 10000, 100000, 1000000};
+    int array_command = PDSAPI::PDSAPI::rigidBodyRelativeFluidVelocityProbes;
+    
+    for (size_t n_elements : sizes) {
+        std::string suffix = "/" + std::to_string(n_elements);
+        size_t n_bytes = n_elements * sizeof(double);
+        
+        std::vector<double> values(n_elements, 1);
+        pybind11::array_t<double, pybind11::array::c_style> array(n_elements);
+        std::fill(array.mutable_data(), array.mutable_data() + n_elements, 1);
+        
+        run(
+            "api/GetDoubleArray" + suffix,
+            [&]() {
+                ProteusDSAPI::GetDoubleArray(label, array_command, "Float", values);
+                benchmark_sink = values[0];
+            },
+            n_bytes
+        );
+        
+        run(
+            "GetDoubleArray" + suffix,
+            [&]() { benchmark_sink = GetDoubleArray(label, array_command, "Float", n_elements)[0]; },
+            n_bytes
+        );
+        
+        run(
+            "GetDoubleArrayNumPy" + suffix,
+            [&]() {
+                GetDoubleArrayNumPy(label, array_command, "Float", array);
+                benchmark_sink = array.data()[0];
+            },
+            n_bytes
+        );
+        
+        run(
+            "api/SetDoubleArray" + suffix,
+            [&]() { ProteusDSAPI::SetDoubleArray(label, array_command, "Float", values); },
+            n_bytes
+        );
+        
+        run(
+            "SetDoubleArrayNumPy" + suffix,
+            [&]() { SetDoubleArrayNumPy(label, array_command, "Float", array); },
+            n_bytes
+        );
+    }
+    
+    //  3. batched and planned access (the joint damping step, for 16 bodies)
+    std::vector<DoubleRequest> requests;
+    
+    for (size_t i = 0; i < 16; i++) {
+        requests.push_back(DoubleRequest(PDSAPI::PDSAPI::state, "body" + std::to_string(i), 12));
+    }
+    
+    std::vector<size_t> offsets = DoubleRequestOffsets(requests, 16 * 12);
+    std::vector<double> gathered(16 * 12, 0);
+    
+    run(
+        "GatherDoublesInto/16x12",
+        [&]() {
+            GatherDoublesInto(label, requests, offsets, gathered.data());
+            benchmark_sink = gathered[0];
+        },
+        gathered.size() * sizeof(double)
+    );
+    
+    Simulation simulation(label);
+    RequestPlan plan(simulation);
+    
+    for (size_t i = 0; i < 16; i++) {
+        DObjectHandle handle = simulation.dobject("body" + std::to_string(i));
+        
+        plan.read(handle, PDSAPI::PDSAPI::state, 12);
+        plan.write(handle, PDSAPI::PDSAPI::rigidBodyForceAndDerivGlobal, 6);
+    }
+    
+    plan.freeze();
+    
+    run(
+        "RequestPlan.execute/16x12",
+        [&]() {
+            plan.execute();
+            benchmark_sink = plan.read_values[0];
+        },
+        16 * (12 + 6) * sizeof(double)
+    );
+    
+    ProteusDSAPI::Close(label);
+    
+    pybind11::list result_list;
+    
+    for (const BenchmarkResult& result : results) {
+        pybind11::dict result_dict;
+        result_dict["name"] = result.name;
+        result_dict["iterations"] = result.iterations;
+        result_dict["repetitions"] = result.repetitions;
+        result_dict["ns_min"] = result.ns_min;
+        result_dict["ns_median"] = result.ns_median;
+        result_dict["ns_mean"] = result.ns_mean;
+        result_dict["bytes_per_second"] = (result.bytes_per_iteration > 0) ?
+            1e9 * result.bytes_per_iteration / result.ns_median : 0.0;
+        
+        result_list.append(result_dict);
+    }
+    
+    return result_list;
+}   /* RunBenchmarks() */
+
+// ==== END Benchmarks ================================================================================= //
+
+
+
+// ==== Bindings ======================================================================================= //
+
+PYBIND11_MODULE(ProteusDSAPIBench, m) {
+    
+    m.def(
+        "RunBenchmarks",
+        &(RunBenchmarks),
+        pybind11::arg("min_time") = 0.1,
+        pybind11::arg("repetitions") = 5,
+        pybind11::arg("filter") = ""
+    );
+
+}   /* PYBIND11_MODULE() */
+
+// ==== END Bindings =================================================================================== //
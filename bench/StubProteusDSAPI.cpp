@@ -0,0 +1,1070 @@
+/*
+ *  Copyright 2023 - Anthony Truelove MASc, P.Eng.
+ *
+ *  Redistribution and use in source and binary forms, with or without modification, are
+ *  permitted provided that the following conditions are met:
+ *
+ *  1. Redistributions of source code must retain the above copyright notice, this list of
+ *  conditions and the following disclaimer.
+ *
+ *  2. Redistributions in binary form must reproduce the above copyright notice, this list
+ *  of conditions and the following disclaimer in the documentation and/or other materials
+ *  provided with the distribution.
+ *
+ *  3. Neither the name of the copyright holder nor the names of its contributors may be
+ *  used to endorse or promote products derived from this software without specific prior
+ *  written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS “AS IS” AND ANY
+ *  EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ *  MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL
+ *  THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ *  SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT
+ *  OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ *  HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR
+ *  TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ *  SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE. 
+ */
+
+/*
+ *  Anthony Truelove MASc, P.Eng.  
+ *  email:   wtruelove@uvic.ca
+ *  github:  gears1763-2 
+ *
+ *  Source file for a local stub of the ProteusDS API, for building and benchmarking the bindings
+ *  without a licensed install (see setup_bench.py).
+ *
+ *  Each simulation holds a handful of rigid bodies (each degree of freedom being a wave-driven 
+ *  mass-spring-damper, integrated with a fixed internal step) and a cable (whose fields are simple
+ *  functions of time). Everything is deterministic, so that benchmark runs are comparable. 
+ *  Commands that the stub does not model are stored on set and returned on get, and array gets of
+ *  unmodelled commands are filled (to whatever size was asked for) with a cheap deterministic 
+ *  ramp, so that array sizes can be swept freely.
+ *
+ *  The default layout mirrors the joint damping example (RigidBody "Float", "base", "cylinder", 
+ *  and "piston", the latter two being single degree of freedom joints, plus DCable "cable"). The
+ *  arguments string of InitializeProteusDS() also accepts
+ *
+ *      -stubRigidBodies <n>    add n six degree of freedom RigidBody ("body0", "body1", ...)
+ *      -stubCableNodes <n>     set the number of cable nodes (default 50)
+ *      -stubFail               fail to initialize
+ */
+
+
+///
+/// \file StubProteusDSAPI.cpp
+///
+/// \brief Source file for a local stub of the ProteusDS API.
+///
+/// Source file for a local stub of the ProteusDS API, with deterministic fake dynamics.
+///
+
+
+#include <string>
+#include <vector>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <sstream>
+#include <algorithm>
+#include <math.h>
+
+#include "ProteusDSAPI.h"
+
+
+// ==== Stub state ===================================================================================== //
+
+#define STUB_INTERNAL_TIME_STEP 0.005
+#define STUB_DEFAULT_CABLE_NODES 50
+#define STUB_RADIAL_SAMPLE_POINTS 8
+
+// ----------------------------------------------------------------------------------------------------- //
+
+///
+/// \struct StubDObject
+///
+/// \brief A stub dobject. For a RigidBody, the state is the velocities of each degree of 
+///     freedom followed by the positions (as for the prismatic joint in the joint damping 
+///     example), and force is the force accumulator.
+///
+
+struct StubDObject {
+    std::string name;
+    std::string type;
+    
+    size_t n_dof = 0;
+    size_t n_nodes = 0;
+    
+    double mass = 1;
+    double stiffness = 1;
+    double damping = 0;
+    double wave_amplitude = 0;
+    
+    std::vector<double> state;
+    std::vector<double> force;
+    
+    std::map<int, std::vector<double>> double_arrays;
+    std::map<int, std::vector<int>> int_arrays;
+    std::map<int, int> ints;
+    std::map<int, std::string> strings;
+};  /* StubDObject */
+
+
+///
+/// \struct StubSimulation
+///
+/// \brief A stub simulation. The mutex guards everything but the (immutable after 
+///     initialization) dobject layout.
+///
+
+struct StubSimulation {
+    std::mutex mutex;
+    
+    double time_s = 0;
+    bool file_output = true;
+    
+    std::vector<StubDObject> dobjects;
+    std::map<std::string, size_t> dobject_indices;
+    
+    std::string dobject_names;
+    std::string dobject_types;
+    std::string error_message;
+    
+    std::map<int, double> doubles;
+    std::map<int, std::vector<double>> double_arrays;
+    std::map<int, int> ints;
+    std::map<int, std::string> strings;
+};  /* StubSimulation */
+
+
+std::mutex stub_mutex;
+std::map<std::string, std::unique_ptr<StubSimulation>> stub_simulations;
+std::string stub_error_message;
+
+// ----------------------------------------------------------------------------------------------------- //
+
+
+
+// ----------------------------------------------------------------------------------------------------- //
+
+///
+/// \fn StubSimulation* FindSimulation(const std::string& unique_simulation_label)
+///
+/// \brief Looks up the given simulation (recording an error if there is no such simulation).
+///
+/// \param unique_simulation_label The API label for the target simulation.
+///
+/// \return Pointer to the simulation (or nullptr).
+///
+
+StubSimulation* FindSimulation(const std::string& unique_simulation_label)
+{
+    std::lock_guard<std::mutex> lock(stub_mutex);
+    auto simulation_iter = stub_simulations.find(unique_simulation_label);
+    
+    if (simulation_iter == stub_simulations.end()) {
+        stub_error_message = "no simulation labelled " + unique_simulation_label;
+        return nullptr;
+    }
+    
+    return simulation_iter->second.get();
+}   /* FindSimulation() */
+
+// ----------------------------------------------------------------------------------------------------- //
+
+
+
+// ----------------------------------------------------------------------------------------------------- //
+
+///
+/// \fn StubDObject* FindDObject(StubSimulation* simulation_ptr, const std::string& dobject_name)
+///
+/// \brief Looks up the given dobject (recording an error if there is no such dobject). Must
+///     be called with the simulation mutex held.
+///
+/// \param simulation_ptr Pointer to the target simulation.
+///
+/// \param dobject_name The dobject name.
+///
+/// \return Pointer to the dobject (or nullptr).
+///
+
+StubDObject* FindDObject(StubSimulation* simulation_ptr, const std::string& dobject_name)
+{
+    auto index_iter = simulation_ptr->dobject_indices.find(dobject_name);
+    
+    if (index_iter == simulation_ptr->dobject_indices.end()) {
+        simulation_ptr->error_message = "no dobject named " + dobject_name;
+        return nullptr;
+    }
+    
+    return &(simulation_ptr->dobjects[index_iter->second]);
+}   /* FindDObject() */
+
+// ----------------------------------------------------------------------------------------------------- //
+
+
+
+// ----------------------------------------------------------------------------------------------------- //
+
+///
+/// \fn void AddDObject(
+///         StubSimulation* simulation_ptr,
+///         const std::string& name,
+///         const std::string& type,
+///         size_t n_dof,
+///         size_t n_nodes
+///     )
+///
+/// \brief Adds a dobject to the given (initializing) simulation. Physical properties are 
+///     derived from the dobject index, so that every dobject moves differently.
+///
+/// \param simulation_ptr Pointer to the target simulation.
+///
+/// \param name The dobject name.
+///
+/// \param type The dobject type ("RigidBody" or "DCable").
+///
+/// \param n_dof The number of degrees of freedom (RigidBody).
+///
+/// \param n_nodes The number of nodes (DCable).
+///
+
+void AddDObject(
+    StubSimulation* simulation_ptr,
+    const std::string& name,
+    const std::string& type,
+    size_t n_dof,
+    size_t n_nodes
+)
+{
+    size_t index = simulation_ptr->dobjects.size();
+    
+    StubDObject dobject;
+    dobject.name = name;
+    dobject.type = type;
+    dobject.n_dof = n_dof;
+    dobject.n_nodes = n_nodes;
+    
+    dobject.mass = 1000 * (1 + 0.25 * index);
+    dobject.stiffness = 4000 * (1 + 0.5 * (index % 3));
+    dobject.damping = 200;
+    dobject.wave_amplitude = 2000 * (1 + 0.1 * index);
+    
+    dobject.state.assign(type == "DCable" ? 6 * n_nodes : 2 * n_dof, 0);
+    dobject.force.assign(n_dof, 0);
+    
+    simulation_ptr->dobject_indices[name] = index;
+    simulation_ptr->dobjects.push_back(dobject);
+    
+    simulation_ptr->dobject_names += name + ",";
+    simulation_ptr->dobject_types += type + ",";
+    
+    return;
+}   /* AddDObject() */
+
+// ----------------------------------------------------------------------------------------------------- //
+
+
+
+// ----------------------------------------------------------------------------------------------------- //
+
+///
+/// \fn void FillRamp(std::vector<double>& values, double offset)
+///
+/// \brief Fills the given vector with a cheap deterministic ramp (used for unmodelled array
+///     gets, so that the cost is that of writing the values, as for a copy).
+///
+/// \param values The vector to fill.
+///
+/// \param offset The ramp offset.
+///
+
+void FillRamp(std::vector<double>& values, double offset)
+{
+    for (size_t i = 0; i < values.size(); i++) {
+        values[i] = offset + 1e-3 * i;
+    }
+    
+    return;
+}   /* FillRamp() */
+
+// ----------------------------------------------------------------------------------------------------- //
+
+
+
+// ----------------------------------------------------------------------------------------------------- //
+
+///
+/// \fn bool GetCableField(
+///         const StubSimulation* simulation_ptr,
+///         const StubDObject* cable_ptr,
+///         int command,
+///         std::vector<double>& values
+///     )
+///
+/// \brief Fills the given vector with the given cable field (if modelled), as a function of 
+///     the simulation time. The cable hangs in a catenary-like sag that heaves with time.
+///
+/// \param simulation_ptr Pointer to the simulation.
+///
+/// \param cable_ptr Pointer to the cable.
+///
+/// \param command The cable field.
+///
+/// \param values The vector to fill.
+///
+/// \return true if the field is modelled, false otherwise.
+///
+
+bool GetCableField(
+    const StubSimulation* simulation_ptr,
+    const StubDObject* cable_ptr,
+    int command,
+    std::vector<double>& values
+)
+{
+    size_t n_nodes = cable_ptr->n_nodes;
+    double heave = 0.5 * sin(0.8 * simulation_ptr->time_s);
+    
+    size_t n_components = 1;
+    
+    switch (command) {
+        case (PDSAPI::PDSAPI::cablePositions):
+        case (PDSAPI::PDSAPI::cableVonMisesRGB):
+        case (PDSAPI::PDSAPI::cableTemperaturesRGB):
+            n_components = 3;
+            break;
+        
+        case (PDSAPI::PDSAPI::cableVonMisesStress):
+            n_components = STUB_RADIAL_SAMPLE_POINTS;
+            break;
+        
+        case (PDSAPI::PDSAPI::cableTensions):
+        case (PDSAPI::PDSAPI::cableBendingRadius):
+        case (PDSAPI::PDSAPI::cableFlexuralStress):
+        case (PDSAPI::PDSAPI::cableTemperatures):
+            break;
+        
+        default:
+            return false;
+    }
+    
+    size_t n_values = std::min(values.size(), n_nodes * n_components);
+    
+    for (size_t i = 0; i < n_values; i++) {
+        size_t node = i / n_components;
+        size_t component = i % n_components;
+        
+        double s = (n_nodes > 1) ? (double)node / (n_nodes - 1) : 0;
+        double sag = 4 * s * (1 - s);
+        
+        switch (command) {
+            case (PDSAPI::PDSAPI::cablePositions):
+                values[i] = (component == 0) ? 100 * s : (component == 1) ? 0 : -20 * sag + heave * s;
+                break;
+            
+            case (PDSAPI::PDSAPI::cableTensions):
+                values[i] = 1e5 * (1 + 0.5 * s) * (1 + 0.1 * heave);
+                break;
+            
+            case (PDSAPI::PDSAPI::cableBendingRadius):
+                values[i] = 50 + 10 * sag;
+                break;
+            
+            case (PDSAPI::PDSAPI::cableTemperatures):
+                values[i] = 10 + s;
+                break;
+            
+            default:
+                values[i] = 1e6 * (1 + s) * (1 + 0.01 * component) * (1 + 0.1 * heave);
+                break;
+        }
+    }
+    
+    return true;
+}   /* GetCableField() */
+
+// ----------------------------------------------------------------------------------------------------- //
+
+// ==== END Stub state ================================================================================= //
+
+
+
+// ==== API ============================================================================================ //
+
+bool ProteusDSAPI::InitializeProteusDS(
+    const std::string& unique_simulation_label,
+    const std::string& arguments,
+    bool /* print_to_console */,
+    bool /* print_to_file */
+)
+{
+    size_t n_extra_rigid_bodies = 0;
+    size_t n_cable_nodes = STUB_DEFAULT_CABLE_NODES;
+    
+    std::istringstream argument_stream(arguments);
+    std::string token;
+    
+    while (argument_stream >> token) {
+        if (token == "-stubRigidBodies") {
+            argument_stream >> n_extra_rigid_bodies;
+        }
+        
+        else if (token == "-stubCableNodes") {
+            argument_stream >> n_cable_nodes;
+        }
+        
+        else if (token == "-stubFail") {
+            std::lock_guard<std::mutex> lock(stub_mutex);
+            stub_error_message = "initialization failed (-stubFail)";
+            
+            return false;
+        }
+    }
+    
+    std::unique_ptr<StubSimulation> simulation(new StubSimulation());
+    
+    AddDObject(simulation.get(), "Float", "RigidBody", 6, 0);
+    AddDObject(simulation.get(), "base", "RigidBody", 6, 0);
+    AddDObject(simulation.get(), "cylinder", "RigidBody", 1, 0);
+    AddDObject(simulation.get(), "piston", "RigidBody", 1, 0);
+    AddDObject(simulation.get(), "cable", "DCable", 0, std::max(n_cable_nodes, (size_t)2));
+    
+    for (size_t i = 0; i < n_extra_rigid_bodies; i++) {
+        AddDObject(simulation.get(), "body" + std::to_string(i), "RigidBody", 6, 0);
+    }
+    
+    std::lock_guard<std::mutex> lock(stub_mutex);
+    
+    if (stub_simulations.count(unique_simulation_label) > 0) {
+        stub_error_message = "simulation label " + unique_simulation_label + " is already in use";
+        return false;
+    }
+    
+    stub_simulations[unique_simulation_label] = std::move(simulation);
+    
+    return true;
+}   /* InitializeProteusDS() */
+
+
+void ProteusDSAPI::Close(const std::string& unique_simulation_label)
+{
+    std::lock_guard<std::mutex> lock(stub_mutex);
+    stub_simulations.erase(unique_simulation_label);
+    
+    return;
+}   /* Close() */
+
+
+void ProteusDSAPI::AdvanceTime(const std::string& unique_simulation_label, double dt)
+{
+    StubSimulation* simulation_ptr = FindSimulation(unique_simulation_label);
+    
+    if (simulation_ptr == nullptr || dt <= 0) {
+        return;
+    }
+    
+    std::lock_guard<std::mutex> lock(simulation_ptr->mutex);
+    
+    size_t n_substeps = (size_t)ceil(dt / STUB_INTERNAL_TIME_STEP - 1e-9);
+    double h = dt / n_substeps;
+    
+    for (size_t step = 0; step < n_substeps; step++) {
+        double time_s = simulation_ptr->time_s + step * h;
+        
+        for (StubDObject& dobject : simulation_ptr->dobjects) {
+            for (size_t d = 0; d < dobject.n_dof; d++) {
+                double& velocity = dobject.state[d];
+                double& position = dobject.state[dobject.n_dof + d];
+                
+                double wave_force = dobject.wave_amplitude * sin(0.9 * time_s + 0.7 * d);
+                double acceleration = (
+                    dobject.force[d] + wave_force
+                    - dobject.stiffness * position
+                    - dobject.damping * velocity
+                ) / dobject.mass;
+                
+                velocity += acceleration * h;
+                position += velocity * h;
+            }
+        }
+    }
+    
+    simulation_ptr->time_s += dt;
+    
+    return;
+}   /* AdvanceTime() */
+
+
+void ProteusDSAPI::GetDoubleArray(
+    const std::string& unique_simulation_label,
+    int command,
+    const std::string& dobject_name,
+    std::vector<double>& values
+)
+{
+    StubSimulation* simulation_ptr = FindSimulation(unique_simulation_label);
+    
+    if (simulation_ptr == nullptr) {
+        return;
+    }
+    
+    std::lock_guard<std::mutex> lock(simulation_ptr->mutex);
+    
+    if (dobject_name.empty()) {
+        auto array_iter = simulation_ptr->double_arrays.find(command);
+        
+        if (array_iter != simulation_ptr->double_arrays.end()) {
+            size_t n_copy = std::min(values.size(), array_iter->second.size());
+            std::copy(array_iter->second.begin(), array_iter->second.begin() + n_copy, values.begin());
+        }
+        
+        else {
+            FillRamp(values, simulation_ptr->time_s);
+        }
+        
+        return;
+    }
+    
+    StubDObject* dobject_ptr = FindDObject(simulation_ptr, dobject_name);
+    
+    if (dobject_ptr == nullptr) {
+        return;
+    }
+    
+    const std::vector<double>* source_ptr = nullptr;
+    std::vector<double> derived;
+    
+    switch (command) {
+        case (PDSAPI::PDSAPI::state):
+            source_ptr = &(dobject_ptr->state);
+            break;
+        
+        case (PDSAPI::PDSAPI::rigidBodyPosition):
+            derived.assign(3, 0);
+            
+            for (size_t d = 0; d < std::min(dobject_ptr->n_dof, (size_t)3); d++) {
+                derived[d] = dobject_ptr->state[dobject_ptr->n_dof + d];
+            }
+            
+            source_ptr = &derived;
+            break;
+        
+        case (PDSAPI::PDSAPI::rigidBodyVelocityGlobal):
+        case (PDSAPI::PDSAPI::rigidBodyVelocityBody):
+            derived.assign(3, 0);
+            
+            for (size_t d = 0; d < std::min(dobject_ptr->n_dof, (size_t)3); d++) {
+                derived[d] = dobject_ptr->state[d];
+            }
+            
+            source_ptr = &derived;
+            break;
+        
+        default:
+            if (dobject_ptr->type == "DCable" && GetCableField(simulation_ptr, dobject_ptr, command, values)) {
+                return;
+            }
+            
+            auto array_iter = dobject_ptr->double_arrays.find(command);
+            
+            if (array_iter != dobject_ptr->double_arrays.end()) {
+                source_ptr = &(array_iter->second);
+            }
+            
+            break;
+    }
+    
+    if (source_ptr == nullptr) {
+        FillRamp(values, simulation_ptr->time_s);
+        return;
+    }
+    
+    size_t n_copy = std::min(values.size(), source_ptr->size());
+    std::copy(source_ptr->begin(), source_ptr->begin() + n_copy, values.begin());
+    
+    return;
+}   /* GetDoubleArray() */
+
+
+void ProteusDSAPI::GetDouble(
+    const std::string& unique_simulation_label,
+    int command,
+    const std::string& dobject_name,
+    double& value
+)
+{
+    StubSimulation* simulation_ptr = FindSimulation(unique_simulation_label);
+    
+    if (simulation_ptr == nullptr) {
+        return;
+    }
+    
+    std::lock_guard<std::mutex> lock(simulation_ptr->mutex);
+    
+    if (command == PDSAPI::PDSAPI::time) {
+        value = simulation_ptr->time_s;
+        return;
+    }
+    
+    if (dobject_name.empty()) {
+        auto double_iter = simulation_ptr->doubles.find(command);
+        value = (double_iter != simulation_ptr->doubles.end()) ? double_iter->second : 0;
+        
+        return;
+    }
+    
+    StubDObject* dobject_ptr = FindDObject(simulation_ptr, dobject_name);
+    
+    if (dobject_ptr == nullptr) {
+        return;
+    }
+    
+    auto array_iter = dobject_ptr->double_arrays.find(command);
+    
+    if (array_iter != dobject_ptr->double_arrays.end() && !array_iter->second.empty()) {
+        value = array_iter->second[0];
+    }
+    
+    else if (command == PDSAPI::PDSAPI::cableLength && dobject_ptr->type == "DCable") {
+        value = 100;
+    }
+    
+    else {
+        value = 0;
+    }
+    
+    return;
+}   /* GetDouble() */
+
+
+void ProteusDSAPI::GetIntArray(
+    const std::string& unique_simulation_label,
+    int command,
+    const std::string& dobject_name,
+    std::vector<int>& values
+)
+{
+    StubSimulation* simulation_ptr = FindSimulation(unique_simulation_label);
+    
+    if (simulation_ptr == nullptr) {
+        return;
+    }
+    
+    std::lock_guard<std::mutex> lock(simulation_ptr->mutex);
+    StubDObject* dobject_ptr = FindDObject(simulation_ptr, dobject_name);
+    
+    if (dobject_ptr == nullptr) {
+        return;
+    }
+    
+    auto array_iter = dobject_ptr->int_arrays.find(command);
+    
+    for (size_t i = 0; i < values.size(); i++) {
+        bool stored = array_iter != dobject_ptr->int_arrays.end() && i < array_iter->second.size();
+        values[i] = stored ? array_iter->second[i] : (int)i;
+    }
+    
+    return;
+}   /* GetIntArray() */
+
+
+void ProteusDSAPI::GetInt(
+    const std::string& unique_simulation_label,
+    int command,
+    const std::string& dobject_name,
+    int& value
+)
+{
+    StubSimulation* simulation_ptr = FindSimulation(unique_simulation_label);
+    
+    if (simulation_ptr == nullptr) {
+        return;
+    }
+    
+    std::lock_guard<std::mutex> lock(simulation_ptr->mutex);
+    
+    switch (command) {
+        case (PDSAPI::PDSAPI::numberOfDObjects):
+            value = (int)simulation_ptr->dobjects.size();
+            return;
+        
+        case (PDSAPI::PDSAPI::simulationRunning):
+            value = 1;
+            return;
+        
+        default:
+            break;
+    }
+    
+    if (dobject_name.empty()) {
+        auto int_iter = simulation_ptr->ints.find(command);
+        value = (int_iter != simulation_ptr->ints.end()) ? int_iter->second : 0;
+        
+        return;
+    }
+    
+    StubDObject* dobject_ptr = FindDObject(simulation_ptr, dobject_name);
+    
+    if (dobject_ptr == nullptr) {
+        return;
+    }
+    
+    int n_nodes = (int)dobject_ptr->n_nodes;
+    
+    switch (command) {
+        case (PDSAPI::PDSAPI::stateSize):
+            value = (int)dobject_ptr->state.size();
+            return;
+        
+        case (PDSAPI::PDSAPI::cableNumberOfNodes):
+        case (PDSAPI::PDSAPI::cablePositionsNumberOfSamplePoints):
+        case (PDSAPI::PDSAPI::cableTensionNumberOfSamplePoints):
+        case (PDSAPI::PDSAPI::cableBendingRadiusNumberOfSamplePoints):
+        case (PDSAPI::PDSAPI::cableVonMisesNumberOfSamplePoints):
+        case (PDSAPI::PDSAPI::cableFlexuralStressNumberOfSamplePoints):
+        case (PDSAPI::PDSAPI::cableTemperaturesNumberOfSamplePoints):
+            value = n_nodes;
+            return;
+        
+        case (PDSAPI::PDSAPI::cableNumberOfElements):
+            value = std::max(n_nodes - 1, 0);
+            return;
+        
+        case (PDSAPI::PDSAPI::cableVonMisesNumberOfRadialSamplePoints):
+            value = (dobject_ptr->type == "DCable") ? STUB_RADIAL_SAMPLE_POINTS : 0;
+            return;
+        
+        default:
+            break;
+    }
+    
+    auto int_iter = dobject_ptr->ints.find(command);
+    value = (int_iter != dobject_ptr->ints.end()) ? int_iter->second : 0;
+    
+    return;
+}   /* GetInt() */
+
+
+void ProteusDSAPI::GetString(
+    const std::string& unique_simulation_label,
+    int command,
+    const std::string& /* dobject_name */,
+    std::string& value
+)
+{
+    StubSimulation* simulation_ptr = FindSimulation(unique_simulation_label);
+    
+    if (simulation_ptr == nullptr) {
+        return;
+    }
+    
+    std::lock_guard<std::mutex> lock(simulation_ptr->mutex);
+    
+    switch (command) {
+        case (PDSAPI::PDSAPI::dObjectNames):
+            value = simulation_ptr->dobject_names;
+            return;
+        
+        case (PDSAPI::PDSAPI::dObjectTypes):
+            value = simulation_ptr->dobject_types;
+            return;
+        
+        case (PDSAPI::PDSAPI::version):
+            value = "stub";
+            return;
+        
+        case (PDSAPI::PDSAPI::licenseInfo):
+            value = "stub (no license required)";
+            return;
+        
+        default:
+            break;
+    }
+    
+    auto string_iter = simulation_ptr->strings.find(command);
+    value = (string_iter != simulation_ptr->strings.end()) ? string_iter->second : "";
+    
+    return;
+}   /* GetString() */
+
+
+void ProteusDSAPI::GetErrorMessage(const std::string& unique_simulation_label, std::string& error_message)
+{
+    StubSimulation* simulation_ptr = FindSimulation(unique_simulation_label);
+    
+    if (simulation_ptr == nullptr) {
+        std::lock_guard<std::mutex> lock(stub_mutex);
+        error_message = stub_error_message;
+        
+        return;
+    }
+    
+    std::lock_guard<std::mutex> lock(simulation_ptr->mutex);
+    error_message = simulation_ptr->error_message;
+    
+    return;
+}   /* GetErrorMessage() */
+
+
+void ProteusDSAPI::SetDoubleArray(
+    const std::string& unique_simulation_label,
+    int command,
+    const std::string& dobject_name,
+    const std::vector<double>& values
+)
+{
+    StubSimulation* simulation_ptr = FindSimulation(unique_simulation_label);
+    
+    if (simulation_ptr == nullptr) {
+        return;
+    }
+    
+    std::lock_guard<std::mutex> lock(simulation_ptr->mutex);
+    
+    if (dobject_name.empty()) {
+        simulation_ptr->double_arrays[command] = values;
+        return;
+    }
+    
+    StubDObject* dobject_ptr = FindDObject(simulation_ptr, dobject_name);
+    
+    if (dobject_ptr == nullptr) {
+        return;
+    }
+    
+    //  force accumulators take (force, dforce/dt) pairs; only the forces are integrated
+    size_t force_offset = 0;
+    size_t n_forces = 0;
+    
+    switch (command) {
+        case (PDSAPI::PDSAPI::state): {
+            size_t n_copy = std::min(values.size(), dobject_ptr->state.size());
+            std::copy(values.begin(), values.begin() + n_copy, dobject_ptr->state.begin());
+            
+            return;
+        }
+        
+        case (PDSAPI::PDSAPI::rigidBodyJointForceAndDeriv):
+            n_forces = 1;
+            break;
+        
+        case (PDSAPI::PDSAPI::rigidBodyForceAndDerivGlobal):
+        case (PDSAPI::PDSAPI::rigidBodyForceAndDerivBody):
+            n_forces = 3;
+            break;
+        
+        case (PDSAPI::PDSAPI::rigidBodyMomentAndDerivGlobal):
+        case (PDSAPI::PDSAPI::rigidBodyMomentAndDerivBody):
+            force_offset = 3;
+            n_forces = 3;
+            break;
+        
+        default:
+            dobject_ptr->double_arrays[command] = values;
+            return;
+    }
+    
+    for (size_t i = 0; i < n_forces && force_offset + i < dobject_ptr->n_dof && i < values.size(); i++) {
+        dobject_ptr->force[force_offset + i] += values[i];
+    }
+    
+    return;
+}   /* SetDoubleArray() */
+
+
+void ProteusDSAPI::SetDouble(
+    const std::string& unique_simulation_label,
+    int command,
+    const std::string& dobject_name,
+    double value
+)
+{
+    StubSimulation* simulation_ptr = FindSimulation(unique_simulation_label);
+    
+    if (simulation_ptr == nullptr) {
+        return;
+    }
+    
+    std::lock_guard<std::mutex> lock(simulation_ptr->mutex);
+    
+    if (command == PDSAPI::PDSAPI::time) {
+        simulation_ptr->time_s = value;
+        return;
+    }
+    
+    if (dobject_name.empty()) {
+        simulation_ptr->doubles[command] = value;
+        return;
+    }
+    
+    StubDObject* dobject_ptr = FindDObject(simulation_ptr, dobject_name);
+    
+    if (dobject_ptr != nullptr) {
+        dobject_ptr->double_arrays[command] = std::vector<double>(1, value);
+    }
+    
+    return;
+}   /* SetDouble() */
+
+
+void ProteusDSAPI::SetIntArray(
+    const std::string& unique_simulation_label,
+    int command,
+    const std::string& dobject_name,
+    const std::vector<int>& values
+)
+{
+    StubSimulation* simulation_ptr = FindSimulation(unique_simulation_label);
+    
+    if (simulation_ptr == nullptr) {
+        return;
+    }
+    
+    std::lock_guard<std::mutex> lock(simulation_ptr->mutex);
+    StubDObject* dobject_ptr = FindDObject(simulation_ptr, dobject_name);
+    
+    if (dobject_ptr != nullptr) {
+        dobject_ptr->int_arrays[command] = values;
+    }
+    
+    return;
+}   /* SetIntArray() */
+
+
+void ProteusDSAPI::SetInt(
+    const std::string& unique_simulation_label,
+    int command,
+    const std::string& dobject_name,
+    int value
+)
+{
+    StubSimulation* simulation_ptr = FindSimulation(unique_simulation_label);
+    
+    if (simulation_ptr == nullptr) {
+        return;
+    }
+    
+    std::lock_guard<std::mutex> lock(simulation_ptr->mutex);
+    
+    switch (command) {
+        case (PDSAPI::PDSAPI::fileOutputOn):
+            simulation_ptr->file_output = true;
+            return;
+        
+        case (PDSAPI::PDSAPI::fileOutputOff):
+            simulation_ptr->file_output = false;
+            return;
+        
+        default:
+            break;
+    }
+    
+    if (dobject_name.empty()) {
+        simulation_ptr->ints[command] = value;
+        return;
+    }
+    
+    StubDObject* dobject_ptr = FindDObject(simulation_ptr, dobject_name);
+    
+    if (dobject_ptr == nullptr) {
+        return;
+    }
+    
+    if (command == PDSAPI::PDSAPI::rigidBodyClearForcesMoments) {
+        std::fill(dobject_ptr->force.begin(), dobject_ptr->force.end(), 0);
+    }
+    
+    else {
+        dobject_ptr->ints[command] = value;
+    }
+    
+    return;
+}   /* SetInt() */
+
+
+void ProteusDSAPI::SetString(
+    const std::string& unique_simulation_label,
+    int command,
+    const std::string& dobject_name,
+    const std::string& value
+)
+{
+    StubSimulation* simulation_ptr = FindSimulation(unique_simulation_label);
+    
+    if (simulation_ptr == nullptr) {
+        return;
+    }
+    
+    std::lock_guard<std::mutex> lock(simulation_ptr->mutex);
+    
+    if (dobject_name.empty()) {
+        simulation_ptr->strings[command] = value;
+        return;
+    }
+    
+    StubDObject* dobject_ptr = FindDObject(simulation_ptr, dobject_name);
+    
+    if (dobject_ptr != nullptr) {
+        dobject_ptr->strings[command] = value;
+    }
+    
+    return;
+}   /* SetString() */
+
+
+void ProteusDSAPI::DisconnectCable(
+    const std::string& unique_simulation_label,
+    const std::string& cable_name,
+    int /* end */
+)
+{
+    StubSimulation* simulation_ptr = FindSimulation(unique_simulation_label);
+    
+    if (simulation_ptr != nullptr) {
+        std::lock_guard<std::mutex> lock(simulation_ptr->mutex);
+        FindDObject(simulation_ptr, cable_name);
+    }
+    
+    return;
+}   /* DisconnectCable() */
+
+
+void ProteusDSAPI::MakeDCableDCablePointConnection(
+    const std::string& unique_simulation_label,
+    const std::string& cable_name,
+    const std::string& target_cable_name,
+    double /* arclength */
+)
+{
+    StubSimulation* simulation_ptr = FindSimulation(unique_simulation_label);
+    
+    if (simulation_ptr != nullptr) {
+        std::lock_guard<std::mutex> lock(simulation_ptr->mutex);
+        FindDObject(simulation_ptr, cable_name);
+        FindDObject(simulation_ptr, target_cable_name);
+    }
+    
+    return;
+}   /* MakeDCableDCablePointConnection() */
+
+
+void ProteusDSAPI::SetCableEndNodeKinematicMode(
+    const std::string& unique_simulation_label,
+    const std::string& cable_name,
+    int /* end */,
+    bool /* kinematic */
+)
+{
+    StubSimulation* simulation_ptr = FindSimulation(unique_simulation_label);
+    
+    if (simulation_ptr != nullptr) {
+        std::lock_guard<std::mutex> lock(simulation_ptr->mutex);
+        FindDObject(simulation_ptr, cable_name);
+    }
+    
+    return;
+}   /* SetCableEndNodeKinematicMode() */
+
+// ==== END API ======================================================================================== //
@@ -0,0 +1,342 @@
+"""
+    Copyright 2023 - Anthony Truelove MASc, P.Eng.
+    
+    Redistribution and use in source and binary forms, with or without modification, are
+    permitted provided that the following conditions are met:
+    
+    1. Redistributions of source code must retain the above copyright notice, this list of
+    conditions and the following disclaimer.
+    
+    2. Redistributions in binary form must reproduce the above copyright notice, this list
+    of conditions and the following disclaimer in the documentation and/or other materials
+    provided with the distribution.
+    
+    3. Neither the name of the copyright holder nor the names of its contributors may be
+    used to endorse or promote products derived from this software without specific prior
+    written permission.
+    
+    THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS “AS IS” AND ANY
+    EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+    MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL
+    THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+    SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT
+    OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+    HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR
+    TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+    SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE. 
+"""
+
+"""
+    Anthony Truelove MASc, P.Eng.  
+    email:   wtruelove@uvic.ca
+    github:  gears1763-2 
+    
+    Benchmarks of the bindings, at the Python level (i.e., including pybind11 dispatch and 
+    conversion) and, if the `ProteusDSAPIBench` extension has been built, at the C++ level (see 
+    `BENCH_ProteusDSAPI.cpp`). Build both against the stub API first (see `setup_bench.py`), then
+    
+    >  python(3) bench_bindings.py --output results.json
+    
+    and, after making changes (and rebuilding),
+    
+    >  python(3) bench_bindings.py --baseline results.json
+    
+    which exits with a non-zero code if any benchmark's median time per call has regressed by more
+    than the given threshold (10% by default). Each benchmark is calibrated (to take at least 
+    --min-time per repetition) and then repeated --repetitions times at a fixed number of calls; 
+    the median is compared, since it is the least sensitive to noise. For the most comparable 
+    results, run on an otherwise idle machine, with frequency scaling disabled if possible.
+"""
+
+
+import argparse
+import json
+import os
+import platform
+import subprocess
+import sys
+import time
+import timeit
+
+import numpy as np
+
+sys.path.insert(0, os.path.dirname(os.path.abspath(__file__)))
+
+import ProteusDSAPI  # <-- the bindings, as built against the stub API by setup_bench.py
+
+try:
+    import ProteusDSAPIBench
+except ImportError:
+    ProteusDSAPIBench = None
+
+
+LABEL = "BenchPython"
+ARRAY_SIZES = [2, 10, 100, 1000, 10000, 100000, 1000000]
+
+
+def time_call(body, min_time, repetitions):
+    """
+        Calibrates and then times the given callable, returning (number of calls per 
+        repetition, list of ns per call, one per repetition).
+    """
+    
+    timer = timeit.Timer(body)
+    n_calls = 1
+    
+    while True:
+        elapsed = timer.timeit(n_calls)
+        
+        if elapsed >= min_time:
+            break
+        
+        multiplier = 1.4 * min_time / elapsed if elapsed > 0 else 10
+        n_calls = int(n_calls * min(max(multiplier, 2), 10))
+    
+    ns_per_call = [1e9 * timer.timeit(n_calls) / n_calls for _ in range(repetitions)]
+    
+    return n_calls, sorted(ns_per_call)
+
+
+def python_benchmarks(name_filter):
+    """
+        Returns a list of (name, callable, bytes per call) Python level benchmarks.
+    """
+    
+    PDSAPI = ProteusDSAPI.PDSAPI
+    array_command = PDSAPI.rigidBodyRelativeFluidVelocityProbes
+    
+    benchmarks = [
+        (
+            "GetDouble",
+            lambda: ProteusDSAPI.GetDouble(LABEL, PDSAPI.time, ""),
+            0
+        ),
+        (
+            "GetString/dObjectNames",
+            lambda: ProteusDSAPI.GetString(LABEL, PDSAPI.dObjectNames, ""),
+            0
+        ),
+        (
+            "GetDObjectNames",
+            lambda: ProteusDSAPI.GetDObjectNames(LABEL),
+            0
+        ),
+        (
+            "AdvanceTime",
+            lambda: ProteusDSAPI.AdvanceTime(LABEL, 1/60),
+            0
+        ),
+        (
+            "AdvanceTimeAsync",
+            lambda: ProteusDSAPI.AdvanceTimeAsync(LABEL, 1/60).result(),
+            0
+        )
+    ]
+    
+    for n_elements in ARRAY_SIZES:
+        array = np.ones(n_elements)
+        values_list = array.tolist()
+        n_bytes = 8 * n_elements
+        
+        benchmarks += [
+            (
+                "GetDoubleArray[list]/{}".format(n_elements),
+                lambda n=n_elements: ProteusDSAPI.GetDoubleArray(LABEL, array_command, "Float", n),
+                n_bytes
+            ),
+            (
+                "GetDoubleArray[numpy]/{}".format(n_elements),
+                lambda a=array: ProteusDSAPI.GetDoubleArray(LABEL, array_command, "Float", a),
+                n_bytes
+            ),
+            (
+                "SetDoubleArray[list]/{}".format(n_elements),
+                lambda v=values_list: ProteusDSAPI.SetDoubleArray(LABEL, array_command, "Float", v),
+                n_bytes
+            ),
+            (
+                "SetDoubleArray[numpy]/{}".format(n_elements),
+                lambda a=array: ProteusDSAPI.SetDoubleArray(LABEL, array_command, "Float", a),
+                n_bytes
+            )
+        ]
+    
+    # the joint damping example step, as written in JointDampingExample.py
+    joint_state_vec = np.zeros(2)
+    joint_force_vec = np.zeros(2)
+    
+    def joint_damping_step():
+        ProteusDSAPI.GetDoubleArray(LABEL, PDSAPI.state, "cylinder", joint_state_vec)
+        joint_force_vec[0] = -10000 * joint_state_vec[0]
+        ProteusDSAPI.SetInt(LABEL, PDSAPI.rigidBodyClearForcesMoments, "cylinder", 1)
+        ProteusDSAPI.SetDoubleArray(LABEL, PDSAPI.rigidBodyJointForceAndDeriv, "cylinder", joint_force_vec)
+        ProteusDSAPI.AdvanceTime(LABEL, 1/60)
+    
+    benchmarks.append(("JointDampingStep", joint_damping_step, 0))
+    
+    return [benchmark for benchmark in benchmarks if name_filter in benchmark[0]]
+
+
+def run_python_benchmarks(min_time, repetitions, name_filter):
+    """
+        Runs the Python level benchmarks against a fresh stub simulation.
+    """
+    
+    assert ProteusDSAPI.InitializeProteusDS(LABEL, "-stubRigidBodies 16", False, False)
+    ProteusDSAPI.AdvanceTime(LABEL, 0)
+    
+    results = []
+    
+    for name, body, n_bytes in python_benchmarks(name_filter):
+        n_calls, ns_per_call = time_call(body, min_time, repetitions)
+        ns_median = ns_per_call[len(ns_per_call) // 2]
+        
+        results.append(
+            {
+                "name": "python/" + name,
+                "iterations": n_calls,
+                "repetitions": repetitions,
+                "ns_min": ns_per_call[0],
+                "ns_median": ns_median,
+                "ns_mean": sum(ns_per_call) / len(ns_per_call),
+                "bytes_per_second": 1e9 * n_bytes / ns_median if n_bytes > 0 else 0.0
+            }
+        )
+        
+        print_result(results[-1])
+    
+    ProteusDSAPI.Close(LABEL)
+    
+    return results
+
+
+def run_cpp_benchmarks(min_time, repetitions, name_filter):
+    """
+        Runs the C++ level benchmarks (if built).
+    """
+    
+    if ProteusDSAPIBench is None:
+        print("(ProteusDSAPIBench not built, skipping C++ level benchmarks)")
+        return []
+    
+    results = ProteusDSAPIBench.RunBenchmarks(min_time, repetitions, name_filter)
+    
+    for result in results:
+        result["name"] = "cpp/" + result["name"]
+        print_result(result)
+    
+    return results
+
+
+def print_result(result):
+    throughput = ""
+    
+    if result["bytes_per_second"] > 0:
+        throughput = "{:10.2f} MB/s".format(1e-6 * result["bytes_per_second"])
+    
+    print(
+        "{:<44s}{:>14.1f} ns{:>14.1f} ns{:>12d}  {}".format(
+            result["name"],
+            result["ns_median"],
+            result["ns_min"],
+            result["iterations"],
+            throughput
+        )
+    )
+
+
+def metadata():
+    try:
+        git_revision = subprocess.check_output(
+            ["git", "rev-parse", "HEAD"],
+            cwd=os.path.dirname(os.path.abspath(__file__)),
+            stderr=subprocess.DEVNULL
+        ).decode().strip()
+    
+    except (OSError, subprocess.CalledProcessError):
+        git_revision = "unknown"
+    
+    return {
+        "timestamp": time.strftime("%Y-%m-%dT%H:%M:%S"),
+        "git_revision": git_revision,
+        "python": sys.version.split()[0],
+        "numpy": np.__version__,
+        "platform": platform.platform(),
+        "machine": platform.machine(),
+        "processor": platform.processor(),
+        "instrumented": bool(getattr(ProteusDSAPI, "INSTRUMENTED", False))
+    }
+
+
+def compare(results, baseline_path, threshold):
+    """
+        Compares the given results against a baseline, printing the ratio of median times and 
+        returning the number of regressions (ratio > 1 + threshold).
+    """
+    
+    with open(baseline_path, "r") as baseline_file:
+        baseline = json.load(baseline_file)
+    
+    if baseline["metadata"].get("instrumented") != metadata()["instrumented"]:
+        print("WARNING: comparing instrumented with uninstrumented results")
+    
+    baseline_medians = {result["name"]: result["ns_median"] for result in baseline["results"]}
+    n_regressions = 0
+    
+    print("\n{:<44s}{:>16s}{:>16s}{:>10s}".format("benchmark", "baseline", "current", "ratio"))
+    
+    for result in results:
+        if result["name"] not in baseline_medians:
+            continue
+        
+        ratio = result["ns_median"] / baseline_medians[result["name"]]
+        flag = ""
+        
+        if ratio > 1 + threshold:
+            flag = "  <-- REGRESSION"
+            n_regressions += 1
+        
+        elif ratio < 1 - threshold:
+            flag = "  <-- improvement"
+        
+        print(
+            "{:<44s}{:>13.1f} ns{:>13.1f} ns{:>10.3f}{}".format(
+                result["name"],
+                baseline_medians[result["name"]],
+                result["ns_median"],
+                ratio,
+                flag
+            )
+        )
+    
+    return n_regressions
+
+
+if __name__ == "__main__":
+    parser = argparse.ArgumentParser(description="Benchmarks of the ProteusDS API bindings (stub API).")
+    parser.add_argument("--min-time", type=float, default=0.1, help="minimum time per repetition [s]")
+    parser.add_argument("--repetitions", type=int, default=5, help="number of repetitions")
+    parser.add_argument("--filter", type=str, default="", help="only run benchmarks containing this")
+    parser.add_argument("--skip-python", action="store_true", help="skip the Python level benchmarks")
+    parser.add_argument("--skip-cpp", action="store_true", help="skip the C++ level benchmarks")
+    parser.add_argument("--output", type=str, default="", help="write results to this JSON file")
+    parser.add_argument("--baseline", type=str, default="", help="compare against this JSON file")
+    parser.add_argument("--threshold", type=float, default=0.1, help="regression threshold (ratio)")
+    args = parser.parse_args()
+    
+    print("{:<44s}{:>17s}{:>17s}{:>12s}".format("benchmark", "median", "min", "calls"))
+    
+    results = []
+    
+    if not args.skip_python:
+        results += run_python_benchmarks(args.min_time, args.repetitions, args.filter)
+    
+    if not args.skip_cpp:
+        results += run_cpp_benchmarks(args.min_time, args.repetitions, args.filter)
+    
+    if args.output:
+        with open(args.output, "w") as output_file:
+            json.dump({"metadata": metadata(), "results": results}, output_file, indent=4)
+    
+    if args.baseline:
+        sys.exit(1 if compare(results, args.baseline, args.threshold) > 0 else 0)
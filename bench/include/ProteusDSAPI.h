@@ -0,0 +1,277 @@
+/*
+ *  Copyright 2023 - Anthony Truelove MASc, P.Eng.
+ *
+ *  Redistribution and use in source and binary forms, with or without modification, are
+ *  permitted provided that the following conditions are met:
+ *
+ *  1. Redistributions of source code must retain the above copyright notice, this list of
+ *  conditions and the following disclaimer.
+ *
+ *  2. Redistributions in binary form must reproduce the above copyright notice, this list
+ *  of conditions and the following disclaimer in the documentation and/or other materials
+ *  provided with the distribution.
+ *
+ *  3. Neither the name of the copyright holder nor the names of its contributors may be
+ *  used to endorse or promote products derived from this software without specific prior
+ *  written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS “AS IS” AND ANY
+ *  EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ *  MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL
+ *  THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ *  SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT
+ *  OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ *  HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR
+ *  TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ *  SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE. 
+ */
+
+/*
+ *  Anthony Truelove MASc, P.Eng.  
+ *  email:   wtruelove@uvic.ca
+ *  github:  gears1763-2 
+ *
+ *  Header file for a local stub of the ProteusDS API, for building and benchmarking the bindings
+ *  without a licensed install (see setup_bench.py). The declarations mirror those of 
+ *  `.../ProteusDS/API/include/ProteusDSAPI.h`, but the dynamics are fake (if deterministic).
+ */
+
+
+///
+/// \file ProteusDSAPI.h
+///
+/// \brief Header file for a local stub of the ProteusDS API.
+///
+/// Header file for a local stub of the ProteusDS API. The declarations mirror those of the 
+/// real API, and the implementation (StubProteusDSAPI.cpp) provides deterministic fake 
+/// dynamics.
+///
+
+
+#ifndef PROTEUSDSAPI_STUB_H
+#define PROTEUSDSAPI_STUB_H
+
+
+#include <string>
+#include <vector>
+
+
+namespace PDSAPI {
+    
+    ///
+    /// \enum PDSAPI
+    ///
+    /// \brief The API commands (the stub does not depend on the values, only on the names).
+    ///
+    
+    enum PDSAPI {
+        // general parameters
+        state,
+        stateSize,
+        time,
+        simulationRunning,
+        licenseInfo,
+        fileOutputOn,
+        fileOutputOff,
+
+        // simulation parameters
+        numberOfDObjects,
+        dObjectNames,
+        dObjectTypes,
+        version,
+        outputRestartPath,
+
+        // environment parameters
+        environmentWaveReferenceHeight,
+        environmentWaveReferencePeriod,
+        environmentWaveReferenceHeading,
+        environmentWaveType,
+        environmentWaveSegments,
+        environmentWaveSeed,
+        environmentTransitionTime,
+        environmentTransitionRampTime,
+        environmentCurrentProfileDepth,
+        environmentCurrentProfileSpeed,
+        environmentCurrentProfileHeading,
+        environmentSeaHeight,
+
+        // cable parameters
+        cableTensions,
+        cableTensionNumberOfSamplePoints,
+        cableNumberOfElements,
+        cableNumberOfNodes,
+        cableBendingRadiusNumberOfSamplePoints,
+        cableBendingRadius,
+        cablePayoutSpeedNodeN,
+        cablePayoutSpeedNode0,
+        cablePositionNodeN,
+        cablePositionNode0,
+        cableVelocityNodeN,
+        cableVelocityNode0,
+        cableNodeNClamped,
+        cableP1NodeN,
+        cableP2NodeN,
+        cableNode0Clamped,
+        cableP1Node0,
+        cableP2Node0,
+        cableTanNode0,
+        cableTanNodeN,
+        cableVonMisesNumberOfSamplePoints,
+        cableTemperaturesNumberOfSamplePoints,
+        cableVonMisesStress,
+        cableVonMisesRGB,
+        cableVonMisesRGBMinStress,
+        cableVonMisesRGBMaxStress,
+        cableVonMisesNumberOfRadialSamplePoints,
+        cableTemperatures,
+        cableTemperaturesRGB,
+        cableTemperaturesRGBMinTemp,
+        cableTemperaturesRGBMaxTemp,
+        cablePositionsNumberOfSamplePoints,
+        cablePositions,
+        cableNode0ReactionLoad,
+        cableNodeNReactionLoad,
+        cableNode0AverageReactionLoad,
+        cableNodeNAverageReactionLoad,
+        cableFlexuralStressNumberOfSamplePoints,
+        cableFlexuralStress,
+        cableLength,
+
+        // rigid body parameters
+        rigidBodyPosition,
+        rigidBodyVelocityGlobal,
+        rigidBodyVelocityBody,
+        rigidBodyAccelerationGlobal,
+        rigidBodyAccelerationBody,
+        rigidBodyAngularAccelerationBody,
+        rigidBodyOrientation,
+        rigidBodyAngularVelocityBody,
+        rigidBodyMooringLoads,
+        rigidBodyForceKinControl,
+        rigidBodyState,
+        rigidBodyForceAndDerivGlobal,
+        rigidBodyForceAndDerivBody,
+        rigidBodyMomentAndDerivGlobal,
+        rigidBodyMomentAndDerivBody,
+        rigidBodyJointForceAndDeriv,
+        rigidBodyClearForcesMoments,
+        rigidBodyThrusterRPMSetpoint,
+        rigidBodyThrusterAzimuthSetpoint,
+
+        // set functions for RAO mode
+        rigidBodyRAOHeading,
+        rigidBodyRAOHeadingSpeedDegreesPerSecond,
+        rigidBodyRAOPositionNorth,
+        rigidBodyRAOPositionEast,
+        rigidBodyRAOSpeedNorth,
+        rigidBodyRAOSpeedEast,
+        rigidBodyRAOForwardSpeed,
+        rigidBodyRelativeFluidVelocityProbes,
+        rigidBodyAbsFluidVelocityProbes,
+
+        // DCable parameters
+        dCableMovementControllerSetPoint,
+        dCableMovementControllerMaxControlForce,
+        dCableMovementControllerOn,
+        dCableMovementControllerArclength,
+        dCableMovementControllerTargetVelocity,
+        dCableMovementControllerSetPointRelative,
+        dCableMovementControllerDCablePosition,
+        dCableMovementControllerVelocityControlOn
+    };  /* PDSAPI */
+    
+}   /* namespace PDSAPI */
+
+
+namespace ProteusDSAPI {
+    
+    bool InitializeProteusDS(
+        const std::string& unique_simulation_label,
+        const std::string& arguments,
+        bool print_to_console,
+        bool print_to_file
+    );
+    void Close(const std::string& unique_simulation_label);
+    void AdvanceTime(const std::string& unique_simulation_label, double dt);
+    
+    void GetDoubleArray(
+        const std::string& unique_simulation_label,
+        int command,
+        const std::string& dobject_name,
+        std::vector<double>& values
+    );
+    void GetDouble(
+        const std::string& unique_simulation_label,
+        int command,
+        const std::string& dobject_name,
+        double& value
+    );
+    void GetIntArray(
+        const std::string& unique_simulation_label,
+        int command,
+        const std::string& dobject_name,
+        std::vector<int>& values
+    );
+    void GetInt(
+        const std::string& unique_simulation_label,
+        int command,
+        const std::string& dobject_name,
+        int& value
+    );
+    void GetString(
+        const std::string& unique_simulation_label,
+        int command,
+        const std::string& dobject_name,
+        std::string& value
+    );
+    void GetErrorMessage(const std::string& unique_simulation_label, std::string& error_message);
+    
+    void SetDoubleArray(
+        const std::string& unique_simulation_label,
+        int command,
+        const std::string& dobject_name,
+        const std::vector<double>& values
+    );
+    void SetDouble(
+        const std::string& unique_simulation_label,
+        int command,
+        const std::string& dobject_name,
+        double value
+    );
+    void SetIntArray(
+        const std::string& unique_simulation_label,
+        int command,
+        const std::string& dobject_name,
+        const std::vector<int>& values
+    );
+    void SetInt(
+        const std::string& unique_simulation_label,
+        int command,
+        const std::string& dobject_name,
+        int value
+    );
+    void SetString(
+        const std::string& unique_simulation_label,
+        int command,
+        const std::string& dobject_name,
+        const std::string& value
+    );
+    
+    void DisconnectCable(const std::string& unique_simulation_label, const std::string& cable_name, int end);
+    void MakeDCableDCablePointConnection(
+        const std::string& unique_simulation_label,
+        const std::string& cable_name,
+        const std::string& target_cable_name,
+        double arclength
+    );
+    void SetCableEndNodeKinematicMode(
+        const std::string& unique_simulation_label,
+        const std::string& cable_name,
+        int end,
+        bool kinematic
+    );
+    
+}   /* namespace ProteusDSAPI */
+
+
+#endif  /* PROTEUSDSAPI_STUB_H */
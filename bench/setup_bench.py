@@ -0,0 +1,98 @@
+"""
+    Copyright 2023 - Anthony Truelove MASc, P.Eng.
+    
+    Redistribution and use in source and binary forms, with or without modification, are
+    permitted provided that the following conditions are met:
+    
+    1. Redistributions of source code must retain the above copyright notice, this list of
+    conditions and the following disclaimer.
+    
+    2. Redistributions in binary form must reproduce the above copyright notice, this list
+    of conditions and the following disclaimer in the documentation and/or other materials
+    provided with the distribution.
+    
+    3. Neither the name of the copyright holder nor the names of its contributors may be
+    used to endorse or promote products derived from this software without specific prior
+    written permission.
+    
+    THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS “AS IS” AND ANY
+    EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+    MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL
+    THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+    SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT
+    OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+    HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR
+    TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+    SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE. 
+"""
+
+"""
+    Anthony Truelove MASc, P.Eng.  
+    email:   wtruelove@uvic.ca
+    github:  gears1763-2 
+
+    A setup file for building the bindings (and the C++ level benchmarks) against a local stub of 
+    the ProteusDS API, so that they can be built and benchmarked without a licensed install (e.g., 
+    on Linux). To invoke, from this directory, simply
+    
+    >  python(3) setup_bench.py build_ext --inplace
+    
+    This builds two extensions in this directory: `ProteusDSAPI` (the bindings, exactly as built by
+    `../setup.py`, but linked against `StubProteusDSAPI.cpp`) and `ProteusDSAPIBench` (the C++ level
+    benchmarks). Then run `bench_bindings.py` (and `test_bindings.py`). As for `../setup.py`, set 
+    the environment variable PDSAPI_BINDINGS_INSTRUMENT=1 to build with per-call instrumentation 
+    (but note that this adds overhead to every call, so don't compare such results with 
+    uninstrumented ones).
+"""
+
+
+import os
+import shutil
+
+from setuptools import setup
+from pybind11.setup_helpers import Pybind11Extension
+
+
+# generate list of macro definitions (point the bindings at the stub API header)
+define_macros = [("PDSAPI_BINDINGS_API_HEADER", "\"ProteusDSAPI.h\"")]
+
+if os.environ.get("PDSAPI_BINDINGS_INSTRUMENT", "0") not in ("", "0"):
+    define_macros.append(("PDSAPI_BINDINGS_INSTRUMENT", "1"))
+
+
+# generate list of pybind11 extensions
+ext_modules = [
+    Pybind11Extension(
+        "ProteusDSAPI",
+        sources=["../PYBIND11_ProteusDSAPI.cpp", "StubProteusDSAPI.cpp"],
+        include_dirs=["include"],
+        define_macros=define_macros,
+        language="c++",
+        cxx_std=17
+    ),
+    Pybind11Extension(
+        "ProteusDSAPIBench",
+        sources=["BENCH_ProteusDSAPI.cpp", "StubProteusDSAPI.cpp"],
+        include_dirs=["include"],
+        define_macros=define_macros,
+        language="c++",
+        cxx_std=17
+    )
+]
+
+
+# set up extensions
+setup(
+    name="ProteusDSAPIBench",
+    ext_modules=ext_modules,
+    zip_safe=False,
+    python_requires=">=3.7",
+    install_requires=["setuptools>=42", "pybind11>=2.6.1", "numpy"]
+)
+
+
+# clean up
+for root, dirs, files in os.walk(os.getcwd()):
+    for name in dirs:
+        if "build" in name:
+            shutil.rmtree(name)
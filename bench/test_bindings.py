@@ -0,0 +1,355 @@
+"""
+    Copyright 2023 - Anthony Truelove MASc, P.Eng.
+    
+    Redistribution and use in source and binary forms, with or without modification, are
+    permitted provided that the following conditions are met:
+    
+    1. Redistributions of source code must retain the above copyright notice, this list of
+    conditions and the following disclaimer.
+    
+    2. Redistributions in binary form must reproduce the above copyright notice, this list
+    of conditions and the following disclaimer in the documentation and/or other materials
+    provided with the distribution.
+    
+    3. Neither the name of the copyright holder nor the names of its contributors may be
+    used to endorse or promote products derived from this software without specific prior
+    written permission.
+    
+    THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS “AS IS” AND ANY
+    EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+    MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL
+    THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+    SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT
+    OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+    HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR
+    TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+    SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE. 
+"""
+
+"""
+    Anthony Truelove MASc, P.Eng.  
+    email:   wtruelove@uvic.ca
+    github:  gears1763-2 
+    
+    Tests of the bindings against the stub API (see `StubProteusDSAPI.cpp`), comparing the batched
+    C++ paths with plain Python references. Build against the stub API first (see 
+    `setup_bench.py`), then
+    
+    >  python(3) test_bindings.py
+    
+    which exits with a non-zero code if any test fails (any unittest arguments, e.g. -v or a test
+    name, are passed through).
+"""
+
+
+import math
+import os
+import shutil
+import sys
+import tempfile
+import unittest
+from bisect import bisect_right
+
+import numpy as np
+
+sys.path.insert(0, os.path.dirname(os.path.abspath(__file__)))
+
+import ProteusDSAPI  # <-- the bindings, as built against the stub API by setup_bench.py
+from ProteusDSAPI import PDSAPI, JointForceLaw
+
+
+def reference_joint_force(law, x, c, coulomb_force, deadband, x_table, force_table):
+    """
+        Plain Python reference of a single joint's (F, dF/dx) under the given law. The lookup
+        table is clamped at (and beyond) its endpoints, with dF/dx = 0 there, and a NaN x falls
+        into the lower clamp.
+    """
+    
+    if law == JointForceLaw.LINEAR:
+        return -c * x, -c
+    
+    if law == JointForceLaw.QUADRATIC:
+        return -c * x * abs(x), -2 * c * abs(x)
+    
+    if law == JointForceLaw.COULOMB:
+        if abs(x) < deadband:
+            slope = coulomb_force / deadband
+            
+            return -(slope * x + c * x), -(slope + c)
+        
+        sign = 1 if x > 0 else (-1 if x < 0 else 0)
+        
+        return -(coulomb_force * sign + c * x), -c
+    
+    if math.isnan(x) or x <= x_table[0]:
+        return force_table[0], 0
+    
+    if x >= x_table[-1]:
+        return force_table[-1], 0
+    
+    j = bisect_right(x_table, x)
+    slope = (force_table[j] - force_table[j - 1]) / (x_table[j] - x_table[j - 1])
+    
+    return force_table[j - 1] + slope * (x - x_table[j - 1]), slope
+
+
+class TestJointForceBank(unittest.TestCase):
+    """
+        JointForceBank.evaluate() against reference_joint_force(), over an odd number of joints 
+        (so that both the two-wide SSE2 loop and its scalar remainder run), including a NaN x, 
+        zero deadbands, and x at (and beyond) the lookup table endpoints.
+    """
+    
+    LABEL = "TestJointForceBank"
+    N_JOINTS = 7
+    
+    X = [0.5, -1.25, float("nan"), 0.0, 0.05, -0.05, 3.0]
+    COEFFICIENTS = [100.0, 200.0, 300.0, 400.0, 500.0, 600.0, 700.0]
+    COULOMB_FORCES = [10.0, 20.0, 30.0, 40.0, 50.0, 60.0, 70.0]
+    DEADBANDS = [0.0, 0.5, 0.1, 0.0, 0.1, 0.0, 1.0]
+    
+    X_TABLE = [-2.0, -0.5, 0.0, 0.5, 2.0]
+    FORCE_TABLE = [400.0, 50.0, 0.0, -50.0, -400.0]
+    X_LOOKUP = [-2.0, 2.0, -0.5, 0.25, -3.0, 5.0, float("nan")]
+    
+    def setUp(self):
+        assert ProteusDSAPI.InitializeProteusDS(
+            self.LABEL,
+            "-stubRigidBodies " + str(self.N_JOINTS),
+            False,
+            False
+        )
+        
+        self.simulation = ProteusDSAPI.Simulation(self.LABEL)
+        self.joints = ["body" + str(i) for i in range(self.N_JOINTS)]
+    
+    def tearDown(self):
+        ProteusDSAPI.Close(self.LABEL)
+    
+    def assertMatchesReference(self, bank, law, x, **parameters):
+        force, dforce_dx = bank.evaluate(np.array(x))
+        
+        self.assertEqual(len(force), len(x))
+        self.assertEqual(len(dforce_dx), len(x))
+        
+        for i in range(len(x)):
+            expected_force, expected_dforce_dx = reference_joint_force(
+                law,
+                x[i],
+                parameters.get("coefficients", [0] * len(x))[i],
+                parameters.get("coulomb_forces", [0] * len(x))[i],
+                parameters.get("deadbands", [0] * len(x))[i],
+                parameters.get("x_table", []),
+                parameters.get("force_table", [])
+            )
+            
+            for value, expected_value in [(force[i], expected_force), (dforce_dx[i], expected_dforce_dx)]:
+                if math.isnan(expected_value):
+                    self.assertTrue(math.isnan(value), "joint {}: {} != nan".format(i, value))
+                
+                else:
+                    self.assertTrue(
+                        math.isclose(value, expected_value, rel_tol=1e-12, abs_tol=1e-12),
+                        "joint {}: {} != {}".format(i, value, expected_value)
+                    )
+    
+    def test_linear(self):
+        bank = ProteusDSAPI.JointForceBank(
+            self.simulation,
+            self.joints,
+            JointForceLaw.LINEAR,
+            coefficients=self.COEFFICIENTS
+        )
+        
+        self.assertMatchesReference(bank, JointForceLaw.LINEAR, self.X, coefficients=self.COEFFICIENTS)
+    
+    def test_quadratic(self):
+        bank = ProteusDSAPI.JointForceBank(
+            self.simulation,
+            self.joints,
+            JointForceLaw.QUADRATIC,
+            coefficients=self.COEFFICIENTS
+        )
+        
+        self.assertMatchesReference(bank, JointForceLaw.QUADRATIC, self.X, coefficients=self.COEFFICIENTS)
+    
+    def test_coulomb(self):
+        bank = ProteusDSAPI.JointForceBank(
+            self.simulation,
+            self.joints,
+            JointForceLaw.COULOMB,
+            coefficients=self.COEFFICIENTS,
+            coulomb_forces=self.COULOMB_FORCES,
+            deadbands=self.DEADBANDS
+        )
+        
+        self.assertMatchesReference(
+            bank,
+            JointForceLaw.COULOMB,
+            self.X,
+            coefficients=self.COEFFICIENTS,
+            coulomb_forces=self.COULOMB_FORCES,
+            deadbands=self.DEADBANDS
+        )
+    
+    def test_coulomb_zero_deadband(self):
+        bank = ProteusDSAPI.JointForceBank(
+            self.simulation,
+            self.joints,
+            JointForceLaw.COULOMB,
+            coefficients=self.COEFFICIENTS,
+            coulomb_forces=[25.0],
+            deadbands=[0.0]
+        )
+        
+        self.assertMatchesReference(
+            bank,
+            JointForceLaw.COULOMB,
+            self.X,
+            coefficients=self.COEFFICIENTS,
+            coulomb_forces=[25.0] * self.N_JOINTS,
+            deadbands=[0.0] * self.N_JOINTS
+        )
+    
+    def test_lookup(self):
+        bank = ProteusDSAPI.JointForceBank(
+            self.simulation,
+            self.joints,
+            JointForceLaw.LOOKUP,
+            x_table=self.X_TABLE,
+            force_table=self.FORCE_TABLE
+        )
+        
+        self.assertMatchesReference(
+            bank,
+            JointForceLaw.LOOKUP,
+            self.X_LOOKUP,
+            x_table=self.X_TABLE,
+            force_table=self.FORCE_TABLE
+        )
+
+
+class TestForcingStream(unittest.TestCase):
+    """
+        ForcingStream replaying what a Recorder wrote (and .npy files written by NumPy itself) 
+        into a fresh simulation, against the recorded values.
+    """
+    
+    LABEL = "TestForcingStream"
+    DT = 0.1
+    N_STEPS = 25
+    
+    #  not modelled by the stub, so stored on set and returned on get
+    COMMAND = PDSAPI.rigidBodyThrusterRPMSetpoint
+    
+    def setUp(self):
+        if not hasattr(ProteusDSAPI, "ForcingStream"):
+            self.skipTest("ForcingStream is not available on this platform")
+        
+        self.directory = tempfile.mkdtemp()
+        self.initialize()
+    
+    def tearDown(self):
+        ProteusDSAPI.Close(self.LABEL)
+        shutil.rmtree(self.directory, ignore_errors=True)
+    
+    def initialize(self):
+        assert ProteusDSAPI.InitializeProteusDS(self.LABEL, "", False, False)
+        
+        self.simulation = ProteusDSAPI.Simulation(self.LABEL)
+        self.cylinder = self.simulation.dobject("cylinder")
+    
+    def assertReplays(self, stream, times, rows, time_offset=0):
+        stream.time_offset = time_offset
+        
+        for k in range(len(times)):
+            ProteusDSAPI.AdvanceTime(self.LABEL, self.DT)
+            stream.apply()
+            
+            time = ProteusDSAPI.GetDouble(self.LABEL, PDSAPI.time, "")
+            expected = [np.interp(time + time_offset, times, rows[:, i]) for i in range(rows.shape[1])]
+            values = ProteusDSAPI.GetDoubleArray(self.LABEL, self.COMMAND, "cylinder", rows.shape[1])
+            
+            for value, expected_value in zip(values, expected):
+                self.assertTrue(
+                    math.isclose(value, expected_value, rel_tol=1e-12, abs_tol=1e-12),
+                    "t = {}: {} != {}".format(time, value, expected_value)
+                )
+    
+    def test_recorder_round_trip(self):
+        recorder = ProteusDSAPI.Recorder(
+            self.simulation,
+            [(self.cylinder, PDSAPI.state, 2)],
+            self.directory,
+            chunk_rows=8,
+            n_chunks=8
+        )
+        
+        times = []
+        rows = []
+        
+        for _ in range(self.N_STEPS):
+            ProteusDSAPI.AdvanceTime(self.LABEL, self.DT)
+            recorder.sample()
+            
+            times.append(ProteusDSAPI.GetDouble(self.LABEL, PDSAPI.time, ""))
+            rows.append(ProteusDSAPI.GetDoubleArray(self.LABEL, PDSAPI.state, "cylinder", 2))
+        
+        recorder.close()
+        
+        self.assertEqual(recorder.rows_written, self.N_STEPS)
+        self.assertEqual(recorder.rows_dropped, 0)
+        
+        times = np.array(times)
+        rows = np.array(rows)
+        
+        np.testing.assert_array_equal(np.load(os.path.join(self.directory, "time.npy")), times)
+        np.testing.assert_array_equal(np.load(os.path.join(self.directory, "channel_0.npy")), rows)
+        
+        #  replay into a fresh simulation, at the recorded times and then half way between them
+        for time_offset in [0, -self.DT / 2]:
+            ProteusDSAPI.Close(self.LABEL)
+            self.initialize()
+            
+            stream = ProteusDSAPI.ForcingStream(
+                self.simulation,
+                os.path.join(self.directory, "time.npy"),
+                [(self.cylinder, self.COMMAND, 2, os.path.join(self.directory, "channel_0.npy"))]
+            )
+            
+            self.assertEqual(stream.n_rows, self.N_STEPS)
+            self.assertReplays(stream, times, rows, time_offset)
+    
+    def test_npy_version_2(self):
+        times = np.arange(1, self.N_STEPS + 1) * self.DT
+        rows = np.column_stack([np.sin(times), np.cos(times), times])
+        
+        for name, array in [("time.npy", times), ("rows.npy", rows)]:
+            with open(os.path.join(self.directory, name), "wb") as npy_file:
+                np.lib.format.write_array(npy_file, array, version=(2, 0))
+        
+        with open(os.path.join(self.directory, "rows.npy"), "rb") as npy_file:
+            self.assertEqual(npy_file.read(8), b"\x93NUMPY\x02\x00")
+        
+        stream = ProteusDSAPI.ForcingStream(
+            self.simulation,
+            os.path.join(self.directory, "time.npy"),
+            [(self.cylinder, self.COMMAND, 3, os.path.join(self.directory, "rows.npy"))]
+        )
+        
+        self.assertReplays(stream, times, rows, time_offset=self.DT / 4)
+    
+    def test_npy_misaligned(self):
+        header = b"{'descr': '<f8', 'fortran_order': False, 'shape': (4,), }"
+        header += b" " * ((-(10 + len(header) + 1) % 64) + 4) + b"\n"
+        
+        with open(os.path.join(self.directory, "time.npy"), "wb") as npy_file:
+            npy_file.write(b"\x93NUMPY\x01\x00" + len(header).to_bytes(2, "little") + header)
+            npy_file.write(np.arange(4, dtype="<f8").tobytes())
+        
+        with self.assertRaises(ValueError):
+            ProteusDSAPI.ForcingStream(self.simulation, os.path.join(self.directory, "time.npy"), [])
+
+
+if __name__ == "__main__":
+    unittest.main()
@@ -59,6 +59,14 @@ from pybind11.setup_helpers import Pybind11Extension
 source_list = ["PYBIND11_ProteusDSAPI.cpp"]
 
 
+# generate list of macro definitions (set PDSAPI_BINDINGS_INSTRUMENT=1 to build with per-call
+# instrumentation)
+define_macros = []
+
+if os.environ.get("PDSAPI_BINDINGS_INSTRUMENT", "0") not in ("", "0"):
+    define_macros.append(("PDSAPI_BINDINGS_INSTRUMENT", "1"))
+
+
 # generate list of pybind11 extensions
 ext_modules = [
     Pybind11Extension(
@@ -66,6 +74,7 @@ ext_modules = [
         sources=source_list,
         libraries=["ProteusDSAPI-vc141-md-x64"],
         library_dirs=["../../lib"],
+        define_macros=define_macros,
         language="c++",
         cxx_std=17
     )